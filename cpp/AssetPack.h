@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace justcef::detail
+{
+
+// On-disk layout of an asset pack, written by BuildAssetPack and memory-mapped by justcefnative when a pack file is
+// mounted. All integers are little endian.
+//
+//   AssetPackHeader
+//   AssetPackEntry[entry_count]
+//   uint32 buckets[bucket_count]     open addressing on AssetPackHash(path), kAssetPackEmptyBucket when free
+//   strings                          paths (relative, '/' separated) and MIME types, not terminated
+//   blobs                            file contents, each variant aligned to kAssetPackAlignment
+//
+// Same layout as native/src/asset_pack.h.
+constexpr std::uint32_t kAssetPackMagic = 0x4B41504A; // "JPAK"
+constexpr std::uint32_t kAssetPackVersion = 1;
+constexpr std::uint32_t kAssetPackEmptyBucket = 0xFFFFFFFF;
+constexpr std::size_t kAssetPackAlignment = 16;
+
+enum class AssetEncoding : std::uint8_t
+{
+    Identity = 0,
+    Gzip = 1,
+    Brotli = 2
+};
+
+constexpr std::size_t kAssetEncodingCount = 3;
+
+struct AssetPackHeader
+{
+    std::uint32_t magic = kAssetPackMagic;
+    std::uint32_t version = kAssetPackVersion;
+    std::uint32_t entry_count = 0;
+    std::uint32_t bucket_count = 0;
+    std::uint64_t entries_offset = 0;
+    std::uint64_t buckets_offset = 0;
+    std::uint64_t strings_offset = 0;
+    std::uint64_t strings_size = 0;
+};
+
+struct AssetPackVariant
+{
+    // Absolute file offset, size 0 means the variant is absent. The identity variant is always present.
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+};
+
+struct AssetPackEntry
+{
+    std::uint64_t path_hash = 0;
+    std::uint32_t path_offset = 0;
+    std::uint32_t path_length = 0;
+    // mime_length is 0 when the extension is unknown.
+    std::uint32_t mime_offset = 0;
+    std::uint32_t mime_length = 0;
+    AssetPackVariant variants[kAssetEncodingCount];
+};
+
+static_assert(sizeof(AssetPackHeader) == 48, "AssetPackHeader layout changed");
+static_assert(sizeof(AssetPackEntry) == 72, "AssetPackEntry layout changed");
+
+// 64-bit FNV-1a of the relative path.
+constexpr std::uint64_t AssetPackHash(std::string_view path)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : path)
+    {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+} // namespace justcef::detail
@@ -0,0 +1,387 @@
+#include "AssetPackBuilder.h"
+
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef JUSTCEF_PACK_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef JUSTCEF_PACK_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace justcef
+{
+namespace
+{
+
+using detail::AssetEncoding;
+using detail::AssetPackEntry;
+using detail::AssetPackHeader;
+
+constexpr std::size_t kIdentity = static_cast<std::size_t>(AssetEncoding::Identity);
+constexpr std::size_t kGzip = static_cast<std::size_t>(AssetEncoding::Gzip);
+constexpr std::size_t kBrotli = static_cast<std::size_t>(AssetEncoding::Brotli);
+
+struct SourceAsset
+{
+    std::array<std::optional<std::filesystem::path>, detail::kAssetEncodingCount> files;
+};
+
+struct PackedAsset
+{
+    std::string path;
+    std::string mime_type;
+    std::array<std::vector<std::uint8_t>, detail::kAssetEncodingCount> variants;
+};
+
+std::string ToUtf8(const std::filesystem::path& path)
+{
+    const auto value = path.generic_u8string();
+    return std::string(value.begin(), value.end());
+}
+
+std::string LowercaseExtension(std::string_view path)
+{
+    const std::size_t slash = path.rfind('/');
+    const std::size_t dot = path.rfind('.');
+    if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash))
+    {
+        return {};
+    }
+
+    std::string extension(path.substr(dot + 1));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c); });
+    return extension;
+}
+
+// Same table justcefnative uses for mounted directories. Unknown extensions are stored empty so justcefnative falls back
+// to CefGetMimeType exactly as it does for a directory mount.
+std::string MimeTypeForPath(std::string_view path)
+{
+    static const std::pair<std::string_view, std::string_view> kMimeTypes[] = {
+        {"html", "text/html"},
+        {"htm", "text/html"},
+        {"js", "text/javascript"},
+        {"mjs", "text/javascript"},
+        {"css", "text/css"},
+        {"json", "application/json"},
+        {"map", "application/json"},
+        {"wasm", "application/wasm"},
+        {"svg", "image/svg+xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"avif", "image/avif"},
+        {"ico", "image/x-icon"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},
+        {"otf", "font/otf"},
+        {"txt", "text/plain"},
+        {"xml", "application/xml"},
+        {"mp4", "video/mp4"},
+        {"webm", "video/webm"},
+        {"mp3", "audio/mpeg"},
+        {"ogg", "audio/ogg"},
+        {"wav", "audio/wav"},
+        {"pdf", "application/pdf"},
+    };
+
+    const std::string extension = LowercaseExtension(path);
+    for (const auto& [name, mime_type] : kMimeTypes)
+    {
+        if (extension == name)
+        {
+            return std::string(mime_type);
+        }
+    }
+    return {};
+}
+
+// Images, fonts with their own compression and media gain nothing from another pass.
+bool IsCompressible(std::string_view mime_type)
+{
+    return mime_type.rfind("text/", 0) == 0 || mime_type == "application/json" || mime_type == "application/wasm" || mime_type == "application/xml" ||
+           mime_type == "image/svg+xml" || mime_type == "image/x-icon" || mime_type == "font/ttf" || mime_type == "font/otf";
+}
+
+std::vector<std::uint8_t> ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open " + ToUtf8(path) + ".");
+    }
+
+    std::vector<std::uint8_t> data(std::filesystem::file_size(path));
+    if (!data.empty() && !file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())))
+    {
+        throw std::runtime_error("Failed to read " + ToUtf8(path) + ".");
+    }
+    return data;
+}
+
+std::vector<std::uint8_t> CompressGzip([[maybe_unused]] const std::vector<std::uint8_t>& input)
+{
+#ifdef JUSTCEF_PACK_HAVE_ZLIB
+    z_stream stream{};
+    // 15 window bits + 16 selects the gzip wrapper.
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("deflateInit2 failed.");
+    }
+
+    std::vector<std::uint8_t> output(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = const_cast<Bytef*>(input.data());
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = output.data();
+    stream.avail_out = static_cast<uInt>(output.size());
+    const int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END)
+    {
+        throw std::runtime_error("deflate failed.");
+    }
+    return output;
+#else
+    return {};
+#endif
+}
+
+std::vector<std::uint8_t> CompressBrotli([[maybe_unused]] const std::vector<std::uint8_t>& input, [[maybe_unused]] bool text)
+{
+#ifdef JUSTCEF_PACK_HAVE_BROTLI
+    std::size_t size = BrotliEncoderMaxCompressedSize(input.size());
+    std::vector<std::uint8_t> output(size);
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, text ? BROTLI_MODE_TEXT : BROTLI_MODE_GENERIC, input.size(), input.data(), &size, output.data()))
+    {
+        throw std::runtime_error("BrotliEncoderCompress failed.");
+    }
+    output.resize(size);
+    return output;
+#else
+    return {};
+#endif
+}
+
+std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::map<std::string, SourceAsset> CollectSources(const std::filesystem::path& source_dir)
+{
+    std::map<std::string, std::filesystem::path> files;
+    for (const auto& item : std::filesystem::recursive_directory_iterator(source_dir))
+    {
+        if (item.is_regular_file())
+        {
+            files.emplace(ToUtf8(std::filesystem::relative(item.path(), source_dir)), item.path());
+        }
+    }
+
+    std::map<std::string, SourceAsset> sources;
+    for (const auto& [path, file] : files)
+    {
+        std::size_t encoding = kIdentity;
+        std::string base = path;
+        if (path.size() > 3 && (path.compare(path.size() - 3, 3, ".gz") == 0 || path.compare(path.size() - 3, 3, ".br") == 0))
+        {
+            // Only a sibling of a packed file is a variant, a lone archive is an asset of its own.
+            std::string stem = path.substr(0, path.size() - 3);
+            if (files.count(stem) != 0)
+            {
+                encoding = path.back() == 'z' ? kGzip : kBrotli;
+                base = std::move(stem);
+            }
+        }
+        sources[base].files[encoding] = file;
+    }
+    return sources;
+}
+
+PackedAsset PackAsset(const std::string& path, const SourceAsset& source, const AssetPackBuildOptions& options)
+{
+    PackedAsset asset;
+    asset.path = path;
+    asset.mime_type = MimeTypeForPath(path);
+    asset.variants[kIdentity] = ReadFile(*source.files[kIdentity]);
+
+    const std::vector<std::uint8_t>& identity = asset.variants[kIdentity];
+    const bool compress = identity.size() >= options.min_compress_size && IsCompressible(asset.mime_type);
+    for (std::size_t encoding : {kGzip, kBrotli})
+    {
+        std::vector<std::uint8_t>& variant = asset.variants[encoding];
+        if (source.files[encoding])
+        {
+            variant = ReadFile(*source.files[encoding]);
+        }
+        else if (compress && encoding == kGzip && options.gzip)
+        {
+            variant = CompressGzip(identity);
+        }
+        else if (compress && encoding == kBrotli && options.brotli)
+        {
+            variant = CompressBrotli(identity, asset.mime_type.rfind("text/", 0) == 0);
+        }
+
+        // A variant that does not save anything only costs the client a decode.
+        if (variant.size() >= identity.size())
+        {
+            variant.clear();
+        }
+    }
+    return asset;
+}
+
+} // namespace
+
+AssetPackBuildResult BuildAssetPack(const std::filesystem::path& source_dir, const std::filesystem::path& output_path, const AssetPackBuildOptions& options)
+{
+    if (!std::filesystem::is_directory(source_dir))
+    {
+        throw std::runtime_error(ToUtf8(source_dir) + " is not a directory.");
+    }
+
+    std::vector<PackedAsset> assets;
+    for (const auto& [path, source] : CollectSources(source_dir))
+    {
+        // Variants whose identity file is missing were already filtered out, so the identity is always present.
+        assets.push_back(PackAsset(path, source, options));
+    }
+    if (assets.size() >= detail::kAssetPackEmptyBucket / 2)
+    {
+        throw std::runtime_error("Too many assets in " + ToUtf8(source_dir) + ".");
+    }
+
+    AssetPackHeader header;
+    header.entry_count = static_cast<std::uint32_t>(assets.size());
+    header.bucket_count = 1;
+    // At most half full, which keeps probes short and leaves the free slot lookups rely on.
+    while (header.bucket_count < header.entry_count * 2)
+    {
+        header.bucket_count <<= 1;
+    }
+
+    std::vector<AssetPackEntry> entries(assets.size());
+    std::vector<std::uint32_t> buckets(header.bucket_count, detail::kAssetPackEmptyBucket);
+    std::string strings;
+    for (std::size_t i = 0; i < assets.size(); i++)
+    {
+        AssetPackEntry& entry = entries[i];
+        entry.path_hash = detail::AssetPackHash(assets[i].path);
+        entry.path_offset = static_cast<std::uint32_t>(strings.size());
+        entry.path_length = static_cast<std::uint32_t>(assets[i].path.size());
+        strings += assets[i].path;
+        entry.mime_offset = static_cast<std::uint32_t>(strings.size());
+        entry.mime_length = static_cast<std::uint32_t>(assets[i].mime_type.size());
+        strings += assets[i].mime_type;
+        if (strings.size() > UINT32_MAX)
+        {
+            throw std::runtime_error("Asset paths exceed the pack string table.");
+        }
+
+        const std::uint32_t mask = header.bucket_count - 1;
+        std::uint32_t slot = static_cast<std::uint32_t>(entry.path_hash) & mask;
+        while (buckets[slot] != detail::kAssetPackEmptyBucket)
+        {
+            slot = (slot + 1) & mask;
+        }
+        buckets[slot] = static_cast<std::uint32_t>(i);
+    }
+
+    header.entries_offset = sizeof(AssetPackHeader);
+    header.buckets_offset = header.entries_offset + entries.size() * sizeof(AssetPackEntry);
+    header.strings_offset = header.buckets_offset + buckets.size() * sizeof(std::uint32_t);
+    header.strings_size = strings.size();
+
+    AssetPackBuildResult result;
+    result.entry_count = header.entry_count;
+    std::uint64_t offset = header.strings_offset + header.strings_size;
+    for (std::size_t i = 0; i < assets.size(); i++)
+    {
+        result.identity_bytes += assets[i].variants[kIdentity].size();
+        for (std::size_t encoding = 0; encoding < detail::kAssetEncodingCount; encoding++)
+        {
+            const std::vector<std::uint8_t>& variant = assets[i].variants[encoding];
+            if (variant.empty())
+            {
+                continue;
+            }
+
+            offset = AlignUp(offset, detail::kAssetPackAlignment);
+            entries[i].variants[encoding] = {offset, variant.size()};
+            offset += variant.size();
+        }
+    }
+    result.pack_bytes = offset;
+
+    // Written next to the destination and renamed, so a running window never maps a half written pack.
+    std::filesystem::path temp_path = output_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            throw std::runtime_error("Failed to create " + ToUtf8(temp_path) + ".");
+        }
+
+        std::uint64_t written = 0;
+        auto write = [&](const void* data, std::size_t size) {
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        write(&header, sizeof(header));
+        write(entries.data(), entries.size() * sizeof(AssetPackEntry));
+        write(buckets.data(), buckets.size() * sizeof(std::uint32_t));
+        write(strings.data(), strings.size());
+
+        static const char kPadding[detail::kAssetPackAlignment] = {};
+        for (std::size_t i = 0; i < assets.size(); i++)
+        {
+            for (std::size_t encoding = 0; encoding < detail::kAssetEncodingCount; encoding++)
+            {
+                const std::vector<std::uint8_t>& variant = assets[i].variants[encoding];
+                if (variant.empty())
+                {
+                    continue;
+                }
+
+                write(kPadding, static_cast<std::size_t>(entries[i].variants[encoding].offset - written));
+                write(variant.data(), variant.size());
+            }
+        }
+
+        file.flush();
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write " + ToUtf8(temp_path) + ".");
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, output_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        throw std::runtime_error("Failed to replace " + ToUtf8(output_path) + ".");
+    }
+    return result;
+}
+
+} // namespace justcef
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace justcef
+{
+
+struct AssetPackBuildOptions
+{
+    // Compress text-like assets at build time. Ignored when the library was built without zlib / brotli.
+    bool gzip = true;
+    bool brotli = true;
+    // Smaller assets are stored as identity only.
+    std::size_t min_compress_size = 1024;
+};
+
+struct AssetPackBuildResult
+{
+    std::uint32_t entry_count = 0;
+    std::uint64_t identity_bytes = 0;
+    std::uint64_t pack_bytes = 0;
+};
+
+// Packs every file below source_dir into a single asset pack at output_path that JustCefWindow::MountAsync can
+// mount. Existing "x.gz" / "x.br" siblings of a file "x" are taken as its precompressed variants instead of being
+// packed on their own. Throws std::runtime_error on failure.
+AssetPackBuildResult BuildAssetPack(const std::filesystem::path& source_dir, const std::filesystem::path& output_path, const AssetPackBuildOptions& options = {});
+
+} // namespace justcef
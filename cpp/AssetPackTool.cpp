@@ -0,0 +1,58 @@
+#include "AssetPackBuilder.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// justcef-pack [--no-gzip] [--no-brotli] [--min-compress-size N] <source dir> <output pack>
+int main(int argc, char** argv)
+{
+    justcef::AssetPackBuildOptions options;
+    std::string positional[2];
+    int positional_count = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--no-gzip")
+        {
+            options.gzip = false;
+        }
+        else if (arg == "--no-brotli")
+        {
+            options.brotli = false;
+        }
+        else if (arg == "--min-compress-size" && i + 1 < argc)
+        {
+            options.min_compress_size = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (positional_count < 2 && !arg.empty() && arg[0] != '-')
+        {
+            positional[positional_count++] = std::string(arg);
+        }
+        else
+        {
+            positional_count = -1;
+            break;
+        }
+    }
+
+    if (positional_count != 2)
+    {
+        std::cerr << "usage: justcef-pack [--no-gzip] [--no-brotli] [--min-compress-size N] <source dir> <output pack>" << std::endl;
+        return 2;
+    }
+
+    try
+    {
+        const justcef::AssetPackBuildResult result = justcef::BuildAssetPack(positional[0], positional[1], options);
+        std::cout << "Packed " << result.entry_count << " assets, " << result.identity_bytes << " bytes into " << result.pack_bytes << " bytes." << std::endl;
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "justcef-pack: " << e.what() << std::endl;
+        return 1;
+    }
+}
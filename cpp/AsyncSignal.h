@@ -2,7 +2,9 @@
 
 #include <asio.hpp>
 
+#include <algorithm>
 #include <condition_variable>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <memory>
@@ -123,4 +125,102 @@ private:
     std::exception_ptr exception_;
 };
 
+// Byte credit shared between a sender coroutine and whoever receives grants. AcquireAsync waits until some
+// credit is available and takes up to the requested amount; once closed it completes with 0.
+class AsyncCredit
+{
+public:
+    explicit AsyncCredit(std::size_t initial) : available_(initial) {}
+
+    void Grant(std::size_t amount)
+    {
+        std::vector<std::pair<std::size_t, Grantee>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_)
+            {
+                return;
+            }
+
+            available_ += amount;
+            while (!waiters_.empty() && available_ > 0)
+            {
+                auto& [wanted, grantee] = waiters_.front();
+                const std::size_t taken = std::min(wanted, available_);
+                available_ -= taken;
+                ready.emplace_back(taken, std::move(grantee));
+                waiters_.erase(waiters_.begin());
+            }
+        }
+
+        for (auto& [taken, grantee] : ready)
+        {
+            grantee(taken);
+        }
+    }
+
+    void Close()
+    {
+        std::vector<std::pair<std::size_t, Grantee>> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            waiters.swap(waiters_);
+        }
+
+        for (auto& [_, grantee] : waiters)
+        {
+            grantee(0);
+        }
+    }
+
+    asio::awaitable<std::size_t> AcquireAsync(std::size_t wanted, const asio::any_io_executor& fallback_executor)
+    {
+        co_return co_await asio::async_initiate<decltype(asio::use_awaitable), void(std::size_t)>(
+            [this, wanted, fallback_executor](auto handler) mutable
+            {
+                using Handler = std::decay_t<decltype(handler)>;
+
+                auto handler_ptr = std::make_shared<Handler>(std::move(handler));
+                auto handler_executor = asio::get_associated_executor(*handler_ptr, fallback_executor);
+                Grantee grantee = [handler_ptr, handler_executor](std::size_t taken) mutable
+                {
+                    asio::dispatch(handler_executor,
+                                   [handler_ptr, taken]() mutable
+                                   {
+                                       auto completion_handler = std::move(*handler_ptr);
+                                       completion_handler(taken);
+                                   });
+                };
+
+                std::size_t taken = 0;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!closed_ && available_ == 0)
+                    {
+                        waiters_.emplace_back(wanted, std::move(grantee));
+                        return;
+                    }
+
+                    if (!closed_)
+                    {
+                        taken = std::min(wanted, available_);
+                        available_ -= taken;
+                    }
+                }
+
+                grantee(taken);
+            },
+            asio::use_awaitable);
+    }
+
+private:
+    using Grantee = std::function<void(std::size_t)>;
+
+    std::mutex mutex_;
+    std::vector<std::pair<std::size_t, Grantee>> waiters_;
+    std::size_t available_ = 0;
+    bool closed_ = false;
+};
+
 } // namespace justcef::detail
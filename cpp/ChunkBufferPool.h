@@ -0,0 +1,119 @@
+#pragma once
+
+#include "StreamChunkSizer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace justcef::detail
+{
+
+// Process-wide pool of stream chunk buffers in the StreamChunkSizer classes. A buffer goes back to its class when
+// its handle is dropped and every class keeps at most kMaxFreePerClass idle buffers. Requests above the largest class
+// are allocated and freed directly.
+class ChunkBufferPool
+{
+public:
+    static constexpr std::size_t kClassCount = 4;
+    static constexpr std::size_t kMaxFreePerClass = 8;
+
+    class Buffer
+    {
+    public:
+        Buffer() = default;
+        Buffer(Buffer&& other) noexcept : data_(std::move(other.data_)), capacity_(std::exchange(other.capacity_, 0)), class_index_(other.class_index_) {}
+        Buffer& operator=(Buffer&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Release();
+                data_ = std::move(other.data_);
+                capacity_ = std::exchange(other.capacity_, 0);
+                class_index_ = other.class_index_;
+            }
+            return *this;
+        }
+        ~Buffer() { Release(); }
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        std::uint8_t* data() const { return data_.get(); }
+        std::size_t capacity() const { return capacity_; }
+
+    private:
+        friend class ChunkBufferPool;
+
+        Buffer(std::unique_ptr<std::uint8_t[]> data, std::size_t capacity, std::size_t class_index) : data_(std::move(data)), capacity_(capacity), class_index_(class_index) {}
+
+        void Release()
+        {
+            if (data_ && class_index_ < kClassCount)
+            {
+                Global().Return(class_index_, std::move(data_));
+            }
+            data_.reset();
+            capacity_ = 0;
+        }
+
+        std::unique_ptr<std::uint8_t[]> data_;
+        std::size_t capacity_ = 0;
+        std::size_t class_index_ = kClassCount;
+    };
+
+    static ChunkBufferPool& Global()
+    {
+        static ChunkBufferPool pool;
+        return pool;
+    }
+
+    // The buffer holds at least size bytes.
+    Buffer Acquire(std::size_t size)
+    {
+        std::size_t class_index = 0;
+        std::size_t class_size = StreamChunkSizer::kMinChunkClass;
+        while (class_index < kClassCount && class_size < size)
+        {
+            ++class_index;
+            class_size *= StreamChunkSizer::kChunkClassStep;
+        }
+
+        if (class_index >= kClassCount)
+        {
+            return Buffer(std::unique_ptr<std::uint8_t[]>(new std::uint8_t[size]), size, kClassCount);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& free = free_[class_index];
+            if (!free.empty())
+            {
+                Buffer buffer(std::move(free.back()), class_size, class_index);
+                free.pop_back();
+                return buffer;
+            }
+        }
+        return Buffer(std::unique_ptr<std::uint8_t[]>(new std::uint8_t[class_size]), class_size, class_index);
+    }
+
+private:
+    void Return(std::size_t class_index, std::unique_ptr<std::uint8_t[]> data)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& free = free_[class_index];
+        if (free.size() < kMaxFreePerClass)
+        {
+            free.push_back(std::move(data));
+        }
+    }
+
+    std::mutex mutex_;
+    std::array<std::vector<std::unique_ptr<std::uint8_t[]>>, kClassCount> free_;
+};
+
+} // namespace justcef::detail
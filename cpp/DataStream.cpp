@@ -1,12 +1,151 @@
 #include "DataStream.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 
-DataStream::DataStream(uint32_t identifier, size_t bufferSize) : _identifier(identifier), _buffer(bufferSize), _capacity(bufferSize)
+namespace
 {
+
+std::array<std::atomic<size_t>, static_cast<size_t>(DataStreamKind::Count)> g_kindMaxCapacity = {
+    DataStream::kDefaultMaxCapacity, DataStream::kDefaultMaxCapacity, DataStream::kDefaultMaxCapacity, DataStream::kDefaultMaxCapacity};
+
+} // namespace
+
+StreamMemoryBudget& StreamMemoryBudget::Global()
+{
+    static StreamMemoryBudget budget;
+    return budget;
+}
+
+void StreamMemoryBudget::SetLimit(size_t limit)
+{
+    if (limit == 0)
+        return;
+
+    _limit.store(limit);
+    WakeWaiters();
+}
+
+size_t StreamMemoryBudget::TryAcquire(size_t wanted, bool force)
+{
+    size_t current = _current.load();
+    size_t granted;
+    do
+    {
+        size_t limit = _limit.load();
+        granted = force ? wanted : std::min(wanted, current < limit ? limit - current : 0);
+        if (granted == 0)
+            return 0;
+    } while (!_current.compare_exchange_weak(current, current + granted));
+
+    size_t peak = _peak.load();
+    while (current + granted > peak && !_peak.compare_exchange_weak(peak, current + granted))
+    {
+    }
+    return granted;
+}
+
+void StreamMemoryBudget::Release(size_t bytes)
+{
+    if (bytes == 0)
+        return;
+
+    _current.fetch_sub(bytes);
+    if (_waiterCount.load() == 0)
+        return;
+
+    WakeWaiters();
+}
+
+void StreamMemoryBudget::WakeWaiters()
+{
+    std::vector<std::function<void()>> waiters;
+    std::function<void(std::function<void()>)> executor;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        waiters.swap(_waiters);
+        executor = _waiterExecutor;
+        _cvSpace.notify_all();
+    }
+    for (auto& waiter : waiters)
+    {
+        if (executor)
+            executor(std::move(waiter));
+        else
+            waiter();
+    }
+}
+
+void StreamMemoryBudget::WaitForSpace(const std::function<bool()>& abandon)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    // Counted before the check so a concurrent Release either wakes us or we see its bytes.
+    _waiterCount.fetch_add(1);
+    _cvSpace.wait(lock,
+                  [&]
+                  {
+                      return !Exhausted() || abandon();
+                  });
+    _waiterCount.fetch_sub(1);
+}
+
+bool StreamMemoryBudget::RegisterWaiter(std::function<void()>&& waiter)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _waiterCount.fetch_add(1);
+    if (!Exhausted())
+    {
+        _waiterCount.fetch_sub(1);
+        return false;
+    }
+
+    _waiters.push_back([this, waiter = std::move(waiter)]()
+                       {
+                           _waiterCount.fetch_sub(1);
+                           waiter();
+                       });
+    return true;
+}
+
+void StreamMemoryBudget::SetWaiterExecutor(std::function<void(std::function<void()>)> executor)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _waiterExecutor = std::move(executor);
+}
+
+StreamMemoryBudget::Stats StreamMemoryBudget::GetStats() const
+{
+    Stats stats;
+    stats.limit = _limit.load();
+    stats.current = _current.load();
+    stats.peak = _peak.load();
+    return stats;
+}
+
+void DataStream::SetKindMaxCapacity(DataStreamKind kind, size_t maxCapacity)
+{
+    if (kind < DataStreamKind::Count && maxCapacity > 0)
+        g_kindMaxCapacity[static_cast<size_t>(kind)].store(maxCapacity);
+}
+
+size_t DataStream::KindMaxCapacity(DataStreamKind kind)
+{
+    if (kind >= DataStreamKind::Count)
+        kind = DataStreamKind::Generic;
+    return g_kindMaxCapacity[static_cast<size_t>(kind)].load();
 }
 
-void DataStream::Write(const uint8_t* data, size_t length)
+DataStream::DataStream(uint32_t identifier, size_t maxCapacity) : _identifier(identifier), _maxCapacity(std::max<size_t>(maxCapacity, 1))
+{
+}
+
+DataStream::~DataStream()
+{
+    StreamMemoryBudget::Global().Release(_size);
+}
+
+void DataStream::Write(const uint8_t* data, size_t length, bool credited)
 {
     std::unique_lock<std::mutex> lock(_mutex);
 
@@ -21,8 +160,22 @@ void DataStream::Write(const uint8_t* data, size_t length)
         if (_isClosed)
             break;
 
-        size_t spaceAvailable = _capacity - _size;
-        size_t writeLength = std::min(spaceAvailable, length - offset);
+        reserveLocked(length - offset);
+
+        size_t spaceAvailable = std::min(_capacity, _maxCapacity) - _size;
+        size_t writeLength = StreamMemoryBudget::Global().TryAcquire(std::min(spaceAvailable, length - offset), credited || isEmpty());
+        if (writeLength == 0)
+        {
+            // The reader of this stream frees budget too, so it must be able to run while we wait.
+            lock.unlock();
+            StreamMemoryBudget::Global().WaitForSpace(
+                [this]
+                {
+                    return _isClosed.load() || _readerWaiting.load();
+                });
+            lock.lock();
+            continue;
+        }
         size_t firstPart = std::min(writeLength, _capacity - _tail);
 
         std::copy_n(data + offset, firstPart, _buffer.begin() + _tail);
@@ -40,6 +193,8 @@ void DataStream::Write(const uint8_t* data, size_t length)
             _size += secondPart;
         }
 
+        _peakSize = std::max(_peakSize, _size);
+        _readerWaiting = false;
         _cvRead.notify_all();
     }
 }
@@ -48,14 +203,34 @@ size_t DataStream::Read(uint8_t* buffer, size_t bufferSize)
 {
     std::unique_lock<std::mutex> lock(_mutex);
     size_t bytesRead = 0;
+    size_t bytesReported = 0;
 
     while (bytesRead < bufferSize)
     {
+        // Hand back budget and credit before blocking on more data, the writer may be waiting for exactly that.
+        if (isEmpty() && !_isClosed && bytesRead > bytesReported)
+        {
+            lock.unlock();
+            reportConsumed(bytesRead - bytesReported, 0);
+            lock.lock();
+            bytesReported = bytesRead;
+            continue;
+        }
+
+        if (isEmpty() && !_isClosed)
+        {
+            // A writer parked on the memory budget may write into an empty stream, let it know it is needed.
+            _readerWaiting = true;
+            lock.unlock();
+            StreamMemoryBudget::Global().WakeWaiters();
+            lock.lock();
+        }
         _cvRead.wait(lock,
                      [this]
                      {
                          return !isEmpty() || _isClosed;
                      });
+        _readerWaiting = false;
         if (isEmpty() && _isClosed)
             break;
 
@@ -77,19 +252,102 @@ size_t DataStream::Read(uint8_t* buffer, size_t bufferSize)
             _size -= secondPart;
         }
 
+        shrinkIfDrainedLocked();
         _cvWrite.notify_all();
 
         if (!isEmpty())
             break;
     }
 
+    size_t buffered = _size;
+    lock.unlock();
+    reportConsumed(bytesRead - bytesReported, buffered);
+
     return bytesRead;
 }
 
+void DataStream::reportConsumed(size_t consumed, size_t buffered)
+{
+    if (consumed == 0)
+        return;
+
+    StreamMemoryBudget::Global().Release(consumed);
+    if (_consumeListener)
+        _consumeListener(consumed, buffered);
+}
+
 void DataStream::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isClosed = true;
+        shrinkIfDrainedLocked();
+        _cvRead.notify_all();
+        _cvWrite.notify_all();
+    }
+    StreamMemoryBudget::Global().WakeWaiters();
+}
+
+size_t DataStream::AllocatedBytes()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity;
+}
+
+void DataStream::SetMaxCapacity(size_t maxCapacity)
 {
     std::lock_guard<std::mutex> lock(_mutex);
-    _isClosed = true;
-    _cvRead.notify_all();
+    _maxCapacity = std::max<size_t>(maxCapacity, 1);
     _cvWrite.notify_all();
 }
+
+void DataStream::reserveLocked(size_t length)
+{
+    size_t required = std::min(_size + length, _maxCapacity);
+    if (required <= _capacity)
+        return;
+
+    size_t capacity = std::max(_capacity, kInitialCapacity);
+    while (capacity < required)
+        capacity *= 2;
+    reallocateLocked(std::min(capacity, std::max(_maxCapacity, _capacity)));
+}
+
+void DataStream::reallocateLocked(size_t capacity)
+{
+    std::vector<uint8_t> buffer(capacity);
+    if (_size > 0)
+    {
+        size_t firstPart = std::min(_size, _capacity - _head);
+        std::copy_n(_buffer.begin() + _head, firstPart, buffer.begin());
+        std::copy_n(_buffer.begin(), _size - firstPart, buffer.begin() + firstPart);
+    }
+
+    _buffer.swap(buffer);
+    _capacity = capacity;
+    _head = 0;
+    _tail = capacity > 0 ? _size % capacity : 0;
+    _peakSize = _size;
+}
+
+void DataStream::shrinkIfDrainedLocked()
+{
+    if (_size != 0 || _capacity == 0)
+        return;
+
+    if (_isClosed)
+    {
+        std::vector<uint8_t>().swap(_buffer);
+        _capacity = 0;
+        _head = _tail = 0;
+        _peakSize = 0;
+        return;
+    }
+
+    // Halve while the last fill stayed under a quarter of the buffer, so a burst does not pin its peak forever.
+    if (_capacity > kInitialCapacity && _peakSize * 4 <= _capacity)
+        reallocateLocked(std::max(kInitialCapacity, _capacity / 2));
+    else
+        _head = _tail = 0;
+    _peakSize = 0;
+}
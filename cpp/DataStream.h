@@ -1,21 +1,97 @@
 #ifndef DATASTREAM_H
 #define DATASTREAM_H
 
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <mutex>
 #include <vector>
 
+// What an incoming stream carries, each kind has its own buffer limit.
+enum class DataStreamKind : uint8_t
+{
+    Generic = 0,
+    RequestBody = 1,
+    BridgePayload = 2,
+    BinaryPayload = 3,
+    Count = 4
+};
+
+// Process-wide limit on the bytes buffered in DataStreams. Plain writes block while it is exhausted, except into
+// an empty stream, so a reader waiting on one stream is never starved by data buffered for others.
+class StreamMemoryBudget
+{
+public:
+    struct Stats
+    {
+        size_t limit = 0;
+        size_t current = 0;
+        size_t peak = 0;
+    };
+
+    static constexpr size_t kDefaultLimit = 128 * 1024 * 1024;
+
+    static StreamMemoryBudget& Global();
+
+    // Set from StartOptions, 0 keeps the current limit.
+    void SetLimit(size_t limit);
+    bool Exhausted() const { return _current.load() >= _limit.load(); }
+    // Takes up to wanted bytes, all of them when force is set.
+    size_t TryAcquire(size_t wanted, bool force);
+    void Release(size_t bytes);
+    // Blocks until the budget has room or abandon returns true.
+    void WaitForSpace(const std::function<bool()>& abandon);
+    // Wakes blocked writers so they re-check their abandon condition.
+    void WakeWaiters();
+    // Registers waiter to run once bytes are released. Returns false and leaves waiter untouched when the budget
+    // is not exhausted right now.
+    bool RegisterWaiter(std::function<void()>&& waiter);
+    // Registered waiters are handed to executor, so a reader releasing bytes never runs another stream's producer on
+    // its own thread. Without one they run inline.
+    void SetWaiterExecutor(std::function<void(std::function<void()>)> executor);
+    Stats GetStats() const;
+
+private:
+    std::atomic<size_t> _limit = kDefaultLimit;
+    std::atomic<size_t> _current = 0;
+    std::atomic<size_t> _peak = 0;
+    std::atomic<size_t> _waiterCount = 0;
+    std::mutex _mutex;
+    std::condition_variable _cvSpace;
+    std::vector<std::function<void()>> _waiters;
+    std::function<void(std::function<void()>)> _waiterExecutor;
+};
+
+// The ring buffer starts unallocated and grows by doubling up to the maximum capacity. Once drained, an
+// oversized buffer is halved and a closed stream releases it entirely.
 class DataStream
 {
 public:
-    DataStream(uint32_t identifier, size_t bufferSize = 10 * 1024 * 1024);
+    static constexpr size_t kInitialCapacity = 16 * 1024;
+    static constexpr size_t kDefaultMaxCapacity = 10 * 1024 * 1024;
 
-    void Write(const uint8_t* data, size_t length);
+    // Set from StartOptions, 0 keeps the current limit.
+    static void SetKindMaxCapacity(DataStreamKind kind, size_t maxCapacity);
+    static size_t KindMaxCapacity(DataStreamKind kind);
+
+    DataStream(uint32_t identifier, size_t maxCapacity = kDefaultMaxCapacity);
+    ~DataStream();
+
+    // Credited bytes were already promised to the sender, they count against the memory budget but never wait on it.
+    void Write(const uint8_t* data, size_t length, bool credited = false);
     size_t Read(uint8_t* buffer, size_t bufferSize);
     void Close();
 
+    size_t AllocatedBytes();
+    // Only affects future growth, buffered bytes above a lowered limit stay.
+    void SetMaxCapacity(size_t maxCapacity);
+
+    // Called with the number of bytes taken out by every Read and the bytes still buffered, outside the lock. Must be
+    // set before the stream is shared with other threads.
+    void SetConsumeListener(std::function<void(size_t consumed, size_t buffered)> listener) { _consumeListener = std::move(listener); }
+
     uint32_t GetIdentifier() const { return _identifier; }
 
 private:
@@ -23,11 +99,19 @@ private:
     std::vector<uint8_t> _buffer;
     std::mutex _mutex;
     std::condition_variable _cvRead, _cvWrite;
-    size_t _head = 0, _tail = 0, _size = 0, _capacity;
-    bool _isClosed = false;
+    size_t _head = 0, _tail = 0, _size = 0, _capacity = 0;
+    size_t _maxCapacity;
+    size_t _peakSize = 0;
+    std::atomic<bool> _isClosed = false;
+    std::atomic<bool> _readerWaiting = false;
+    std::function<void(size_t consumed, size_t buffered)> _consumeListener;
 
-    bool isFull() const { return _size == _capacity; }
+    bool isFull() const { return _size >= _maxCapacity; }
     bool isEmpty() const { return _size == 0; }
+    void reportConsumed(size_t consumed, size_t buffered);
+    void reserveLocked(size_t length);
+    void reallocateLocked(size_t capacity);
+    void shrinkIfDrainedLocked();
 };
 
 #endif // DATASTREAM_H
@@ -68,6 +68,65 @@ private:
     std::size_t position_ = 0;
 };
 
+// How a proxy URL rule is matched against request URLs. Same values as native/src/url_matcher.h.
+enum class UrlPatternKind : std::uint8_t
+{
+    Exact = 0,
+    Prefix = 1,
+    // '*' matches any run of characters, '?' exactly one.
+    Glob = 2,
+};
+
+// Values of cef_resource_type_t.
+enum class RequestResourceType : std::uint8_t
+{
+    MainFrame = 0,
+    SubFrame = 1,
+    Stylesheet = 2,
+    Script = 3,
+    Image = 4,
+    Font = 5,
+    SubResource = 6,
+    Object = 7,
+    Media = 8,
+    Worker = 9,
+    SharedWorker = 10,
+    Prefetch = 11,
+    Favicon = 12,
+    Xhr = 13,
+    Ping = 14,
+    ServiceWorker = 15,
+    CspReport = 16,
+    PluginResource = 17,
+    NavigationPreloadMainFrame = 19,
+    NavigationPreloadSubFrame = 20,
+};
+
+constexpr std::uint32_t ResourceTypeBit(RequestResourceType type)
+{
+    return 1u << static_cast<std::uint32_t>(type);
+}
+
+// Declarative edit justcefnative applies to matching requests itself, before any RequestModifier round trip, see
+// JustCefWindow::SetRequestRewriteRulesAsync. Same layout as native/src/request_rewriter.h.
+struct RequestRewriteRule
+{
+    UrlPatternKind url_kind = UrlPatternKind::Prefix;
+    // An empty prefix matches every URL.
+    std::string url_pattern;
+    // Empty matches any method.
+    std::string method;
+    // ResourceTypeBit of every accepted type, 0 matches any.
+    std::uint32_t resource_types = 0;
+
+    // Cancels the request, the other actions are ignored.
+    bool block = false;
+    // Empty keeps the URL. A Prefix rule replaces only the matched prefix, the others the whole URL.
+    std::string rewrite_url;
+    std::vector<std::pair<std::string, std::string>> set_headers;
+    std::vector<std::string> remove_headers;
+};
+
 enum class IPCProxyBodyElementType : std::uint8_t
 {
     Empty = 0,
@@ -126,6 +185,22 @@ struct Size
     int height = 0;
 };
 
+// Counters of the native cache for proxied responses of one window. A revalidation is a conditional request sent
+// for a stale entry, not_modified counts the ones answered with 304 and served from the cache.
+struct ProxyCacheStats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t revalidations = 0;
+    std::uint64_t not_modified = 0;
+    std::uint64_t stores = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t bytes_served = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    std::size_t capacity = 0;
+};
+
 struct FileFilter
 {
     std::string name;
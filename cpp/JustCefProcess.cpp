@@ -1,19 +1,26 @@
 #include "JustCefProcess.h"
 #include "AsyncSignal.h"
+#include "ChunkBufferPool.h"
 #include "DataStream.h"
+#include "OutboundScheduler.h"
 #include "Packet.h"
+#include "PendingRequestTable.h"
+#include "ShmTransport.h"
+#include "StreamChunkSizer.h"
 #include "WindowInternals.h"
 
 #include <algorithm>
 #include <array>
 #include <atomic>
 #include <cerrno>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <set>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <thread>
@@ -29,6 +36,7 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
@@ -423,6 +431,27 @@ std::vector<std::string> SplitArguments(const std::string& arguments)
 }
 #endif
 
+// Optional justcefnative flags taken from StartOptions, a zero value is left out so the native default applies.
+std::vector<std::pair<std::string, std::size_t>> NativeLimitArguments(const StartOptions& options)
+{
+    const std::pair<std::string, std::size_t> limits[] = {
+        {"--ipc-proxy-response-stream-capacity", options.proxy_response_stream_capacity},
+        {"--ipc-request-body-stream-capacity", options.request_body_stream_capacity},
+        {"--ipc-bridge-payload-stream-capacity", options.bridge_payload_stream_capacity},
+        {"--ipc-stream-memory-limit", options.stream_memory_limit},
+    };
+
+    std::vector<std::pair<std::string, std::size_t>> arguments;
+    for (const auto& limit : limits)
+    {
+        if (limit.second > 0)
+        {
+            arguments.push_back(limit);
+        }
+    }
+    return arguments;
+}
+
 std::filesystem::path CurrentExecutablePath()
 {
 #ifdef _WIN32
@@ -577,6 +606,18 @@ public:
         }
 
         start_options_ = options;
+        max_packet_size_ = std::clamp(options.max_packet_size, detail::kMinIpcSize, detail::kMaxIpcSize);
+        inline_threshold_ = std::min(options.inline_payload_threshold, max_packet_size_.load());
+        DataStream::SetKindMaxCapacity(DataStreamKind::RequestBody, options.request_body_stream_capacity);
+        DataStream::SetKindMaxCapacity(DataStreamKind::BridgePayload, options.bridge_payload_stream_capacity);
+        DataStream::SetKindMaxCapacity(DataStreamKind::BinaryPayload, options.binary_payload_stream_capacity);
+        StreamMemoryBudget::Global().SetLimit(options.stream_memory_limit);
+        // Credit retries go through the executor instead of the reader thread that released the bytes.
+        StreamMemoryBudget::Global().SetWaiterExecutor(
+            [executor = executor_](std::function<void()> waiter)
+            {
+                asio::post(executor, std::move(waiter));
+            });
 
         try
         {
@@ -625,6 +666,17 @@ public:
             command_parts.push_back(std::to_wstring(reinterpret_cast<std::uintptr_t>(child_read_handle)));
             command_parts.push_back(L"--child-to-parent");
             command_parts.push_back(std::to_wstring(reinterpret_cast<std::uintptr_t>(child_write_handle)));
+            command_parts.push_back(L"--ipc-max-packet-size");
+            command_parts.push_back(std::to_wstring(max_packet_size_.load()));
+            command_parts.push_back(L"--ipc-inline-threshold");
+            command_parts.push_back(std::to_wstring(inline_threshold_.load()));
+            command_parts.push_back(L"--ipc-capabilities");
+            command_parts.push_back(std::to_wstring(detail::kControllerCapabilities));
+            for (const auto& [flag, value] : NativeLimitArguments(options))
+            {
+                command_parts.push_back(Utf8ToWide(flag));
+                command_parts.push_back(std::to_wstring(value));
+            }
             for (const auto& argument : additional_arguments)
             {
                 command_parts.push_back(Utf8ToWide(argument));
@@ -672,6 +724,19 @@ public:
                 throw std::runtime_error("Failed to create child-to-parent pipe.");
             }
 
+            int shm_fd = -1;
+            if (options.shared_memory_transport && detail::ShmTransport::IsSupported())
+            {
+                try
+                {
+                    shm_fd = shm_transport_.Create(options.shared_memory_ring_size);
+                }
+                catch (...)
+                {
+                    Logger::Error("JustCefProcess", "Failed to create shared memory transport, using pipes.", std::current_exception());
+                }
+            }
+
             const pid_t child_pid = ::fork();
             if (child_pid < 0)
             {
@@ -679,6 +744,10 @@ public:
                 ::close(parent_to_child[1]);
                 ::close(child_to_parent[0]);
                 ::close(child_to_parent[1]);
+                if (shm_fd != -1)
+                {
+                    ::close(shm_fd);
+                }
                 throw std::runtime_error("Failed to fork justcefnative.");
             }
 
@@ -699,6 +768,22 @@ public:
                 argv_storage.push_back(std::to_string(parent_to_child[0]));
                 argv_storage.push_back("--child-to-parent");
                 argv_storage.push_back(std::to_string(child_to_parent[1]));
+                argv_storage.push_back("--ipc-max-packet-size");
+                argv_storage.push_back(std::to_string(max_packet_size_.load()));
+                argv_storage.push_back("--ipc-inline-threshold");
+                argv_storage.push_back(std::to_string(inline_threshold_.load()));
+                argv_storage.push_back("--ipc-capabilities");
+                argv_storage.push_back(std::to_string(detail::kControllerCapabilities));
+                for (const auto& [flag, value] : NativeLimitArguments(options))
+                {
+                    argv_storage.push_back(flag);
+                    argv_storage.push_back(std::to_string(value));
+                }
+                if (shm_fd != -1 && ::fcntl(shm_fd, F_SETFD, 0) == 0)
+                {
+                    argv_storage.push_back("--ipc-shm");
+                    argv_storage.push_back(std::to_string(shm_fd));
+                }
                 argv_storage.insert(argv_storage.end(), additional_arguments.begin(), additional_arguments.end());
 
                 std::vector<char*> argv;
@@ -715,6 +800,11 @@ public:
 
             ::close(parent_to_child[0]);
             ::close(child_to_parent[1]);
+            if (shm_fd != -1)
+            {
+                ::close(shm_fd);
+                shm_transport_.SetLivenessHandle(child_to_parent[0]);
+            }
             write_handle_ = parent_to_child[1];
             read_handle_ = child_to_parent[0];
             child_pid_ = child_pid;
@@ -736,6 +826,27 @@ public:
 
     bool HasExited() const { return !started_.load() || shutdown_.load(); }
 
+    OutboundQueueStats GetOutboundQueueStats() const
+    {
+        std::lock_guard<std::mutex> lock(outbound_mutex_);
+        OutboundQueueStats stats;
+        stats.response_bytes = outbound_scheduler_.PendingBytes(detail::OutboundClass::Response);
+        stats.control_bytes = outbound_scheduler_.PendingBytes(detail::OutboundClass::Control);
+        stats.stream_bytes = outbound_scheduler_.PendingBytes(detail::OutboundClass::Stream);
+        stats.waiting_writers = outbound_scheduler_.Size();
+        return stats;
+    }
+
+    StreamMemoryStats GetStreamMemoryStats() const
+    {
+        const auto budget = StreamMemoryBudget::Global().GetStats();
+        return StreamMemoryStats{
+            .limit = budget.limit,
+            .current = budget.current,
+            .peak = budget.peak,
+        };
+    }
+
     std::vector<std::shared_ptr<JustCefWindow>> Windows() const
     {
         std::lock_guard<std::mutex> lock(windows_mutex_);
@@ -797,6 +908,19 @@ public:
         co_await AsyncVoidCall(detail::OpcodeController::Print, std::move(writer));
     }
 
+    asio::awaitable<StreamMemoryStats> GetNativeStreamMemoryStatsAsync()
+    {
+        co_return co_await AsyncParsedCall<StreamMemoryStats>(detail::OpcodeController::GetStreamMemoryStats, detail::PacketWriter{},
+                                                              [](detail::PacketReader& reader)
+                                                              {
+                                                                  return StreamMemoryStats{
+                                                                      .limit = static_cast<std::size_t>(ReadRequired<std::uint64_t>(reader, "limit")),
+                                                                      .current = static_cast<std::size_t>(ReadRequired<std::uint64_t>(reader, "current")),
+                                                                      .peak = static_cast<std::size_t>(ReadRequired<std::uint64_t>(reader, "peak")),
+                                                                  };
+                                                              });
+    }
+
     asio::awaitable<std::shared_ptr<JustCefWindow>> CreateWindowAsync(const WindowCreateOptions& options)
     {
         EnsureStarted();
@@ -884,6 +1008,15 @@ public:
         co_return static_cast<detail::StreamDataStatus>(ReadRequired<std::uint8_t>(reader, "streamStatus"));
     }
 
+    void SendStreamCredit(std::uint32_t identifier, std::size_t credit, detail::StreamDataStatus status)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::uint32_t>(identifier);
+        writer.Write<std::uint32_t>(static_cast<std::uint32_t>(credit));
+        writer.Write<std::uint8_t>(static_cast<std::uint8_t>(status));
+        SendPacket(detail::PacketType::Notification, static_cast<std::uint8_t>(detail::OpcodeClientNotification::StreamCredit), 0, writer.Buffer());
+    }
+
     asio::awaitable<void> StreamEndAsync(std::uint32_t identifier, std::uint64_t totalBytes)
     {
         detail::PacketWriter writer;
@@ -955,6 +1088,65 @@ public:
         co_await AsyncVoidCall(detail::OpcodeController::WindowSetModifyRequests, std::move(writer));
     }
 
+    asio::awaitable<void> WindowSetProxyCacheAsync(int identifier, std::size_t capacity_bytes)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        writer.Write<std::uint64_t>(static_cast<std::uint64_t>(capacity_bytes));
+        co_await AsyncVoidCall(detail::OpcodeController::WindowSetProxyCache, std::move(writer));
+    }
+
+    asio::awaitable<std::uint32_t> WindowPurgeProxyCacheAsync(int identifier, std::string url, bool prefix)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        writer.Write<bool>(prefix);
+        writer.WriteSizePrefixedString(url);
+        co_return co_await AsyncParsedCall<std::uint32_t>(detail::OpcodeController::WindowPurgeProxyCache, std::move(writer),
+                                                          [](detail::PacketReader& reader) { return ReadRequired<std::uint32_t>(reader, "removed"); });
+    }
+
+    asio::awaitable<ProxyCacheStats> WindowGetProxyCacheStatsAsync(int identifier)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        co_return co_await AsyncParsedCall<ProxyCacheStats>(detail::OpcodeController::WindowGetProxyCacheStats, std::move(writer),
+                                                            [](detail::PacketReader& reader)
+                                                            {
+                                                                return ProxyCacheStats{
+                                                                    .hits = ReadRequired<std::uint64_t>(reader, "hits"),
+                                                                    .misses = ReadRequired<std::uint64_t>(reader, "misses"),
+                                                                    .revalidations = ReadRequired<std::uint64_t>(reader, "revalidations"),
+                                                                    .not_modified = ReadRequired<std::uint64_t>(reader, "not_modified"),
+                                                                    .stores = ReadRequired<std::uint64_t>(reader, "stores"),
+                                                                    .evictions = ReadRequired<std::uint64_t>(reader, "evictions"),
+                                                                    .bytes_served = ReadRequired<std::uint64_t>(reader, "bytes_served"),
+                                                                    .entries = static_cast<std::size_t>(ReadRequired<std::uint64_t>(reader, "entries")),
+                                                                    .bytes = static_cast<std::size_t>(ReadRequired<std::uint64_t>(reader, "bytes")),
+                                                                    .capacity = static_cast<std::size_t>(ReadRequired<std::uint64_t>(reader, "capacity")),
+                                                                };
+                                                            });
+    }
+
+    asio::awaitable<bool> WindowMountAsync(int identifier, std::string url_prefix, std::string path)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        writer.WriteSizePrefixedString(url_prefix);
+        writer.WriteSizePrefixedString(path);
+        co_return co_await AsyncParsedCall<bool>(detail::OpcodeController::WindowMount, std::move(writer),
+                                                 [](detail::PacketReader& reader) { return ReadRequired<bool>(reader, "mounted"); });
+    }
+
+    asio::awaitable<bool> WindowUnmountAsync(int identifier, std::string url_prefix)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        writer.WriteSizePrefixedString(url_prefix);
+        co_return co_await AsyncParsedCall<bool>(detail::OpcodeController::WindowUnmount, std::move(writer),
+                                                 [](detail::PacketReader& reader) { return ReadRequired<bool>(reader, "removed"); });
+    }
+
     asio::awaitable<void> RequestFocusAsync(int identifier) { co_await AsyncWindowIdentifierCall(detail::OpcodeController::WindowRequestFocus, identifier); }
 
     asio::awaitable<void> WindowLoadUrlAsync(int identifier, std::string url)
@@ -1242,6 +1434,52 @@ public:
         co_await AsyncWindowStringCall(detail::OpcodeController::WindowRemoveDomainToProxy, identifier, std::move(domain));
     }
 
+    asio::awaitable<void> WindowSetRequestRewriteRulesAsync(int identifier, std::vector<RequestRewriteRule> rules)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        writer.Write<std::uint32_t>(static_cast<std::uint32_t>(rules.size()));
+        for (const RequestRewriteRule& rule : rules)
+        {
+            writer.Write<std::uint8_t>(static_cast<std::uint8_t>(rule.url_kind));
+            writer.WriteSizePrefixedString(rule.url_pattern);
+            writer.WriteSizePrefixedString(rule.method);
+            writer.Write<std::uint32_t>(rule.resource_types);
+            writer.Write<bool>(rule.block);
+            writer.WriteSizePrefixedString(rule.rewrite_url);
+            writer.Write<std::uint32_t>(static_cast<std::uint32_t>(rule.set_headers.size()));
+            for (const auto& [name, value] : rule.set_headers)
+            {
+                writer.WriteSizePrefixedString(name);
+                writer.WriteSizePrefixedString(value);
+            }
+            writer.Write<std::uint32_t>(static_cast<std::uint32_t>(rule.remove_headers.size()));
+            for (const std::string& name : rule.remove_headers)
+            {
+                writer.WriteSizePrefixedString(name);
+            }
+        }
+        co_await AsyncVoidCall(detail::OpcodeController::WindowSetRequestRewriteRules, std::move(writer));
+    }
+
+    asio::awaitable<void> WindowAddUrlPatternToProxyAsync(int identifier, UrlPatternKind kind, std::string pattern)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        writer.Write<std::uint8_t>(static_cast<std::uint8_t>(kind));
+        writer.WriteSizePrefixedString(pattern);
+        co_await AsyncVoidCall(detail::OpcodeController::WindowAddUrlPatternToProxy, std::move(writer));
+    }
+
+    asio::awaitable<void> WindowRemoveUrlPatternToProxyAsync(int identifier, UrlPatternKind kind, std::string pattern)
+    {
+        detail::PacketWriter writer;
+        writer.Write<std::int32_t>(identifier);
+        writer.Write<std::uint8_t>(static_cast<std::uint8_t>(kind));
+        writer.WriteSizePrefixedString(pattern);
+        co_await AsyncVoidCall(detail::OpcodeController::WindowRemoveUrlPatternToProxy, std::move(writer));
+    }
+
     asio::awaitable<void> WindowAddUrlToModifyAsync(int identifier, std::string url)
     {
         co_await AsyncWindowStringCall(detail::OpcodeController::WindowAddUrlToModify, identifier, std::move(url));
@@ -1281,6 +1519,17 @@ private:
     {
         std::shared_ptr<ByteStream> stream;
         std::atomic<bool> canceled = false;
+        detail::AsyncCredit credit{detail::kStreamInitialCredit};
+        // Only touched by the coroutine that sends the stream.
+        detail::StreamChunkSizer chunk_sizer;
+    };
+
+    struct IncomingStreamCredit
+    {
+        std::uint32_t identifier = 0;
+        std::atomic<std::size_t> unacknowledged = 0;
+        // Set while a retry waits on the stream memory budget.
+        std::atomic<bool> deferred = false;
     };
 
     struct WindowRecord
@@ -1300,6 +1549,20 @@ private:
 
     bool ReadExact(void* buffer, std::size_t size)
     {
+        if (shm_read_active_.load())
+        {
+            const std::size_t read = shm_transport_.Read(buffer, size);
+            if (read == 0)
+            {
+                return false;
+            }
+            if (read != size)
+            {
+                throw std::runtime_error("Shared memory transport closed while reading.");
+            }
+            return true;
+        }
+
         auto* bytes = static_cast<std::uint8_t*>(buffer);
         std::size_t total = 0;
         while (total < size)
@@ -1336,6 +1599,15 @@ private:
 
     void WriteExact(const std::uint8_t* data, std::size_t size)
     {
+        if (shm_write_active_.load())
+        {
+            if (shm_transport_.Write(data, size) != size)
+            {
+                throw std::runtime_error("Failed to write to shared memory transport.");
+            }
+            return;
+        }
+
         std::size_t total = 0;
         while (total < size)
         {
@@ -1360,7 +1632,70 @@ private:
         }
     }
 
-    void SendPacket(detail::PacketType packet_type, std::uint8_t opcode, std::uint32_t request_id, const std::vector<std::uint8_t>& body)
+    // Writes all segments back to back with as few syscalls as possible (writev on POSIX).
+    void WriteExactV(std::span<const std::span<const std::uint8_t>> segments)
+    {
+#ifdef _WIN32
+        for (const auto& segment : segments)
+        {
+            WriteExact(segment.data(), segment.size());
+        }
+#else
+        if (shm_write_active_.load())
+        {
+            for (const auto& segment : segments)
+            {
+                WriteExact(segment.data(), segment.size());
+            }
+            return;
+        }
+
+        std::array<iovec, 8> iov{};
+        std::size_t index = 0;
+        std::size_t offset = 0;
+        while (index < segments.size())
+        {
+            int iov_count = 0;
+            for (std::size_t i = index; i < segments.size() && iov_count < static_cast<int>(iov.size()); ++i)
+            {
+                const std::size_t skip = i == index ? offset : 0;
+                if (segments[i].size() == skip)
+                {
+                    continue;
+                }
+                iov[iov_count].iov_base = const_cast<std::uint8_t*>(segments[i].data() + skip);
+                iov[iov_count].iov_len = segments[i].size() - skip;
+                ++iov_count;
+            }
+
+            if (iov_count == 0)
+            {
+                break;
+            }
+
+            const ssize_t written = ::writev(write_handle_, iov.data(), iov_count);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::runtime_error("Failed to write to IPC pipe.");
+            }
+
+            auto remaining = static_cast<std::size_t>(written);
+            while (index < segments.size() && remaining >= segments[index].size() - offset)
+            {
+                remaining -= segments[index].size() - offset;
+                offset = 0;
+                ++index;
+            }
+            offset += remaining;
+        }
+#endif
+    }
+
+    void SendPacket(detail::PacketType packet_type, std::uint8_t opcode, std::uint32_t request_id, std::span<const std::uint8_t> body)
     {
         EnsureStarted();
         if (shutdown_.load())
@@ -1368,53 +1703,218 @@ private:
             throw std::runtime_error("Process transport is shut down.");
         }
 
+        if (body.size() > max_packet_size_.load())
+        {
+            throw std::runtime_error("IPC packet exceeds the negotiated maximum packet size.");
+        }
+
         const std::uint32_t packet_size = static_cast<std::uint32_t>(body.size() + detail::kPacketHeaderSize - sizeof(std::uint32_t));
 
-        std::vector<std::uint8_t> packet(detail::kPacketHeaderSize + body.size());
-        std::memcpy(packet.data(), &packet_size, sizeof(packet_size));
-        std::memcpy(packet.data() + sizeof(packet_size), &request_id, sizeof(request_id));
-        packet[8] = static_cast<std::uint8_t>(packet_type);
-        packet[9] = opcode;
-        if (!body.empty())
+        std::array<std::uint8_t, detail::kPacketHeaderSize> header{};
+        std::memcpy(header.data(), &packet_size, sizeof(packet_size));
+        std::memcpy(header.data() + sizeof(packet_size), &request_id, sizeof(request_id));
+        header[8] = static_cast<std::uint8_t>(packet_type);
+        header[9] = opcode;
+
+        std::uint32_t stream_id = 0;
+        const detail::OutboundClass outbound_class = ClassFor(packet_type, opcode, body, stream_id);
+        const std::size_t total = header.size() + body.size();
+        // A runtime that cannot reassemble fragments gets the packet whole, it is within the negotiated maximum.
+        if (total <= detail::kLaneFragmentSize || (runtime_capabilities_.load() & detail::kControllerCapabilityFragments) == 0)
         {
-            std::memcpy(packet.data() + detail::kPacketHeaderSize, body.data(), body.size());
+            const std::array<std::span<const std::uint8_t>, 2> segments{std::span<const std::uint8_t>(header), body};
+
+            TransportTurn turn(*this, outbound_class, stream_id, total);
+            WriteExactV(segments);
+            return;
         }
 
-        std::lock_guard<std::mutex> lock(write_mutex_);
-        WriteExact(packet.data(), packet.size());
+        // One packet is fragmented at a time. Every slice is scheduled on its own, so packets of a higher class
+        // and other streams go out in between.
+        std::lock_guard<std::mutex> fragment_lock(fragment_mutex_);
+        for (std::size_t written = 0; written < total;)
+        {
+            const std::size_t length = std::min(detail::kLaneFragmentSize, total - written);
+            const std::uint32_t frame_size = static_cast<std::uint32_t>(length + detail::kPacketHeaderSize - sizeof(std::uint32_t));
+            // All fragments of this controller belong to lane 0, see kFragmentLaneCount.
+            const std::uint32_t frame_request_id = 0;
+            std::array<std::uint8_t, detail::kPacketHeaderSize> frame{};
+            std::memcpy(frame.data(), &frame_size, sizeof(frame_size));
+            std::memcpy(frame.data() + sizeof(frame_size), &frame_request_id, sizeof(frame_request_id));
+            frame[8] = static_cast<std::uint8_t>(detail::PacketType::Fragment);
+            frame[9] = written + length == total ? detail::kFragmentLast : 0;
+
+            // The first slice starts with the packet header, the rest is body.
+            std::array<std::span<const std::uint8_t>, 3> segments{std::span<const std::uint8_t>(frame)};
+            std::size_t segment_count = 1;
+            std::size_t body_offset = 0;
+            std::size_t body_length = length;
+            if (written == 0)
+            {
+                segments[segment_count++] = std::span<const std::uint8_t>(header);
+                body_length -= header.size();
+            }
+            else
+            {
+                body_offset = written - header.size();
+            }
+            segments[segment_count++] = body.subspan(body_offset, body_length);
+
+            TransportTurn turn(*this, outbound_class, stream_id, frame.size() + length);
+            WriteExactV(std::span<const std::span<const std::uint8_t>>(segments.data(), segment_count));
+            written += length;
+        }
     }
 
+    static detail::OutboundClass ClassFor(detail::PacketType packet_type, std::uint8_t opcode, std::span<const std::uint8_t> body, std::uint32_t& stream_id)
+    {
+        if (packet_type == detail::PacketType::Response)
+        {
+            return detail::OutboundClass::Response;
+        }
+
+        bool stream = false;
+        if (packet_type == detail::PacketType::Request)
+        {
+            const auto controller_opcode = static_cast<detail::OpcodeController>(opcode);
+            stream = controller_opcode == detail::OpcodeController::StreamOpen || controller_opcode == detail::OpcodeController::StreamData ||
+                     controller_opcode == detail::OpcodeController::StreamEnd || controller_opcode == detail::OpcodeController::StreamClose;
+        }
+        else if (packet_type == detail::PacketType::Notification)
+        {
+            stream = static_cast<detail::OpcodeControllerNotification>(opcode) == detail::OpcodeControllerNotification::StreamData;
+        }
+
+        if (!stream)
+        {
+            return detail::OutboundClass::Control;
+        }
+
+        // Every stream packet starts with the uint32 stream id.
+        if (body.size() >= sizeof(stream_id))
+        {
+            std::memcpy(&stream_id, body.data(), sizeof(stream_id));
+        }
+        return detail::OutboundClass::Stream;
+    }
+
+    // Writers wait here for the transport and the scheduler hands it to the most urgent one when it is released, so
+    // a control reply is not stuck behind a stream of StreamData writes from other threads.
+    void AcquireTransport(detail::OutboundClass outbound_class, std::uint32_t stream_id, std::size_t bytes)
+    {
+        std::unique_lock<std::mutex> lock(outbound_mutex_);
+        if (!transport_busy_ && outbound_scheduler_.Empty())
+        {
+            transport_busy_ = true;
+            return;
+        }
+
+        bool granted = false;
+        outbound_scheduler_.Push(outbound_class, stream_id, bytes, &granted);
+        outbound_turn_.wait(lock,
+                            [&granted]
+                            {
+                                return granted;
+                            });
+    }
+
+    void ReleaseTransport()
+    {
+        {
+            std::lock_guard<std::mutex> lock(outbound_mutex_);
+            if (outbound_scheduler_.Empty())
+            {
+                transport_busy_ = false;
+                return;
+            }
+
+            // The transport stays busy and passes straight to the next writer.
+            *outbound_scheduler_.Pop() = true;
+        }
+        outbound_turn_.notify_all();
+    }
+
+    class TransportTurn
+    {
+    public:
+        TransportTurn(JustCefProcessImpl& owner, detail::OutboundClass outbound_class, std::uint32_t stream_id, std::size_t bytes) : owner_(owner)
+        {
+            owner_.AcquireTransport(outbound_class, stream_id, bytes);
+        }
+        ~TransportTurn() { owner_.ReleaseTransport(); }
+
+        TransportTurn(const TransportTurn&) = delete;
+        TransportTurn& operator=(const TransportTurn&) = delete;
+
+    private:
+        JustCefProcessImpl& owner_;
+    };
+
     void Notify(detail::OpcodeControllerNotification opcode) { SendPacket(detail::PacketType::Notification, static_cast<std::uint8_t>(opcode), 0, {}); }
 
+    // Called on the receive thread when justcefnative announces that everything after its marker arrives
+    // over the shared memory ring. We answer with our own marker on the pipe and switch the write side.
+    void SwitchToSharedMemoryTransport()
+    {
+        if (!shm_transport_.IsCreated())
+        {
+            throw std::runtime_error("Received a transport switch without offering shared memory.");
+        }
+
+        shm_read_active_ = true;
+
+        TransportTurn turn(*this, detail::OutboundClass::Control, 0, detail::kPacketHeaderSize);
+        const std::uint32_t packet_size = static_cast<std::uint32_t>(detail::kPacketHeaderSize - sizeof(std::uint32_t));
+        const std::uint32_t request_id = 0;
+        std::array<std::uint8_t, detail::kPacketHeaderSize> marker{};
+        std::memcpy(marker.data(), &packet_size, sizeof(packet_size));
+        std::memcpy(marker.data() + sizeof(packet_size), &request_id, sizeof(request_id));
+        marker[8] = static_cast<std::uint8_t>(detail::PacketType::Notification);
+        marker[9] = static_cast<std::uint8_t>(detail::OpcodeControllerNotification::TransportSwitch);
+        WriteExact(marker.data(), marker.size());
+        shm_write_active_ = true;
+
+        Logger::Info("JustCefProcess", "Switched IPC to the shared memory transport.");
+    }
+
     asio::awaitable<std::vector<std::uint8_t>> AsyncRawCall(detail::OpcodeController opcode, detail::PacketWriter writer, DeferredOutgoingStreams* deferred = nullptr)
     {
         EnsureStarted();
 
         auto response = co_await asio::async_initiate<decltype(asio::use_awaitable), void(std::exception_ptr, std::vector<std::uint8_t>)>(
-            [self = shared_from_this(), opcode, body = writer.Buffer(), deferred](auto handler) mutable
+            [self = shared_from_this(), opcode, body = writer.TakeBuffer(), deferred](auto handler) mutable
             {
                 using Handler = std::decay_t<decltype(handler)>;
 
                 auto handler_ptr = std::make_shared<Handler>(std::move(handler));
                 auto handler_executor = asio::get_associated_executor(*handler_ptr, self->executor_);
-                const auto request_id = ++self->request_id_counter_;
 
+                PendingRequest pending;
+                pending.completion = [handler_ptr, handler_executor](std::exception_ptr exception, std::vector<std::uint8_t> response) mutable
+                {
+                    asio::dispatch(handler_executor,
+                                   [handler_ptr, exception, response = std::move(response)]() mutable
+                                   {
+                                       auto completion_handler = std::move(*handler_ptr);
+                                       completion_handler(exception, std::move(response));
+                                   });
+                };
+
+                const std::optional<std::uint32_t> request_id = self->pending_requests_.Insert(std::move(pending));
+                if (!request_id)
                 {
-                    std::lock_guard<std::mutex> lock(self->pending_requests_mutex_);
-                    self->pending_requests_[request_id].completion = [handler_ptr, handler_executor](std::exception_ptr exception, std::vector<std::uint8_t> response) mutable
+                    if (deferred)
                     {
-                        asio::dispatch(handler_executor,
-                                       [handler_ptr, exception, response = std::move(response)]() mutable
-                                       {
-                                           auto completion_handler = std::move(*handler_ptr);
-                                           completion_handler(exception, std::move(response));
-                                       });
-                    };
+                        deferred->CleanupAll();
+                    }
+
+                    pending.completion(std::make_exception_ptr(std::runtime_error("Too many IPC requests in flight.")), {});
+                    return;
                 }
 
                 try
                 {
-                    self->SendPacket(detail::PacketType::Request, static_cast<std::uint8_t>(opcode), request_id, body);
+                    self->SendPacket(detail::PacketType::Request, static_cast<std::uint8_t>(opcode), *request_id, body);
 
                     if (deferred && deferred->HasAny())
                     {
@@ -1428,18 +1928,12 @@ private:
                         deferred->CleanupAll();
                     }
 
+                    // The receive loop or shutdown may already have completed the request, only the taker completes it.
+                    std::optional<PendingRequest> taken = self->pending_requests_.Take(*request_id);
+                    if (taken && taken->completion)
                     {
-                        std::lock_guard<std::mutex> lock(self->pending_requests_mutex_);
-                        self->pending_requests_.erase(request_id);
+                        taken->completion(std::current_exception(), {});
                     }
-
-                    auto exception = std::current_exception();
-                    asio::dispatch(handler_executor,
-                                   [handler_ptr, exception]() mutable
-                                   {
-                                       auto completion_handler = std::move(*handler_ptr);
-                                       completion_handler(exception, std::vector<std::uint8_t>{});
-                                   });
                 }
             },
             asio::use_awaitable);
@@ -1550,148 +2044,95 @@ private:
     {
         try
         {
+            // The packet whose fragments are being received, per lane. Other packets arrive in between.
+            struct FragmentedPacket
+            {
+                std::optional<detail::PacketHeader> header;
+                std::vector<std::uint8_t> body;
+                std::size_t received = 0;
+            };
+            std::array<FragmentedPacket, detail::kFragmentLaneCount> fragmented_packets;
+
             for (;;)
             {
-                std::array<std::uint8_t, detail::kPacketHeaderSize> header_bytes{};
-                const bool had_partial_header = ReadExact(header_bytes.data(), header_bytes.size());
-                if (!had_partial_header)
+                detail::PacketHeader header;
+                if (!ReadPacketHeader(header))
                 {
                     break;
                 }
 
-                detail::PacketHeader header;
-                std::memcpy(&header.size, header_bytes.data(), sizeof(header.size));
-                std::memcpy(&header.request_id, header_bytes.data() + sizeof(header.size), sizeof(header.request_id));
-                header.packet_type = static_cast<detail::PacketType>(header_bytes[8]);
-                header.opcode = header_bytes[9];
-
                 const auto body_size = static_cast<std::size_t>(header.size + sizeof(std::uint32_t) - detail::kPacketHeaderSize);
-                if (body_size > detail::kMaxIpcSize)
-                {
-                    throw std::runtime_error("Received an IPC packet larger than the supported maximum.");
-                }
-
-                std::vector<std::uint8_t> body(body_size);
-                if (body_size > 0 && ReadExact(body.data(), body_size))
-                {
-                }
-                else if (body_size > 0)
-                {
-                    throw std::runtime_error("IPC pipe closed while reading a packet body.");
-                }
-
-                switch (header.packet_type)
-                {
-                case detail::PacketType::Response:
+                if (header.packet_type == detail::PacketType::Fragment)
                 {
-                    PendingRequest pending;
-                    bool found = false;
+                    if (body_size > detail::kLaneFragmentSize)
                     {
-                        std::lock_guard<std::mutex> lock(pending_requests_mutex_);
-                        const auto iterator = pending_requests_.find(header.request_id);
-                        if (iterator != pending_requests_.end())
-                        {
-                            pending = iterator->second;
-                            pending_requests_.erase(iterator);
-                            found = true;
-                        }
+                        throw std::runtime_error("Received an IPC fragment larger than the fragment size.");
                     }
-
-                    if (found && pending.completion)
+                    if (header.request_id >= fragmented_packets.size())
                     {
-                        pending.completion(nullptr, std::move(body));
+                        throw std::runtime_error("Received an IPC fragment for an unknown lane.");
                     }
-                    break;
-                }
-                case detail::PacketType::Request:
-                {
-                    const auto opcode = static_cast<detail::OpcodeClient>(header.opcode);
-                    if (opcode == detail::OpcodeClient::StreamOpen || opcode == detail::OpcodeClient::StreamData || opcode == detail::OpcodeClient::StreamClose ||
-                        opcode == detail::OpcodeClient::StreamCancel)
+
+                    FragmentedPacket& fragmented = fragmented_packets[header.request_id];
+                    std::size_t slice_size = body_size;
+                    if (!fragmented.header)
                     {
-                        if (body.size() < sizeof(std::uint32_t))
+                        detail::PacketHeader inner_header;
+                        if (slice_size < detail::kPacketHeaderSize || !ReadPacketHeader(inner_header) || inner_header.packet_type == detail::PacketType::Fragment)
                         {
-                            throw std::runtime_error("Received malformed stream packet.");
+                            throw std::runtime_error("Received a malformed first IPC fragment.");
                         }
 
-                        std::uint32_t stream_identifier = 0;
-                        std::memcpy(&stream_identifier, body.data(), sizeof(stream_identifier));
+                        const auto inner_body_size = static_cast<std::size_t>(inner_header.size + sizeof(std::uint32_t) - detail::kPacketHeaderSize);
+                        if (inner_body_size > receive_packet_limit_.load())
+                        {
+                            throw std::runtime_error("Received an IPC packet larger than the supported maximum.");
+                        }
 
-                        auto self = shared_from_this();
-                        QueueIncomingStreamWork(stream_identifier,
-                                                [self, opcode, request_id = header.request_id, opcode_byte = header.opcode, body = std::move(body)]() mutable
-                                                {
-                                                    try
-                                                    {
-                                                        detail::PacketReader reader(std::move(body));
-                                                        detail::PacketWriter writer;
+                        fragmented.header = inner_header;
+                        fragmented.body.resize(inner_body_size);
+                        fragmented.received = 0;
+                        slice_size -= detail::kPacketHeaderSize;
+                    }
 
-                                                        switch (opcode)
-                                                        {
-                                                        case detail::OpcodeClient::StreamOpen:
-                                                            self->HandleClientStreamOpen(reader);
-                                                            break;
-                                                        case detail::OpcodeClient::StreamData:
-                                                            self->HandleClientStreamData(reader, writer);
-                                                            break;
-                                                        case detail::OpcodeClient::StreamClose:
-                                                            self->HandleClientStreamClose(reader);
-                                                            break;
-                                                        case detail::OpcodeClient::StreamCancel:
-                                                            self->HandleClientStreamCancel(reader);
-                                                            break;
-                                                        default:
-                                                            break;
-                                                        }
-
-                                                        self->SendPacket(detail::PacketType::Response, opcode_byte, request_id, writer.Buffer());
-                                                    }
-                                                    catch (...)
-                                                    {
-                                                        Logger::Error("JustCefProcess", "Exception occurred while processing stream IPC request.", std::current_exception());
-                                                        try
-                                                        {
-                                                            self->SendPacket(detail::PacketType::Response, opcode_byte, request_id, {});
-                                                        }
-                                                        catch (...)
-                                                        {
-                                                        }
-                                                    }
-                                                });
-                        break;
+                    if (slice_size > fragmented.body.size() - fragmented.received)
+                    {
+                        throw std::runtime_error("Received an IPC fragment beyond the end of its packet.");
                     }
+                    if (slice_size > 0 && !ReadExact(fragmented.body.data() + fragmented.received, slice_size))
+                    {
+                        throw std::runtime_error("IPC pipe closed while reading a packet fragment.");
+                    }
+                    fragmented.received += slice_size;
 
-                    auto self = shared_from_this();
-                    asio::co_spawn(
-                        executor_,
-                        [self, opcode, request_id = header.request_id, body = std::move(body)]() mutable
-                        {
-                            return self->HandleIncomingRequest(opcode, request_id, std::move(body));
-                        },
-                        asio::detached);
-                    break;
+                    if ((header.opcode & detail::kFragmentLast) == 0)
+                    {
+                        continue;
+                    }
+                    if (fragmented.received != fragmented.body.size())
+                    {
+                        throw std::runtime_error("IPC fragments ended before the end of their packet.");
+                    }
+
+                    const detail::PacketHeader packet_header = *fragmented.header;
+                    fragmented.header.reset();
+                    DispatchPacket(packet_header, std::move(fragmented.body));
+                    fragmented.body = {};
+                    continue;
                 }
-                case detail::PacketType::Notification:
+
+                if (body_size > receive_packet_limit_.load())
                 {
-                    auto self = shared_from_this();
-                    asio::dispatch(executor_,
-                                   [self, opcode = static_cast<detail::OpcodeClientNotification>(header.opcode), body = std::move(body)]() mutable
-                                   {
-                                       try
-                                       {
-                                           detail::PacketReader reader(std::move(body));
-                                           self->HandleNotification(opcode, reader);
-                                       }
-                                       catch (...)
-                                       {
-                                           Logger::Error("JustCefProcess", "Exception occurred while processing IPC notification.", std::current_exception());
-                                       }
-                                   });
-                    break;
+                    throw std::runtime_error("Received an IPC packet larger than the supported maximum.");
                 }
-                default:
-                    throw std::runtime_error("Received an IPC packet with an unsupported type.");
+
+                std::vector<std::uint8_t> body(body_size);
+                if (body_size > 0 && !ReadExact(body.data(), body_size))
+                {
+                    throw std::runtime_error("IPC pipe closed while reading a packet body.");
                 }
+
+                DispatchPacket(header, std::move(body));
             }
         }
         catch (...)
@@ -1702,6 +2143,153 @@ private:
         Shutdown(true);
     }
 
+    // Returns false when the transport closed cleanly before a new header.
+    bool ReadPacketHeader(detail::PacketHeader& header)
+    {
+        std::array<std::uint8_t, detail::kPacketHeaderSize> header_bytes{};
+        if (!ReadExact(header_bytes.data(), header_bytes.size()))
+        {
+            return false;
+        }
+
+        std::memcpy(&header.size, header_bytes.data(), sizeof(header.size));
+        std::memcpy(&header.request_id, header_bytes.data() + sizeof(header.size), sizeof(header.request_id));
+        header.packet_type = static_cast<detail::PacketType>(header_bytes[8]);
+        header.opcode = header_bytes[9];
+        return true;
+    }
+
+    void DispatchPacket(const detail::PacketHeader& header, std::vector<std::uint8_t> body)
+    {
+        switch (header.packet_type)
+        {
+        case detail::PacketType::Response:
+        {
+            std::optional<PendingRequest> pending = pending_requests_.Take(header.request_id);
+            if (pending && pending->completion)
+            {
+                pending->completion(nullptr, std::move(body));
+            }
+            break;
+        }
+        case detail::PacketType::Request:
+        {
+            const auto opcode = static_cast<detail::OpcodeClient>(header.opcode);
+            if (opcode == detail::OpcodeClient::StreamOpen || opcode == detail::OpcodeClient::StreamData || opcode == detail::OpcodeClient::StreamClose ||
+                opcode == detail::OpcodeClient::StreamCancel)
+            {
+                if (body.size() < sizeof(std::uint32_t))
+                {
+                    throw std::runtime_error("Received malformed stream packet.");
+                }
+
+                std::uint32_t stream_identifier = 0;
+                std::memcpy(&stream_identifier, body.data(), sizeof(stream_identifier));
+
+                auto self = shared_from_this();
+                QueueIncomingStreamWork(stream_identifier,
+                                        [self, opcode, request_id = header.request_id, opcode_byte = header.opcode, body = std::move(body)]() mutable
+                                        {
+                                            try
+                                            {
+                                                detail::PacketReader reader(std::move(body));
+                                                detail::PacketWriter writer;
+
+                                                switch (opcode)
+                                                {
+                                                case detail::OpcodeClient::StreamOpen:
+                                                    self->HandleClientStreamOpen(reader);
+                                                    break;
+                                                case detail::OpcodeClient::StreamData:
+                                                    self->HandleClientStreamData(reader, writer);
+                                                    break;
+                                                case detail::OpcodeClient::StreamClose:
+                                                    self->HandleClientStreamClose(reader);
+                                                    break;
+                                                case detail::OpcodeClient::StreamCancel:
+                                                    self->HandleClientStreamCancel(reader);
+                                                    break;
+                                                default:
+                                                    break;
+                                                }
+
+                                                self->SendPacket(detail::PacketType::Response, opcode_byte, request_id, writer.Buffer());
+                                            }
+                                            catch (...)
+                                            {
+                                                Logger::Error("JustCefProcess", "Exception occurred while processing stream IPC request.", std::current_exception());
+                                                try
+                                                {
+                                                    self->SendPacket(detail::PacketType::Response, opcode_byte, request_id, {});
+                                                }
+                                                catch (...)
+                                                {
+                                                }
+                                            }
+                                        });
+                break;
+            }
+
+            auto self = shared_from_this();
+            asio::co_spawn(
+                executor_,
+                [self, opcode, request_id = header.request_id, body = std::move(body)]() mutable
+                {
+                    return self->HandleIncomingRequest(opcode, request_id, std::move(body));
+                },
+                asio::detached);
+            break;
+        }
+        case detail::PacketType::Notification:
+        {
+            if (static_cast<detail::OpcodeClientNotification>(header.opcode) == detail::OpcodeClientNotification::TransportSwitch)
+            {
+                SwitchToSharedMemoryTransport();
+                break;
+            }
+
+            // Stream data shares the per-stream queue with StreamOpen/StreamClose so it lands in order.
+            if (static_cast<detail::OpcodeClientNotification>(header.opcode) == detail::OpcodeClientNotification::StreamData)
+            {
+                if (body.size() < sizeof(std::uint32_t))
+                {
+                    throw std::runtime_error("Received malformed stream packet.");
+                }
+
+                std::uint32_t stream_identifier = 0;
+                std::memcpy(&stream_identifier, body.data(), sizeof(stream_identifier));
+
+                auto self = shared_from_this();
+                QueueIncomingStreamWork(stream_identifier,
+                                        [self, body = std::move(body)]() mutable
+                                        {
+                                            detail::PacketReader reader(std::move(body));
+                                            self->HandleClientStreamDataNotification(reader);
+                                        });
+                break;
+            }
+
+            auto self = shared_from_this();
+            asio::dispatch(executor_,
+                           [self, opcode = static_cast<detail::OpcodeClientNotification>(header.opcode), body = std::move(body)]() mutable
+                           {
+                               try
+                               {
+                                   detail::PacketReader reader(std::move(body));
+                                   self->HandleNotification(opcode, reader);
+                               }
+                               catch (...)
+                               {
+                                   Logger::Error("JustCefProcess", "Exception occurred while processing IPC notification.", std::current_exception());
+                               }
+                           });
+            break;
+        }
+        default:
+            throw std::runtime_error("Received an IPC packet with an unsupported type.");
+        }
+    }
+
     std::optional<WindowRecord> GetWindowRecord(int identifier) const
     {
         std::lock_guard<std::mutex> lock(windows_mutex_);
@@ -1735,19 +2323,87 @@ private:
         return removed;
     }
 
-    std::shared_ptr<DataStream> GetOrCreateIncomingStream(std::uint32_t identifier)
+    std::shared_ptr<DataStream> GetOrCreateIncomingStream(std::uint32_t identifier, DataStreamKind kind = DataStreamKind::Generic)
     {
         std::lock_guard<std::mutex> lock(incoming_streams_mutex_);
         if (const auto iterator = incoming_streams_.find(identifier); iterator != incoming_streams_.end())
         {
+            // StreamOpen may have created it before the reader knew what it carries.
+            if (kind != DataStreamKind::Generic)
+            {
+                iterator->second->SetMaxCapacity(IncomingStreamMaxCapacity(kind));
+            }
             return iterator->second;
         }
 
-        auto stream = std::make_shared<DataStream>(identifier);
+        auto stream = MakeIncomingStream(identifier, kind);
         incoming_streams_[identifier] = stream;
         return stream;
     }
 
+    // Whatever the reader consumed is free space again, it goes back to justcefnative as credit in batches.
+    // justcefnative may have a full credit window in flight, the buffer limit must always cover it.
+    static std::size_t IncomingStreamMaxCapacity(DataStreamKind kind) { return std::max(DataStream::KindMaxCapacity(kind), detail::kStreamInitialCredit); }
+
+    std::shared_ptr<DataStream> MakeIncomingStream(std::uint32_t identifier, DataStreamKind kind = DataStreamKind::Generic)
+    {
+        auto stream = std::make_shared<DataStream>(identifier, IncomingStreamMaxCapacity(kind));
+        auto credit = std::make_shared<IncomingStreamCredit>();
+        credit->identifier = identifier;
+        std::weak_ptr<JustCefProcessImpl> weak_self = weak_from_this();
+        stream->SetConsumeListener(
+            [weak_self, credit](std::size_t consumed, std::size_t buffered)
+            {
+                ReturnStreamCredit(weak_self, credit, consumed, buffered == 0);
+            });
+        return stream;
+    }
+
+    static void ReturnStreamCredit(const std::weak_ptr<JustCefProcessImpl>& weak_self, const std::shared_ptr<IncomingStreamCredit>& credit, std::size_t consumed,
+                                   bool drained)
+    {
+        if (credit->unacknowledged.fetch_add(consumed) + consumed < detail::kStreamCreditThreshold)
+        {
+            return;
+        }
+
+        // While the stream memory budget is exhausted credit is held back so justcefnative stops sending, unless the
+        // reader already drained this stream and is waiting for more.
+        if (!drained && StreamMemoryBudget::Global().Exhausted())
+        {
+            if (credit->deferred.exchange(true))
+            {
+                return;
+            }
+
+            std::function<void()> retry = [weak_self, credit]()
+            {
+                credit->deferred = false;
+                ReturnStreamCredit(weak_self, credit, 0, false);
+            };
+            if (StreamMemoryBudget::Global().RegisterWaiter(std::move(retry)))
+            {
+                return;
+            }
+            credit->deferred = false;
+        }
+
+        const std::size_t amount = credit->unacknowledged.exchange(0);
+        auto self = weak_self.lock();
+        if (!self || amount == 0 || self->shutdown_.load())
+        {
+            return;
+        }
+
+        try
+        {
+            self->SendStreamCredit(credit->identifier, amount, detail::StreamDataStatus::Accepted);
+        }
+        catch (...)
+        {
+        }
+    }
+
     void ReleaseIncomingStream(std::uint32_t identifier)
     {
         std::shared_ptr<DataStream> stream;
@@ -1790,9 +2446,9 @@ private:
             asio::detached);
     }
 
-    std::vector<std::uint8_t> ReadIncomingStreamBytes(std::uint32_t identifier, std::optional<std::size_t> expected_length, std::string_view description)
+    std::vector<std::uint8_t> ReadIncomingStreamBytes(std::uint32_t identifier, DataStreamKind kind, std::optional<std::size_t> expected_length, std::string_view description)
     {
-        auto stream = GetOrCreateIncomingStream(identifier);
+        auto stream = GetOrCreateIncomingStream(identifier, kind);
         bool completed = false;
 
         try
@@ -1814,15 +2470,15 @@ private:
             }
             else
             {
-                std::array<std::uint8_t, 65536> chunk{};
+                const auto chunk = detail::ChunkBufferPool::Global().Acquire(detail::StreamChunkSizer::kMaxChunkClass);
                 for (;;)
                 {
-                    const std::size_t read = stream->Read(chunk.data(), chunk.size());
+                    const std::size_t read = stream->Read(chunk.data(), chunk.capacity());
                     if (read == 0)
                     {
                         break;
                     }
-                    buffer.insert(buffer.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(read));
+                    buffer.insert(buffer.end(), chunk.data(), chunk.data() + read);
                 }
             }
 
@@ -1859,7 +2515,7 @@ private:
         case BridgeRpcPayloadEncoding::Stream:
         {
             const auto stream_identifier = ReadRequired<std::uint32_t>(reader, "streamIdentifier");
-            const auto payload_bytes = ReadIncomingStreamBytes(stream_identifier, static_cast<std::size_t>(payload_length), description);
+            const auto payload_bytes = ReadIncomingStreamBytes(stream_identifier, DataStreamKind::BridgePayload, static_cast<std::size_t>(payload_length), description);
             return std::string(payload_bytes.begin(), payload_bytes.end());
         }
         default:
@@ -1878,13 +2534,50 @@ private:
         case BinaryPayloadEncoding::Stream:
         {
             const auto stream_identifier = ReadRequired<std::uint32_t>(reader, "streamIdentifier");
-            return ReadIncomingStreamBytes(stream_identifier, static_cast<std::size_t>(payload_length), description);
+            return ReadIncomingStreamBytes(stream_identifier, DataStreamKind::BinaryPayload, static_cast<std::size_t>(payload_length), description);
         }
         default:
             throw std::runtime_error("Unsupported binary payload encoding.");
         }
     }
 
+    // Pipelines data as StreamData notifications within the receiver's credit window, in chunks sized by the
+    // stream's StreamChunkSizer. Returns false once the stream was canceled or the receiver reported it canceled
+    // or closed.
+    asio::awaitable<bool> SendStreamDataAsync(std::uint32_t identifier, OutgoingStreamState& state, const std::uint8_t* data, std::size_t size)
+    {
+        std::size_t offset = 0;
+        while (offset < size)
+        {
+            const std::size_t chunk_size = state.chunk_sizer.ChunkSize();
+            const std::size_t wanted = std::min(chunk_size, size - offset);
+            const std::size_t granted = co_await state.credit.AcquireAsync(wanted, executor_);
+            if (granted == 0 || state.canceled.load())
+            {
+                co_return false;
+            }
+
+            const auto packet = detail::ChunkBufferPool::Global().Acquire(sizeof(identifier) + granted);
+            std::memcpy(packet.data(), &identifier, sizeof(identifier));
+            std::memcpy(packet.data() + sizeof(identifier), data + offset, granted);
+
+            const auto started = std::chrono::steady_clock::now();
+            SendPacket(detail::PacketType::Notification, static_cast<std::uint8_t>(detail::OpcodeControllerNotification::StreamData), 0,
+                       std::span<const std::uint8_t>(packet.data(), sizeof(identifier) + granted));
+            if (granted == chunk_size)
+            {
+                state.chunk_sizer.RecordTransfer(granted, std::chrono::steady_clock::now() - started);
+            }
+            else if (granted == wanted)
+            {
+                // Not held back by credit, the producer had less than a chunk.
+                state.chunk_sizer.RecordShortChunk(granted);
+            }
+            offset += granted;
+        }
+        co_return true;
+    }
+
     void AddDeferredOutgoingStream(detail::PacketWriter& writer, DeferredOutgoingStreams& deferred, std::shared_ptr<OutgoingStreamState> state,
                                    std::function<asio::awaitable<void>(std::uint32_t, std::shared_ptr<OutgoingStreamState>)> transfer)
     {
@@ -1947,6 +2640,7 @@ private:
             [self, stream_identifier, state]() mutable
             {
                 state->canceled = true;
+                state->credit.Close();
                 if (state->stream)
                 {
                     try
@@ -1965,7 +2659,7 @@ private:
 
     void SerializeBridgeRpcPayload(detail::PacketWriter& writer, const std::string& payload, DeferredOutgoingStreams& deferred)
     {
-        if (payload.size() <= detail::kMaxIpcSize - writer.Size() - kInlinePayloadFramingSize)
+        if (payload.size() <= inline_threshold_.load() && payload.size() <= max_packet_size_.load() - writer.Size() - kInlinePayloadFramingSize)
         {
             WriteInlinePayload(writer, BridgeRpcPayloadEncoding::Inline, payload);
             return;
@@ -1980,17 +2674,9 @@ private:
             writer, deferred, state,
             [this, bytes](std::uint32_t stream_identifier, std::shared_ptr<OutgoingStreamState> state) -> asio::awaitable<void>
             {
-                std::size_t offset = 0;
-                while (offset < bytes->size() && !state->canceled.load())
-                {
-                    const std::size_t chunk_size = std::min<std::size_t>(65536, bytes->size() - offset);
-                    if (co_await StreamDataAsync(stream_identifier, std::vector<std::uint8_t>(bytes->begin() + static_cast<std::ptrdiff_t>(offset),
-                                                                                              bytes->begin() + static_cast<std::ptrdiff_t>(offset + chunk_size)))
-                        != detail::StreamDataStatus::Accepted)
-                        co_return;
-                    offset += chunk_size;
-                }
-                co_await StreamEndAsync(stream_identifier, offset);
+                if (!co_await SendStreamDataAsync(stream_identifier, *state, bytes->data(), bytes->size()))
+                    co_return;
+                co_await StreamEndAsync(stream_identifier, bytes->size());
                 co_return;
             });
     }
@@ -2013,7 +2699,8 @@ private:
         for (const auto& element : request.elements)
         {
             if (element.type == IPCProxyBodyElementType::Bytes &&
-                element.data.size() > detail::kMaxIpcSize - writer.Size() - (sizeof(std::uint8_t) + sizeof(std::int64_t) + sizeof(std::uint32_t)))
+                (element.data.size() > inline_threshold_.load() ||
+                 element.data.size() > max_packet_size_.load() - writer.Size() - (sizeof(std::uint8_t) + sizeof(std::int64_t) + sizeof(std::uint32_t))))
             {
                 writer.Write<std::uint8_t>(3);
                 writer.Write<std::int64_t>(static_cast<std::int64_t>(element.data.size()));
@@ -2024,17 +2711,9 @@ private:
                     writer, deferred, state,
                     [this, bytes](std::uint32_t stream_identifier, std::shared_ptr<OutgoingStreamState> state) -> asio::awaitable<void>
                     {
-                        std::size_t offset = 0;
-                        while (offset < bytes->size() && !state->canceled.load())
-                        {
-                            const std::size_t chunk_size = std::min<std::size_t>(65536, bytes->size() - offset);
-                            if (co_await StreamDataAsync(stream_identifier, std::vector<std::uint8_t>(bytes->begin() + static_cast<std::ptrdiff_t>(offset),
-                                                                                                      bytes->begin() + static_cast<std::ptrdiff_t>(offset + chunk_size)))
-                                != detail::StreamDataStatus::Accepted)
-                                co_return;
-                            offset += chunk_size;
-                        }
-                        co_await StreamEndAsync(stream_identifier, offset);
+                        if (!co_await SendStreamDataAsync(stream_identifier, *state, bytes->data(), bytes->size()))
+                            co_return;
+                        co_await StreamEndAsync(stream_identifier, bytes->size());
                         co_return;
                     });
                 continue;
@@ -2096,7 +2775,7 @@ private:
                 const auto length = ReadRequired<std::int64_t>(reader, "streamLength");
                 const auto stream_identifier = ReadRequired<std::uint32_t>(reader, "streamIdentifier");
                 const auto data =
-                    ReadIncomingStreamBytes(stream_identifier, length >= 0 ? std::optional<std::size_t>(static_cast<std::size_t>(length)) : std::nullopt, "request body stream");
+                    ReadIncomingStreamBytes(stream_identifier, DataStreamKind::RequestBody, length >= 0 ? std::optional<std::size_t>(static_cast<std::size_t>(length)) : std::nullopt, "request body stream");
                 parsed.request.elements.push_back(IPCProxyBodyElement::Bytes(std::move(data)));
                 break;
             }
@@ -2121,7 +2800,7 @@ private:
 
         if (!incoming_streams_.contains(identifier))
         {
-            incoming_streams_[identifier] = std::make_shared<DataStream>(identifier);
+            incoming_streams_[identifier] = MakeIncomingStream(identifier);
         }
     }
 
@@ -2160,6 +2839,66 @@ private:
         writer.Write<bool>(true);
     }
 
+    void HandleClientStreamDataNotification(detail::PacketReader& reader)
+    {
+        const auto identifier = ReadRequired<std::uint32_t>(reader, "streamIdentifier");
+
+        std::shared_ptr<DataStream> stream;
+        {
+            std::lock_guard<std::mutex> lock(incoming_streams_mutex_);
+            if (canceled_incoming_streams_.contains(identifier))
+            {
+                SendStreamCredit(identifier, 0, detail::StreamDataStatus::Canceled);
+                return;
+            }
+
+            const auto iterator = incoming_streams_.find(identifier);
+            if (iterator == incoming_streams_.end())
+            {
+                SendStreamCredit(identifier, 0, detail::StreamDataStatus::Closed);
+                return;
+            }
+            stream = iterator->second;
+        }
+
+        const auto remaining = reader.RemainingSize();
+        if (remaining > 0)
+        {
+            const auto data = reader.ReadBytes(remaining);
+            stream->Write(data.data(), data.size(), true);
+        }
+    }
+
+    void HandleClientStreamCredit(detail::PacketReader& reader)
+    {
+        const auto identifier = ReadRequired<std::uint32_t>(reader, "streamIdentifier");
+        const auto credit = ReadRequired<std::uint32_t>(reader, "credit");
+        const auto status = static_cast<detail::StreamDataStatus>(ReadRequired<std::uint8_t>(reader, "streamStatus"));
+
+        std::shared_ptr<OutgoingStreamState> stream_state;
+        {
+            std::lock_guard<std::mutex> lock(outgoing_streams_mutex_);
+            if (const auto iterator = outgoing_streams_.find(identifier); iterator != outgoing_streams_.end())
+            {
+                stream_state = iterator->second;
+            }
+        }
+
+        if (!stream_state)
+        {
+            return;
+        }
+
+        if (status != detail::StreamDataStatus::Accepted)
+        {
+            stream_state->canceled = true;
+            stream_state->credit.Close();
+            return;
+        }
+
+        stream_state->credit.Grant(credit);
+    }
+
     void HandleClientStreamClose(detail::PacketReader& reader)
     {
         const auto identifier = ReadRequired<std::uint32_t>(reader, "streamIdentifier");
@@ -2181,6 +2920,7 @@ private:
         if (stream_state)
         {
             stream_state->canceled = true;
+            stream_state->credit.Close();
             if (stream_state->stream)
             {
                 stream_state->stream->Close();
@@ -2389,7 +3129,8 @@ private:
         }
 
         const auto content_length = ParseContentLength(filtered_headers);
-        if (content_length && *content_length < static_cast<std::uint64_t>(detail::kMaxIpcSize - writer.Size()))
+        if (content_length && *content_length <= static_cast<std::uint64_t>(inline_threshold_.load()) &&
+            *content_length < static_cast<std::uint64_t>(max_packet_size_.load() - writer.Size()))
         {
             std::vector<std::uint8_t> buffer(static_cast<std::size_t>(*content_length));
             std::size_t total = 0;
@@ -2425,12 +3166,11 @@ private:
             writer, deferred, state,
             [this, content_length](std::uint32_t stream_identifier, std::shared_ptr<OutgoingStreamState> state) -> asio::awaitable<void>
             {
-                std::array<std::uint8_t, 65536> buffer{};
                 std::uint64_t total_read = 0;
 
                 while (!state->canceled.load())
                 {
-                    std::size_t request_size = buffer.size();
+                    std::size_t request_size = state->chunk_sizer.ChunkSize();
                     if (content_length)
                     {
                         if (total_read >= *content_length)
@@ -2443,14 +3183,14 @@ private:
                     if (state->canceled.load())
                         co_return;
 
+                    const auto buffer = detail::ChunkBufferPool::Global().Acquire(request_size);
                     const std::size_t bytes_read = state->stream ? co_await state->stream->ReadAsync(buffer.data(), request_size) : 0;
                     if (bytes_read == 0)
                     {
                         break;
                     }
 
-                    if (co_await StreamDataAsync(stream_identifier, std::vector<std::uint8_t>(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(bytes_read)))
-                        != detail::StreamDataStatus::Accepted)
+                    if (!co_await SendStreamDataAsync(stream_identifier, *state, buffer.data(), bytes_read))
                         co_return;
 
                     total_read += bytes_read;
@@ -2509,6 +3249,31 @@ private:
         co_return;
     }
 
+    // The Ready notification carries the limits justcefnative accepted and the capabilities it supports. Both sides
+    // keep to the smaller values, an older runtime sends nothing and keeps kMaxIpcSize, which covers anything the
+    // controller asked for, and gets no fragments.
+    void AdoptTransportLimits(detail::PacketReader& reader)
+    {
+        const auto max_packet_size = reader.Read<std::uint32_t>();
+        const auto inline_threshold = reader.Read<std::uint32_t>();
+        if (!max_packet_size || !inline_threshold)
+        {
+            return;
+        }
+
+        const std::size_t negotiated_max = std::clamp<std::size_t>(std::min<std::size_t>(*max_packet_size, max_packet_size_.load()), detail::kMinIpcSize, detail::kMaxIpcSize);
+        max_packet_size_ = negotiated_max;
+        receive_packet_limit_ = negotiated_max;
+        inline_threshold_ = std::min<std::size_t>({*inline_threshold, inline_threshold_.load(), negotiated_max});
+        Logger::Info("JustCefProcess", "Negotiated IPC limits: max packet size " + std::to_string(negotiated_max) + ", inline threshold " + std::to_string(inline_threshold_.load()) + ".");
+
+        if (const auto runtime_capabilities = reader.Read<std::uint32_t>())
+        {
+            runtime_capabilities_ = *runtime_capabilities;
+            Logger::Info("JustCefProcess", "Runtime capabilities " + std::to_string(*runtime_capabilities) + ".");
+        }
+    }
+
     void HandleNotification(detail::OpcodeClientNotification opcode, detail::PacketReader& reader)
     {
         switch (opcode)
@@ -2519,8 +3284,12 @@ private:
             break;
         case detail::OpcodeClientNotification::Ready:
             Logger::Info("JustCefProcess", "Client is ready.");
+            AdoptTransportLimits(reader);
             ready_signal_.SignalSuccess();
             break;
+        case detail::OpcodeClientNotification::StreamCredit:
+            HandleClientStreamCredit(reader);
+            break;
         case detail::OpcodeClientNotification::WindowOpened:
             Logger::Info("JustCefProcess", "Window opened: " + std::to_string(ReadRequired<std::int32_t>(reader, "identifier")));
             break;
@@ -2696,6 +3465,7 @@ private:
 
     void CloseTransportHandles()
     {
+        shm_transport_.Close();
 #ifdef _WIN32
         if (read_handle_ != INVALID_HANDLE_VALUE)
         {
@@ -2750,31 +3520,22 @@ private:
             ready_signal_.SignalFailure(std::make_exception_ptr(std::runtime_error("Process disposed before ready.")));
         }
 
-        std::vector<PendingRequest> pending_to_fail;
-        {
-            std::lock_guard<std::mutex> lock(pending_requests_mutex_);
-            pending_to_fail.reserve(pending_requests_.size());
-            for (auto& [_, pending] : pending_requests_)
-            {
-                pending_to_fail.push_back(std::move(pending));
-            }
-            pending_requests_.clear();
-        }
-
         const auto shutdown_exception = std::make_exception_ptr(std::runtime_error("Process disposed while awaiting IPC response."));
-        for (auto& pending : pending_to_fail)
-        {
-            if (pending.completion)
+        pending_requests_.TakeAll(
+            [&shutdown_exception](PendingRequest pending)
             {
-                pending.completion(shutdown_exception, {});
-            }
-        }
+                if (pending.completion)
+                {
+                    pending.completion(shutdown_exception, {});
+                }
+            });
 
         {
             std::lock_guard<std::mutex> lock(outgoing_streams_mutex_);
             for (auto& [_, stream] : outgoing_streams_)
             {
                 stream->canceled = true;
+                stream->credit.Close();
                 if (stream->stream)
                 {
                     stream->stream->Close();
@@ -2803,6 +3564,11 @@ private:
             }
         }
 
+        StreamMemoryBudget::Global().SetWaiterExecutor(nullptr);
+        const auto stream_memory = StreamMemoryBudget::Global().GetStats();
+        Logger::Info("JustCefProcess", "Stream memory at shutdown: " + std::to_string(stream_memory.current) + " bytes buffered, peak " +
+                                           std::to_string(stream_memory.peak) + " of " + std::to_string(stream_memory.limit) + ".");
+
         {
             std::lock_guard<std::mutex> lock(incoming_stream_dispatchers_mutex_);
             incoming_stream_dispatchers_.clear();
@@ -2828,12 +3594,17 @@ private:
     std::atomic<bool> started_ = false;
     std::atomic<bool> shutdown_ = false;
     StartOptions start_options_;
-    std::atomic<std::uint32_t> request_id_counter_ = 0;
+    // Negotiated transport limits, see detail::kMinIpcSize. Incoming packets are checked against
+    // receive_packet_limit_, which stays at kMaxIpcSize until justcefnative reports what it sends.
+    std::atomic<std::size_t> max_packet_size_ = detail::kMaxIpcSize;
+    // Set from Ready, see AdoptTransportLimits.
+    std::atomic<std::uint32_t> runtime_capabilities_ = 0;
+    std::atomic<std::size_t> inline_threshold_ = detail::kMaxIpcSize;
+    std::atomic<std::size_t> receive_packet_limit_ = detail::kMaxIpcSize;
     std::atomic<std::uint32_t> stream_identifier_counter_ = 0;
     mutable std::mutex windows_mutex_;
     std::vector<WindowRecord> windows_;
-    std::mutex pending_requests_mutex_;
-    std::unordered_map<std::uint32_t, PendingRequest> pending_requests_;
+    detail::PendingRequestTable<PendingRequest> pending_requests_;
     std::mutex incoming_stream_dispatchers_mutex_;
     std::unordered_map<std::uint32_t, std::shared_ptr<IncomingStreamDispatcher>> incoming_stream_dispatchers_;
     std::mutex outgoing_streams_mutex_;
@@ -2841,8 +3612,15 @@ private:
     std::mutex incoming_streams_mutex_;
     std::unordered_map<std::uint32_t, std::shared_ptr<DataStream>> incoming_streams_;
     std::unordered_set<std::uint32_t> canceled_incoming_streams_;
-    std::mutex write_mutex_;
+    mutable std::mutex outbound_mutex_;
+    std::condition_variable outbound_turn_;
+    detail::OutboundScheduler<bool*> outbound_scheduler_;
+    bool transport_busy_ = false;
+    std::mutex fragment_mutex_;
     std::thread receive_thread_;
+    detail::ShmTransport shm_transport_;
+    std::atomic<bool> shm_read_active_ = false;
+    std::atomic<bool> shm_write_active_ = false;
 
 #ifdef _WIN32
     HANDLE read_handle_ = INVALID_HANDLE_VALUE;
@@ -2880,6 +3658,16 @@ bool JustCefProcess::HasExited() const
     return impl_->HasExited();
 }
 
+OutboundQueueStats JustCefProcess::GetOutboundQueueStats() const
+{
+    return impl_->GetOutboundQueueStats();
+}
+
+StreamMemoryStats JustCefProcess::GetStreamMemoryStats() const
+{
+    return impl_->GetStreamMemoryStats();
+}
+
 std::vector<std::shared_ptr<JustCefWindow>> JustCefProcess::Windows() const
 {
     return impl_->Windows();
@@ -2925,6 +3713,11 @@ asio::awaitable<void> JustCefProcess::PrintAsync(std::string message)
     return impl_->PrintAsync(std::move(message));
 }
 
+asio::awaitable<StreamMemoryStats> JustCefProcess::GetNativeStreamMemoryStatsAsync()
+{
+    return impl_->GetNativeStreamMemoryStatsAsync();
+}
+
 asio::awaitable<std::shared_ptr<JustCefWindow>> JustCefProcess::CreateWindowAsync(const WindowCreateOptions& options)
 {
     return impl_->CreateWindowAsync(options);
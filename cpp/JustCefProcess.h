@@ -22,6 +22,44 @@ struct StartOptions
     std::string arguments;
     std::optional<std::filesystem::path> native_executable_path;
     std::optional<std::filesystem::path> working_directory;
+    // Offer a shared-memory ring transport to justcefnative (Linux only). Falls back to pipes when the
+    // native runtime does not accept it.
+    bool shared_memory_transport = false;
+    std::size_t shared_memory_ring_size = 16 * 1024 * 1024;
+    // Largest packet either side may send, clamped to [1 MB, 10 MB]. justcefnative reports the value it accepted
+    // when it is ready and both sides keep to that.
+    std::size_t max_packet_size = 10 * 1024 * 1024;
+    // Request bodies, proxied responses and payloads above this many bytes are streamed instead of sent inline,
+    // even when they would fit a packet.
+    std::size_t inline_payload_threshold = 10 * 1024 * 1024;
+    // Most bytes one incoming stream may buffer before its sender has to wait, by what the stream carries. 0 keeps
+    // the 10 MB default and both sides raise smaller values to one credit window. Proxied response bodies are
+    // buffered by justcefnative, binary payloads by this controller, request bodies and bridge payloads by both.
+    std::size_t proxy_response_stream_capacity = 0;
+    std::size_t request_body_stream_capacity = 0;
+    std::size_t bridge_payload_stream_capacity = 0;
+    std::size_t binary_payload_stream_capacity = 0;
+    // Most bytes all incoming streams of one process may buffer together, applied to this controller and to
+    // justcefnative separately. 0 keeps the 128 MB default.
+    std::size_t stream_memory_limit = 0;
+};
+
+// Packets waiting for the transport, by priority class: responses go first, then other requests and
+// notifications, then stream data shared fairly between streams.
+struct OutboundQueueStats
+{
+    std::size_t response_bytes = 0;
+    std::size_t control_bytes = 0;
+    std::size_t stream_bytes = 0;
+    std::size_t waiting_writers = 0;
+};
+
+// Bytes buffered in incoming streams against the process-wide stream memory limit, peak since start.
+struct StreamMemoryStats
+{
+    std::size_t limit = 0;
+    std::size_t current = 0;
+    std::size_t peak = 0;
 };
 
 struct WindowCreateOptions
@@ -67,6 +105,9 @@ public:
     void Start(const StartOptions& options);
 
     bool HasExited() const;
+    OutboundQueueStats GetOutboundQueueStats() const;
+    // Streams buffered by this controller, GetNativeStreamMemoryStatsAsync reports the ones of justcefnative.
+    StreamMemoryStats GetStreamMemoryStats() const;
     std::vector<std::shared_ptr<JustCefWindow>> Windows() const;
     std::shared_ptr<JustCefWindow> GetWindow(int identifier) const;
 
@@ -78,6 +119,7 @@ public:
     asio::awaitable<void> EchoAsync(std::vector<std::uint8_t> data);
     asio::awaitable<void> PingAsync();
     asio::awaitable<void> PrintAsync(std::string message);
+    asio::awaitable<StreamMemoryStats> GetNativeStreamMemoryStatsAsync();
 
     asio::awaitable<std::shared_ptr<JustCefWindow>> CreateWindowAsync(const WindowCreateOptions& options);
     asio::awaitable<std::shared_ptr<JustCefWindow>> CreateWindowAsync(std::string url, int minimum_width, int minimum_height, int preferred_width = 0, int preferred_height = 0,
@@ -563,6 +563,21 @@ asio::awaitable<void> JustCefWindow::RemoveDomainToProxyAsync(std::string domain
     return RequireProcess(command_target_)->WindowRemoveDomainToProxyAsync(Identifier(), std::move(domain));
 }
 
+asio::awaitable<void> JustCefWindow::SetRequestRewriteRulesAsync(std::vector<RequestRewriteRule> rules)
+{
+    return RequireProcess(command_target_)->WindowSetRequestRewriteRulesAsync(Identifier(), std::move(rules));
+}
+
+asio::awaitable<void> JustCefWindow::AddUrlPatternToProxyAsync(UrlPatternKind kind, std::string pattern)
+{
+    return RequireProcess(command_target_)->WindowAddUrlPatternToProxyAsync(Identifier(), kind, std::move(pattern));
+}
+
+asio::awaitable<void> JustCefWindow::RemoveUrlPatternToProxyAsync(UrlPatternKind kind, std::string pattern)
+{
+    return RequireProcess(command_target_)->WindowRemoveUrlPatternToProxyAsync(Identifier(), kind, std::move(pattern));
+}
+
 asio::awaitable<void> JustCefWindow::AddUrlToModifyAsync(std::string url)
 {
     return RequireProcess(command_target_)->WindowAddUrlToModifyAsync(Identifier(), std::move(url));
@@ -607,6 +622,31 @@ asio::awaitable<void> JustCefWindow::SetModifyRequestsAsync(bool modify_requests
     return RequireProcess(command_target_)->WindowSetModifyRequestsAsync(Identifier(), modify_requests, modify_body);
 }
 
+asio::awaitable<void> JustCefWindow::SetProxyCacheAsync(std::size_t capacity_bytes)
+{
+    return RequireProcess(command_target_)->WindowSetProxyCacheAsync(Identifier(), capacity_bytes);
+}
+
+asio::awaitable<std::uint32_t> JustCefWindow::PurgeProxyCacheAsync(std::string url, bool prefix)
+{
+    return RequireProcess(command_target_)->WindowPurgeProxyCacheAsync(Identifier(), std::move(url), prefix);
+}
+
+asio::awaitable<ProxyCacheStats> JustCefWindow::GetProxyCacheStatsAsync()
+{
+    return RequireProcess(command_target_)->WindowGetProxyCacheStatsAsync(Identifier());
+}
+
+asio::awaitable<bool> JustCefWindow::MountAsync(std::string url_prefix, std::string path)
+{
+    return RequireProcess(command_target_)->WindowMountAsync(Identifier(), std::move(url_prefix), std::move(path));
+}
+
+asio::awaitable<bool> JustCefWindow::UnmountAsync(std::string url_prefix)
+{
+    return RequireProcess(command_target_)->WindowUnmountAsync(Identifier(), std::move(url_prefix));
+}
+
 void JustCefWindow::SetRequestProxy(RequestProxy request_proxy)
 {
     std::lock_guard<std::mutex> lock(shared_->request_mutex);
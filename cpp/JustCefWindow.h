@@ -104,6 +104,9 @@ public:
     asio::awaitable<void> RemoveUrlToProxyAsync(std::string url);
     asio::awaitable<void> AddDomainToProxyAsync(std::string domain);
     asio::awaitable<void> RemoveDomainToProxyAsync(std::string domain);
+    // Proxies every request whose URL starts with or, for Glob, matches pattern. Exact behaves like AddUrlToProxyAsync.
+    asio::awaitable<void> AddUrlPatternToProxyAsync(UrlPatternKind kind, std::string pattern);
+    asio::awaitable<void> RemoveUrlPatternToProxyAsync(UrlPatternKind kind, std::string pattern);
     asio::awaitable<void> AddUrlToModifyAsync(std::string url);
     asio::awaitable<void> RemoveUrlToModifyAsync(std::string url);
     asio::awaitable<void> AddDevToolsEventMethod(std::string method);
@@ -111,6 +114,22 @@ public:
     asio::awaitable<void> CenterSelfAsync();
     asio::awaitable<void> SetProxyRequestsAsync(bool proxy_requests);
     asio::awaitable<void> SetModifyRequestsAsync(bool modify_requests, bool modify_body);
+    // Replaces the window's rewrite rules. They are applied in order inside justcefnative to every request, before
+    // and without a RequestModifier round trip; set_headers/remove_headers/rewrite_url of all matching rules are
+    // applied until a blocking rule cancels the request. A URL rewrite becomes a redirect and is done once per request.
+    asio::awaitable<void> SetRequestRewriteRulesAsync(std::vector<RequestRewriteRule> rules);
+    // Caches proxied responses natively following their Cache-Control/ETag/Last-Modified headers, so fresh ones are
+    // served without calling the RequestProxy. Zero capacity turns the cache off.
+    asio::awaitable<void> SetProxyCacheAsync(std::size_t capacity_bytes);
+    // Drops the entry for url, or with prefix every entry whose URL starts with it. Returns the number removed.
+    asio::awaitable<std::uint32_t> PurgeProxyCacheAsync(std::string url, bool prefix = false);
+    asio::awaitable<ProxyCacheStats> GetProxyCacheStatsAsync();
+    // Serves URLs under url_prefix straight from the directory at path inside justcefnative, without a RequestProxy
+    // round trip. path may also be an asset pack written by BuildAssetPack, which is memory-mapped and served with its
+    // precompressed variants. Mounts take precedence over proxying and a URL under a mount that names no file gets a
+    // 404. Returns false when path is neither a directory nor a valid pack.
+    asio::awaitable<bool> MountAsync(std::string url_prefix, std::string path);
+    asio::awaitable<bool> UnmountAsync(std::string url_prefix);
 
     void SetRequestProxy(RequestProxy request_proxy);
     void SetRequestProxy(SyncRequestProxy request_proxy);
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace justcef::detail
+{
+
+// Priority classes of outbound packets, highest first.
+enum class OutboundClass : std::uint8_t
+{
+    // Replies the other side is blocked on.
+    Response = 0,
+    // Requests and notifications other than stream traffic.
+    Control = 1,
+    // StreamOpen/StreamData/StreamEnd/StreamClose and StreamData notifications.
+    Stream = 2,
+};
+
+constexpr std::size_t kOutboundClassCount = 3;
+
+// Decides which waiting packet goes out next. Responses go before control packets and control packets before stream
+// packets. Stream packets are queued per stream identifier and served by deficit round robin with kStreamQuantum
+// bytes per turn, so one large transfer cannot starve another. Order is kept within a class and, for streams, within
+// one identifier. Not thread safe, the owner locks around it.
+//
+// Same layout as native/src/outbound_scheduler.h.
+template <typename T> class OutboundScheduler
+{
+public:
+    static constexpr std::size_t kStreamQuantum = 64 * 1024;
+
+    void Push(OutboundClass outbound_class, std::uint32_t stream_id, std::size_t bytes, T item)
+    {
+        pending_bytes_[static_cast<std::size_t>(outbound_class)] += bytes;
+        ++size_;
+        if (outbound_class != OutboundClass::Stream)
+        {
+            queues_[static_cast<std::size_t>(outbound_class)].push_back(Entry{bytes, std::move(item)});
+            return;
+        }
+
+        StreamQueue& stream = streams_[stream_id];
+        if (stream.entries.empty())
+        {
+            active_streams_.push_back(stream_id);
+        }
+        stream.entries.push_back(Entry{bytes, std::move(item)});
+    }
+
+    bool Empty() const { return size_ == 0; }
+    std::size_t Size() const { return size_; }
+    std::size_t PendingBytes(OutboundClass outbound_class) const { return pending_bytes_[static_cast<std::size_t>(outbound_class)]; }
+
+    // The item Pop returns next. Must not be called when empty.
+    T& Front() { return SelectFront().item; }
+
+    T Pop()
+    {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(OutboundClass::Stream); ++i)
+        {
+            if (queues_[i].empty())
+            {
+                continue;
+            }
+
+            Entry entry = std::move(queues_[i].front());
+            queues_[i].pop_front();
+            Account(static_cast<OutboundClass>(i), entry.bytes);
+            return std::move(entry.item);
+        }
+
+        SelectFront();
+        const std::uint32_t stream_id = active_streams_.front();
+        const auto iterator = streams_.find(stream_id);
+        Entry entry = std::move(iterator->second.entries.front());
+        iterator->second.entries.pop_front();
+        iterator->second.deficit -= entry.bytes;
+        if (iterator->second.entries.empty())
+        {
+            // An idle stream does not keep its unused deficit.
+            streams_.erase(iterator);
+            active_streams_.pop_front();
+            turn_started_ = false;
+        }
+        Account(OutboundClass::Stream, entry.bytes);
+        return std::move(entry.item);
+    }
+
+    // Removes everything, highest class first.
+    std::vector<T> TakeAll()
+    {
+        std::vector<T> items;
+        items.reserve(size_);
+        while (!Empty())
+        {
+            items.push_back(Pop());
+        }
+        return items;
+    }
+
+private:
+    struct Entry
+    {
+        std::size_t bytes = 0;
+        T item;
+    };
+
+    struct StreamQueue
+    {
+        std::deque<Entry> entries;
+        std::size_t deficit = 0;
+    };
+
+    Entry& SelectFront()
+    {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(OutboundClass::Stream); ++i)
+        {
+            if (!queues_[i].empty())
+            {
+                return queues_[i].front();
+            }
+        }
+
+        // The stream at the head of the rotation gets one quantum per turn and keeps the turn while its next packet
+        // fits, otherwise it moves to the back with what it has left.
+        for (;;)
+        {
+            const std::uint32_t stream_id = active_streams_.front();
+            StreamQueue& stream = streams_[stream_id];
+            if (!turn_started_)
+            {
+                stream.deficit += kStreamQuantum;
+                turn_started_ = true;
+            }
+            if (stream.entries.front().bytes <= stream.deficit)
+            {
+                return stream.entries.front();
+            }
+
+            active_streams_.pop_front();
+            active_streams_.push_back(stream_id);
+            turn_started_ = false;
+        }
+    }
+
+    void Account(OutboundClass outbound_class, std::size_t bytes)
+    {
+        pending_bytes_[static_cast<std::size_t>(outbound_class)] -= bytes;
+        --size_;
+    }
+
+    std::deque<Entry> queues_[static_cast<std::size_t>(OutboundClass::Stream)];
+    std::unordered_map<std::uint32_t, StreamQueue> streams_;
+    std::deque<std::uint32_t> active_streams_;
+    bool turn_started_ = false;
+    std::size_t pending_bytes_[kOutboundClassCount] = {};
+    std::size_t size_ = 0;
+};
+
+} // namespace justcef::detail
@@ -18,6 +18,8 @@ enum class PacketType : std::uint8_t
     Request = 0,
     Response = 1,
     Notification = 2,
+    // Slice of a larger packet, see kLaneFragmentSize.
+    Fragment = 3,
 };
 
 enum class StreamDataStatus : std::uint8_t
@@ -87,13 +89,25 @@ enum class OpcodeController : uint8_t
     WindowRemoveDomainToProxy = 55,
     WindowGetZoom = 56,
     WindowBridgeRpc = 57,
-    StreamEnd = 58
+    StreamEnd = 58,
+    WindowSetProxyCache = 59,
+    WindowPurgeProxyCache = 60,
+    WindowGetProxyCacheStats = 61,
+    WindowMount = 62,
+    WindowUnmount = 63,
+    WindowAddUrlPatternToProxy = 64,
+    WindowRemoveUrlPatternToProxy = 65,
+    WindowSetRequestRewriteRules = 66,
+    GetStreamMemoryStats = 67
 };
 
 // Notifications from controller
 enum class OpcodeControllerNotification : uint8_t
 {
-    Exit = 0
+    Exit = 0,
+    TransportSwitch = 1,
+    StreamData = 2,
+    StreamCredit = 3
 };
 
 // Requests from client
@@ -132,12 +146,42 @@ enum class OpcodeClientNotification : uint8_t
     WindowFrameLoadEnd = 14,
     WindowFrameLoadError = 15,
     WindowDevToolsEvent = 16,
-    WindowLoadingStateChanged = 17
+    WindowLoadingStateChanged = 17,
+    TransportSwitch = 18,
+    StreamData = 19,
+    StreamCredit = 20
 };
 
+// Bounds of the negotiated packet size. The controller passes StartOptions::max_packet_size and
+// inline_payload_threshold as --ipc-max-packet-size/--ipc-inline-threshold, and the Ready notification carries
+// the values justcefnative accepted (uint32 maxPacketSize, uint32 inlineThreshold). An empty Ready comes from an
+// older runtime that still uses kMaxIpcSize. The minimum keeps the largest stream chunk within one packet.
 constexpr std::size_t kMaxIpcSize = 10 * 1024 * 1024;
+constexpr std::size_t kMinIpcSize = 1024 * 1024;
+
+// Stream data travels as StreamData notifications (uint32 streamId, bytes) within a credit window. The receiver
+// returns consumed bytes with StreamCredit notifications (uint32 streamId, uint32 credit, uint8 StreamDataStatus),
+// a non-Accepted status tells the sender to stop. Chunk sizes adapt per stream, see StreamChunkSizer.h.
+// Keep in sync with native/src/ipc.h.
+constexpr std::size_t kStreamInitialCredit = 1024 * 1024;
+constexpr std::size_t kStreamCreditThreshold = 256 * 1024;
 constexpr std::size_t kPacketHeaderSize = 10;
 
+// Protocol extensions this controller understands, passed to justcefnative as --ipc-capabilities. Without them
+// justcefnative falls back to the protocol the C# controller speaks. justcefnative reports the ones it accepts in
+// Ready with the same bits, an older runtime reports none. Keep in sync with native/src/ipc.h.
+constexpr std::uint32_t kControllerCapabilityStreamCredit = 0x01;
+constexpr std::uint32_t kControllerCapabilityFragments = 0x02;
+constexpr std::uint32_t kControllerCapabilities = kControllerCapabilityStreamCredit | kControllerCapabilityFragments;
+
+// justcefnative writes the stream family and all other traffic as two lanes, ordered within a lane only. Packets
+// above kLaneFragmentSize travel as Fragment frames holding the next slice of the serialized packet, kFragmentLast
+// marks the final one. The frame request id names the lane (kFragmentLaneCount of them), each lane fragments one
+// packet at a time. This controller sends all its fragments as lane 0. Keep in sync with native/src/ipc.h.
+constexpr std::size_t kFragmentLaneCount = 2;
+constexpr std::size_t kLaneFragmentSize = 128 * 1024;
+constexpr std::uint8_t kFragmentLast = 0x01;
+
 struct PacketHeader
 {
     std::uint32_t size = 0;
@@ -276,6 +320,8 @@ public:
 
     const std::vector<std::uint8_t>& Buffer() const { return buffer_; }
 
+    std::vector<std::uint8_t> TakeBuffer() { return std::move(buffer_); }
+
 private:
     std::vector<std::uint8_t> buffer_;
     std::size_t max_size_;
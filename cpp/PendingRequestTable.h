@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace justcef::detail
+{
+
+// Fixed-capacity table of in-flight requests. A request id is the slot index in the low IndexBits and a per-slot
+// generation above it, so a late response for a recycled slot is rejected without a map lookup. Slots go
+// Free -> Pending -> Taking -> Free with atomic transitions and free slots live on a tagged lock-free stack, so
+// issuing and completing requests never takes a lock or allocates.
+//
+// Same layout as native/src/pending_request_table.h.
+template <typename T, std::uint32_t IndexBits = 13> class PendingRequestTable
+{
+public:
+    static constexpr std::uint32_t kCapacity = 1u << IndexBits;
+
+    PendingRequestTable() : slots_(new Slot[kCapacity])
+    {
+        for (std::uint32_t i = 0; i < kCapacity; i++)
+        {
+            slots_[i].next_free.store(i + 1 < kCapacity ? i + 2 : 0, std::memory_order_relaxed);
+        }
+        free_head_.store(1, std::memory_order_relaxed);
+    }
+
+    PendingRequestTable(const PendingRequestTable&) = delete;
+    PendingRequestTable& operator=(const PendingRequestTable&) = delete;
+
+    // Moves payload in and returns its request id (never 0). When the table is full payload is left untouched.
+    std::optional<std::uint32_t> Insert(T&& payload)
+    {
+        const std::optional<std::uint32_t> index = PopFree();
+        if (!index)
+        {
+            return std::nullopt;
+        }
+
+        Slot& slot = slots_[*index];
+        const std::uint32_t generation = NextGeneration(StateGeneration(slot.state.load(std::memory_order_relaxed)));
+        slot.payload = std::move(payload);
+        slot.state.store(MakeState(generation, SlotState::Pending), std::memory_order_release);
+        return (generation << IndexBits) | *index;
+    }
+
+    // Removes the request and hands its payload to the caller. Exactly one Take succeeds per Insert.
+    std::optional<T> Take(std::uint32_t request_id)
+    {
+        const std::uint32_t index = request_id & kIndexMask;
+        const std::uint32_t generation = request_id >> IndexBits;
+
+        std::uint32_t expected = MakeState(generation, SlotState::Pending);
+        if (!slots_[index].state.compare_exchange_strong(expected, MakeState(generation, SlotState::Taking), std::memory_order_acq_rel))
+        {
+            return std::nullopt;
+        }
+
+        return Release(index, generation);
+    }
+
+    template <typename F> void TakeAll(F&& callback)
+    {
+        for (std::uint32_t index = 0; index < kCapacity; index++)
+        {
+            std::uint32_t state = slots_[index].state.load(std::memory_order_acquire);
+            if (StateValue(state) != SlotState::Pending)
+            {
+                continue;
+            }
+
+            const std::uint32_t generation = StateGeneration(state);
+            if (slots_[index].state.compare_exchange_strong(state, MakeState(generation, SlotState::Taking), std::memory_order_acq_rel))
+            {
+                callback(Release(index, generation));
+            }
+        }
+    }
+
+    std::size_t InFlight() const { return in_flight_.load(std::memory_order_relaxed); }
+
+private:
+    enum class SlotState : std::uint32_t
+    {
+        Free = 0,
+        Pending = 1,
+        Taking = 3
+    };
+
+    struct alignas(64) Slot
+    {
+        std::atomic<std::uint32_t> state = 0;
+        std::atomic<std::uint32_t> next_free = 0;
+        T payload{};
+    };
+
+    static constexpr std::uint32_t kIndexMask = kCapacity - 1;
+    static constexpr std::uint32_t kGenerationMask = (1u << (32 - IndexBits)) - 1;
+
+    static std::uint32_t MakeState(std::uint32_t generation, SlotState state) { return (generation << 2) | static_cast<std::uint32_t>(state); }
+    static std::uint32_t StateGeneration(std::uint32_t state) { return state >> 2; }
+    static SlotState StateValue(std::uint32_t state) { return static_cast<SlotState>(state & 3); }
+
+    static std::uint32_t NextGeneration(std::uint32_t generation)
+    {
+        generation = (generation + 1) & kGenerationMask;
+        return generation == 0 ? 1 : generation;
+    }
+
+    T Release(std::uint32_t index, std::uint32_t generation)
+    {
+        Slot& slot = slots_[index];
+        T payload = std::move(slot.payload);
+        slot.payload = T{};
+        slot.state.store(MakeState(generation, SlotState::Free), std::memory_order_release);
+        PushFree(index);
+        return payload;
+    }
+
+    // The head packs an ABA tag in the upper 32 bits and index + 1 in the lower 32 bits, 0 meaning empty.
+    std::optional<std::uint32_t> PopFree()
+    {
+        std::uint64_t head = free_head_.load(std::memory_order_acquire);
+        while (true)
+        {
+            const auto top = static_cast<std::uint32_t>(head);
+            if (top == 0)
+            {
+                return std::nullopt;
+            }
+
+            const std::uint32_t next = slots_[top - 1].next_free.load(std::memory_order_relaxed);
+            const std::uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+            if (free_head_.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                in_flight_.fetch_add(1, std::memory_order_relaxed);
+                return top - 1;
+            }
+        }
+    }
+
+    void PushFree(std::uint32_t index)
+    {
+        std::uint64_t head = free_head_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            slots_[index].next_free.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+            const std::uint64_t new_head = (((head >> 32) + 1) << 32) | (index + 1);
+            if (free_head_.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<std::uint64_t> free_head_ = 0;
+    std::atomic<std::size_t> in_flight_ = 0;
+};
+
+} // namespace justcef::detail
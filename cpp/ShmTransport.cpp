@@ -0,0 +1,288 @@
+#include "ShmTransport.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace justcef::detail
+{
+namespace
+{
+
+#ifdef __linux__
+constexpr long kWaitTimeoutNs = 200 * 1000 * 1000;
+
+int FutexWait(std::atomic<std::uint32_t>* address, std::uint32_t expected, const timespec* timeout)
+{
+    return static_cast<int>(::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(address), FUTEX_WAIT, expected, timeout, nullptr, 0));
+}
+
+void FutexWakeAll(std::atomic<std::uint32_t>* address)
+{
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(address), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+#endif
+
+std::size_t RoundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t result = 4096;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+ShmTransport::~ShmTransport()
+{
+    Close();
+#ifdef __linux__
+    if (header_ != nullptr)
+    {
+        ::munmap(header_, mapping_size_);
+        header_ = nullptr;
+    }
+#endif
+}
+
+bool ShmTransport::IsSupported()
+{
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+int ShmTransport::Create(std::size_t ring_capacity)
+{
+#ifdef __linux__
+    const std::size_t capacity = RoundUpToPowerOfTwo(ring_capacity);
+    const std::size_t mapping_size = sizeof(ShmTransportHeader) + 2 * capacity;
+
+    const int fd = ::memfd_create("justcef-ipc", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to create shared memory transport.");
+    }
+
+    if (::ftruncate(fd, static_cast<off_t>(mapping_size)) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Failed to size shared memory transport.");
+    }
+
+    void* mapping = ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ::close(fd);
+        throw std::runtime_error("Failed to map shared memory transport.");
+    }
+
+    header_ = new (mapping) ShmTransportHeader{};
+    header_->magic = kShmTransportMagic;
+    header_->version = kShmTransportVersion;
+    header_->ring_capacity = static_cast<std::uint32_t>(capacity);
+
+    auto* base = static_cast<std::uint8_t*>(mapping);
+    mapping_size_ = mapping_size;
+    capacity_ = capacity;
+    write_ring_ = base + sizeof(ShmTransportHeader);
+    read_ring_ = base + sizeof(ShmTransportHeader) + capacity;
+    write_control_ = &header_->parent_to_child;
+    read_control_ = &header_->child_to_parent;
+    return fd;
+#else
+    (void)ring_capacity;
+    throw std::runtime_error("Shared memory transport is not supported on this platform.");
+#endif
+}
+
+std::size_t ShmTransport::Read(void* buffer, std::size_t size)
+{
+    if (header_ == nullptr)
+    {
+        return 0;
+    }
+
+    auto* bytes = static_cast<std::uint8_t*>(buffer);
+    std::size_t total = 0;
+    while (total < size)
+    {
+        const std::uint64_t read_position = read_control_->read_position.load(std::memory_order_relaxed);
+        const std::uint64_t write_position = read_control_->write_position.load(std::memory_order_acquire);
+        const auto available = static_cast<std::size_t>(write_position - read_position);
+        if (available == 0)
+        {
+            if (closed_.load() || read_control_->closed.load(std::memory_order_acquire))
+            {
+                break;
+            }
+
+            const std::uint32_t sequence = read_control_->data_sequence.load(std::memory_order_acquire);
+            if (read_control_->write_position.load(std::memory_order_acquire) != read_position)
+            {
+                continue;
+            }
+
+            if (!WaitForChange(read_control_->data_sequence, sequence, read_control_->reader_waiting))
+            {
+                break;
+            }
+            continue;
+        }
+
+        const std::size_t count = std::min(available, size - total);
+        const auto offset = static_cast<std::size_t>(read_position & (capacity_ - 1));
+        const std::size_t first_part = std::min(count, capacity_ - offset);
+        std::memcpy(bytes + total, read_ring_ + offset, first_part);
+        if (count > first_part)
+        {
+            std::memcpy(bytes + total + first_part, read_ring_, count - first_part);
+        }
+
+        read_control_->read_position.store(read_position + count, std::memory_order_release);
+        Wake(read_control_->space_sequence, read_control_->writer_waiting);
+        total += count;
+    }
+    return total;
+}
+
+std::size_t ShmTransport::Write(const void* data, std::size_t size)
+{
+    if (header_ == nullptr)
+    {
+        return 0;
+    }
+
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    std::size_t total = 0;
+    while (total < size)
+    {
+        if (closed_.load() || write_control_->closed.load(std::memory_order_acquire))
+        {
+            break;
+        }
+
+        const std::uint64_t write_position = write_control_->write_position.load(std::memory_order_relaxed);
+        const std::uint64_t read_position = write_control_->read_position.load(std::memory_order_acquire);
+        const std::size_t space = capacity_ - static_cast<std::size_t>(write_position - read_position);
+        if (space == 0)
+        {
+            const std::uint32_t sequence = write_control_->space_sequence.load(std::memory_order_acquire);
+            if (write_control_->read_position.load(std::memory_order_acquire) != read_position)
+            {
+                continue;
+            }
+
+            if (!WaitForChange(write_control_->space_sequence, sequence, write_control_->writer_waiting))
+            {
+                break;
+            }
+            continue;
+        }
+
+        const std::size_t count = std::min(space, size - total);
+        const auto offset = static_cast<std::size_t>(write_position & (capacity_ - 1));
+        const std::size_t first_part = std::min(count, capacity_ - offset);
+        std::memcpy(write_ring_ + offset, bytes + total, first_part);
+        if (count > first_part)
+        {
+            std::memcpy(write_ring_, bytes + total + first_part, count - first_part);
+        }
+
+        write_control_->write_position.store(write_position + count, std::memory_order_release);
+        Wake(write_control_->data_sequence, write_control_->reader_waiting);
+        total += count;
+    }
+    return total;
+}
+
+void ShmTransport::Close()
+{
+    if (header_ == nullptr || closed_.exchange(true))
+    {
+        return;
+    }
+
+    for (ShmRingControl* control : {&header_->parent_to_child, &header_->child_to_parent})
+    {
+        control->closed.store(1, std::memory_order_release);
+        control->data_sequence.fetch_add(1);
+        control->space_sequence.fetch_add(1);
+#ifdef __linux__
+        FutexWakeAll(&control->data_sequence);
+        FutexWakeAll(&control->space_sequence);
+#endif
+    }
+}
+
+bool ShmTransport::WaitForChange(std::atomic<std::uint32_t>& sequence, std::uint32_t expected, std::atomic<std::uint32_t>& waiting)
+{
+#ifdef __linux__
+    waiting.fetch_add(1);
+    bool alive = true;
+    while (sequence.load() == expected && !closed_.load())
+    {
+        timespec timeout{0, kWaitTimeoutNs};
+        if (FutexWait(&sequence, expected, &timeout) != 0 && errno == ETIMEDOUT && !PeerAlive())
+        {
+            alive = false;
+            break;
+        }
+    }
+    waiting.fetch_sub(1);
+    return alive && !closed_.load();
+#else
+    (void)sequence;
+    (void)expected;
+    (void)waiting;
+    return false;
+#endif
+}
+
+void ShmTransport::Wake(std::atomic<std::uint32_t>& sequence, std::atomic<std::uint32_t>& waiting)
+{
+    sequence.fetch_add(1);
+#ifdef __linux__
+    if (waiting.load() > 0)
+    {
+        FutexWakeAll(&sequence);
+    }
+#else
+    (void)waiting;
+#endif
+}
+
+bool ShmTransport::PeerAlive() const
+{
+#ifdef __linux__
+    if (liveness_read_handle_ == -1)
+    {
+        return true;
+    }
+
+    pollfd descriptor{liveness_read_handle_, POLLIN, 0};
+    if (::poll(&descriptor, 1, 0) > 0 && (descriptor.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0)
+    {
+        return false;
+    }
+#endif
+    return true;
+}
+
+} // namespace justcef::detail
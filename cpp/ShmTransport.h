@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace justcef::detail
+{
+
+// Shared-memory byte transport offered to justcefnative with --ipc-shm. One memfd region holds a ring per
+// direction; packet framing is unchanged, the rings only replace the pipes as the byte carrier once both
+// sides exchanged a TransportSwitch notification. The pipes stay open so a dead peer is still detected.
+//
+// Keep the layout in sync with native/src/shm_transport.h.
+
+constexpr std::uint32_t kShmTransportMagic = 0x4A43534D; // 'JCSM'
+constexpr std::uint32_t kShmTransportVersion = 1;
+constexpr std::size_t kDefaultShmRingCapacity = 16 * 1024 * 1024;
+
+struct alignas(64) ShmRingControl
+{
+    alignas(64) std::atomic<std::uint64_t> write_position;
+    alignas(64) std::atomic<std::uint64_t> read_position;
+    alignas(64) std::atomic<std::uint32_t> data_sequence;
+    std::atomic<std::uint32_t> space_sequence;
+    std::atomic<std::uint32_t> reader_waiting;
+    std::atomic<std::uint32_t> writer_waiting;
+    std::atomic<std::uint32_t> closed;
+};
+
+struct alignas(64) ShmTransportHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t ring_capacity;
+    std::uint32_t reserved;
+    ShmRingControl parent_to_child;
+    ShmRingControl child_to_parent;
+};
+
+class ShmTransport
+{
+public:
+    ShmTransport() = default;
+    ~ShmTransport();
+
+    ShmTransport(const ShmTransport&) = delete;
+    ShmTransport& operator=(const ShmTransport&) = delete;
+
+    static bool IsSupported();
+
+    // Creates the region and returns the memfd that must be inherited by the child. The caller closes it
+    // once the child has been spawned.
+    int Create(std::size_t ring_capacity);
+    void SetLivenessHandle(int read_handle) { liveness_read_handle_ = read_handle; }
+    bool IsCreated() const { return header_ != nullptr; }
+
+    // Same contract as the pipe helpers: returns the number of bytes moved, short counts mean the peer is gone.
+    std::size_t Read(void* buffer, std::size_t size);
+    std::size_t Write(const void* data, std::size_t size);
+    void Close();
+
+private:
+    bool WaitForChange(std::atomic<std::uint32_t>& sequence, std::uint32_t expected, std::atomic<std::uint32_t>& waiting);
+    void Wake(std::atomic<std::uint32_t>& sequence, std::atomic<std::uint32_t>& waiting);
+    bool PeerAlive() const;
+
+    ShmTransportHeader* header_ = nullptr;
+    std::uint8_t* read_ring_ = nullptr;
+    std::uint8_t* write_ring_ = nullptr;
+    ShmRingControl* read_control_ = nullptr;
+    ShmRingControl* write_control_ = nullptr;
+    std::size_t mapping_size_ = 0;
+    std::size_t capacity_ = 0;
+    int liveness_read_handle_ = -1;
+    std::atomic<bool> closed_ = false;
+};
+
+} // namespace justcef::detail
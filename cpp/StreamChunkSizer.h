@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace justcef::detail
+{
+
+// Picks the data size of the next StreamData packet of one stream. Sizes step through the receive buffer pool
+// classes (16 KB, 64 KB, 256 KB, 1 MB) minus the stream id, so a chunk fills its class exactly. A chunk that moves in
+// less than half of kTargetChunkTime takes the size one step up, one slower than twice of it one step down. A producer
+// that hands over less than a chunk pulls the size down to what it delivers, so interactive streams stay small.
+//
+// Same layout as native/src/stream_chunk_sizer.h.
+class StreamChunkSizer
+{
+public:
+    static constexpr std::size_t kMinChunkClass = 16 * 1024;
+    static constexpr std::size_t kMaxChunkClass = 1024 * 1024;
+    static constexpr std::size_t kInitialChunkClass = 64 * 1024;
+    static constexpr std::size_t kChunkClassStep = 4;
+    static constexpr std::chrono::microseconds kTargetChunkTime{4000};
+
+    std::size_t ChunkSize() const { return chunk_class_ - sizeof(std::uint32_t); }
+
+    // bytes took elapsed to go through, from the write or from the credit the receiver returned for them.
+    void RecordTransfer(std::size_t bytes, std::chrono::steady_clock::duration elapsed)
+    {
+        if (bytes == 0)
+        {
+            return;
+        }
+
+        // Time a whole chunk of the current size would take at the observed rate.
+        const auto chunk_time = std::chrono::duration_cast<std::chrono::microseconds>(elapsed) * static_cast<std::int64_t>(chunk_class_) / static_cast<std::int64_t>(bytes);
+        if (chunk_time * 2 < kTargetChunkTime && chunk_class_ < kMaxChunkClass)
+        {
+            chunk_class_ *= kChunkClassStep;
+        }
+        else if (chunk_time > kTargetChunkTime * 2 && chunk_class_ > kMinChunkClass)
+        {
+            chunk_class_ /= kChunkClassStep;
+        }
+    }
+
+    // The producer had only bytes ready when a full chunk was asked for.
+    void RecordShortChunk(std::size_t bytes)
+    {
+        while (chunk_class_ > kMinChunkClass && bytes + sizeof(std::uint32_t) <= chunk_class_ / kChunkClassStep)
+        {
+            chunk_class_ /= kChunkClassStep;
+        }
+    }
+
+private:
+    std::size_t chunk_class_ = kInitialChunkClass;
+};
+
+} // namespace justcef::detail
@@ -52,6 +52,9 @@ public:
     virtual asio::awaitable<void> WindowRemoveUrlToProxyAsync(int identifier, std::string url) = 0;
     virtual asio::awaitable<void> WindowAddDomainToProxyAsync(int identifier, std::string domain) = 0;
     virtual asio::awaitable<void> WindowRemoveDomainToProxyAsync(int identifier, std::string domain) = 0;
+    virtual asio::awaitable<void> WindowSetRequestRewriteRulesAsync(int identifier, std::vector<RequestRewriteRule> rules) = 0;
+    virtual asio::awaitable<void> WindowAddUrlPatternToProxyAsync(int identifier, UrlPatternKind kind, std::string pattern) = 0;
+    virtual asio::awaitable<void> WindowRemoveUrlPatternToProxyAsync(int identifier, UrlPatternKind kind, std::string pattern) = 0;
     virtual asio::awaitable<void> WindowAddUrlToModifyAsync(int identifier, std::string url) = 0;
     virtual asio::awaitable<void> WindowRemoveUrlToModifyAsync(int identifier, std::string url) = 0;
     virtual asio::awaitable<void> WindowAddDevToolsEventMethod(int identifier, std::string method) = 0;
@@ -59,6 +62,11 @@ public:
     virtual asio::awaitable<void> WindowCenterSelfAsync(int identifier) = 0;
     virtual asio::awaitable<void> WindowSetProxyRequestsAsync(int identifier, bool enable_proxy_requests) = 0;
     virtual asio::awaitable<void> WindowSetModifyRequestsAsync(int identifier, bool enable_modify_requests, bool enable_modify_body) = 0;
+    virtual asio::awaitable<void> WindowSetProxyCacheAsync(int identifier, std::size_t capacity_bytes) = 0;
+    virtual asio::awaitable<std::uint32_t> WindowPurgeProxyCacheAsync(int identifier, std::string url, bool prefix) = 0;
+    virtual asio::awaitable<ProxyCacheStats> WindowGetProxyCacheStatsAsync(int identifier) = 0;
+    virtual asio::awaitable<bool> WindowMountAsync(int identifier, std::string url_prefix, std::string path) = 0;
+    virtual asio::awaitable<bool> WindowUnmountAsync(int identifier, std::string url_prefix) = 0;
 };
 
 struct WindowShared
@@ -0,0 +1,142 @@
+#include "asset_pack.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+// offset + size fits into limit without overflowing.
+bool InBounds(uint64_t offset, uint64_t size, uint64_t limit)
+{
+    return offset <= limit && size <= limit - offset;
+}
+
+} // namespace
+
+AssetPack::~AssetPack()
+{
+#ifdef _WIN32
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    if (_file && _file != INVALID_HANDLE_VALUE)
+        CloseHandle(_file);
+#else
+    if (_data)
+        munmap((void*)_data, _size);
+#endif
+}
+
+std::shared_ptr<AssetPack> AssetPack::Open(const std::filesystem::path& path)
+{
+    std::shared_ptr<AssetPack> pack(new AssetPack());
+
+#ifdef _WIN32
+    // FILE_SHARE_DELETE lets justcef-pack rename a rebuilt pack over this one while it stays mapped.
+    pack->_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (pack->_file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(pack->_file, &size) || size.QuadPart < (LONGLONG)sizeof(AssetPackHeader))
+        return nullptr;
+
+    pack->_mapping = CreateFileMappingW(pack->_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!pack->_mapping)
+        return nullptr;
+
+    pack->_data = (const uint8_t*)MapViewOfFile(pack->_mapping, FILE_MAP_READ, 0, 0, 0);
+    pack->_size = (size_t)size.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(AssetPackHeader))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    pack->_data = (const uint8_t*)data;
+    pack->_size = (size_t)st.st_size;
+#endif
+
+    if (!pack->_data || !pack->Validate())
+        return nullptr;
+    return pack;
+}
+
+bool AssetPack::Validate()
+{
+    memcpy(&_header, _data, sizeof(_header));
+    if (_header.magic != kAssetPackMagic || _header.version != kAssetPackVersion)
+        return false;
+
+    // Buckets are a power of two with at least one free slot, so probing always ends.
+    if (_header.bucketCount == 0 || (_header.bucketCount & (_header.bucketCount - 1)) != 0 || _header.bucketCount <= _header.entryCount)
+        return false;
+    if (_header.entriesOffset % alignof(AssetPackEntry) != 0 || _header.bucketsOffset % alignof(uint32_t) != 0)
+        return false;
+    if (!InBounds(_header.entriesOffset, (uint64_t)_header.entryCount * sizeof(AssetPackEntry), _size) ||
+        !InBounds(_header.bucketsOffset, (uint64_t)_header.bucketCount * sizeof(uint32_t), _size) || !InBounds(_header.stringsOffset, _header.stringsSize, _size))
+        return false;
+
+    _entries = (const AssetPackEntry*)(_data + _header.entriesOffset);
+    _buckets = (const uint32_t*)(_data + _header.bucketsOffset);
+    for (uint32_t i = 0; i < _header.entryCount; i++)
+    {
+        const AssetPackEntry& entry = _entries[i];
+        if (!InBounds(entry.pathOffset, entry.pathLength, _header.stringsSize) || !InBounds(entry.mimeOffset, entry.mimeLength, _header.stringsSize))
+            return false;
+        if (entry.pathHash != AssetPackHash(Path(entry)))
+            return false;
+        for (const AssetPackVariant& variant : entry.variants)
+        {
+            if (!InBounds(variant.offset, variant.size, _size))
+                return false;
+        }
+    }
+    uint32_t usedBuckets = 0;
+    for (uint32_t i = 0; i < _header.bucketCount; i++)
+    {
+        if (_buckets[i] == kAssetPackEmptyBucket)
+            continue;
+        if (_buckets[i] >= _header.entryCount)
+            return false;
+        usedBuckets++;
+    }
+    return usedBuckets < _header.bucketCount;
+}
+
+const AssetPackEntry* AssetPack::Find(std::string_view path) const
+{
+    const uint64_t hash = AssetPackHash(path);
+    const uint32_t mask = _header.bucketCount - 1;
+    for (uint32_t slot = (uint32_t)hash & mask;; slot = (slot + 1) & mask)
+    {
+        const uint32_t index = _buckets[slot];
+        if (index == kAssetPackEmptyBucket)
+            return nullptr;
+
+        const AssetPackEntry& entry = _entries[index];
+        if (entry.pathHash == hash && Path(entry) == path)
+            return &entry;
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <filesystem>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+// On-disk layout of an asset pack as written by the controller's BuildAssetPack. All integers are little endian.
+//
+//   AssetPackHeader
+//   AssetPackEntry[entryCount]
+//   uint32 buckets[bucketCount]      open addressing on AssetPackHash(path), kAssetPackEmptyBucket when free
+//   strings                          paths (relative, '/' separated) and MIME types, not terminated
+//   blobs                            file contents, each variant aligned to kAssetPackAlignment
+//
+// Keep in sync with cpp/AssetPack.h.
+constexpr uint32_t kAssetPackMagic = 0x4B41504A; // "JPAK"
+constexpr uint32_t kAssetPackVersion = 1;
+constexpr uint32_t kAssetPackEmptyBucket = 0xFFFFFFFF;
+constexpr size_t kAssetPackAlignment = 16;
+
+enum class AssetEncoding : uint8_t
+{
+    Identity = 0,
+    Gzip = 1,
+    Brotli = 2
+};
+
+constexpr size_t kAssetEncodingCount = 3;
+
+struct AssetPackHeader
+{
+    uint32_t magic = kAssetPackMagic;
+    uint32_t version = kAssetPackVersion;
+    uint32_t entryCount = 0;
+    uint32_t bucketCount = 0;
+    uint64_t entriesOffset = 0;
+    uint64_t bucketsOffset = 0;
+    uint64_t stringsOffset = 0;
+    uint64_t stringsSize = 0;
+};
+
+struct AssetPackVariant
+{
+    // Absolute file offset, size 0 means the variant is absent. The identity variant is always present.
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+struct AssetPackEntry
+{
+    uint64_t pathHash = 0;
+    uint32_t pathOffset = 0;
+    uint32_t pathLength = 0;
+    // mimeLength is 0 when the extension is unknown.
+    uint32_t mimeOffset = 0;
+    uint32_t mimeLength = 0;
+    AssetPackVariant variants[kAssetEncodingCount];
+};
+
+static_assert(sizeof(AssetPackHeader) == 48, "AssetPackHeader layout changed");
+static_assert(sizeof(AssetPackEntry) == 72, "AssetPackEntry layout changed");
+
+// 64-bit FNV-1a of the relative path.
+constexpr uint64_t AssetPackHash(std::string_view path)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : path)
+    {
+        hash ^= (uint8_t)c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// A memory-mapped asset pack. Open validates every offset once, so lookups afterwards need neither locks nor bounds
+// checks and serving an asset is a page cache read. The mapping lives as long as the object.
+class AssetPack
+{
+public:
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // nullptr when the file is not a valid pack.
+    static std::shared_ptr<AssetPack> Open(const std::filesystem::path& path);
+
+    // nullptr when the pack has no asset at path.
+    const AssetPackEntry* Find(std::string_view path) const;
+    std::string_view Path(const AssetPackEntry& entry) const { return String(entry.pathOffset, entry.pathLength); }
+    std::string_view MimeType(const AssetPackEntry& entry) const { return String(entry.mimeOffset, entry.mimeLength); }
+    const uint8_t* Data(const AssetPackVariant& variant) const { return _data + variant.offset; }
+
+private:
+    AssetPack() = default;
+
+    bool Validate();
+    std::string_view String(uint32_t offset, uint32_t length) const { return std::string_view((const char*)_data + _header.stringsOffset + offset, length); }
+
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    AssetPackHeader _header;
+    const AssetPackEntry* _entries = nullptr;
+    const uint32_t* _buckets = nullptr;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
+
+#endif // ASSET_PACK_H
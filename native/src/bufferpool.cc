@@ -1,26 +1,208 @@
 #include "bufferpool.h"
 
-BufferPool::BufferPool(size_t bufferSize, size_t initialPoolSize) : _bufferSize(bufferSize)
+#include <algorithm>
+
+namespace
 {
-    for (size_t i = 0; i < initialPoolSize; ++i)
-        _freeBuffers.emplace_back(new std::vector<uint8_t>(bufferSize));
+
+constexpr size_t kClassSizes[BufferPool::kClassCount - 1] = {256, 1024, 4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024};
+constexpr size_t kTrimInterval = 256;
+// The largest class is up to the negotiated packet size, never keep more than this many of them around idle.
+constexpr size_t kMaxFreeLargest = 2;
+
+struct ThreadCache
+{
+    std::shared_ptr<BufferPool::Shared> owner;
+    std::array<std::vector<std::vector<uint8_t>*>, BufferPool::kClassCount> buffers;
+
+    ~ThreadCache()
+    {
+        if (!owner)
+            return;
+
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            for (std::vector<uint8_t>* buffer : buffers[i])
+            {
+                // Cached buffers are already counted as returned, put them back as free.
+                owner->classes[i].outstanding++;
+                owner->ReleaseLocked(i, buffer);
+            }
+            buffers[i].clear();
+        }
+        owner.reset();
+    }
+};
+
+thread_local ThreadCache t_cache;
+
+ThreadCache* CacheFor(const std::shared_ptr<BufferPool::Shared>& shared)
+{
+    if (!t_cache.owner)
+        t_cache.owner = shared;
+    return t_cache.owner == shared ? &t_cache : nullptr;
+}
+
+} // namespace
+
+BufferPool::BufferPool(size_t maxBufferSize) : _maxBufferSize(maxBufferSize), _shared(std::make_shared<Shared>())
+{
+    SetMaxBufferSize(maxBufferSize);
 }
 
-std::shared_ptr<std::vector<uint8_t>> BufferPool::GetBuffer()
+void BufferPool::SetMaxBufferSize(size_t maxBufferSize)
 {
-    std::lock_guard<std::mutex> lock(_poolMutex);
-    if (_freeBuffers.empty())
-        return std::make_shared<std::vector<uint8_t>>(_bufferSize);
+    _maxBufferSize = maxBufferSize;
+    for (size_t i = 0; i < kClassCount - 1; i++)
+        _shared->classes[i].size = std::min(kClassSizes[i], maxBufferSize);
+    _shared->classes[kClassCount - 1].size = maxBufferSize;
+}
+
+size_t BufferPool::ClassIndexFor(size_t size) const
+{
+    for (size_t i = 0; i < kClassCount; i++)
+    {
+        if (size <= _shared->classes[i].size)
+            return i;
+    }
+    return kClassCount;
+}
+
+std::shared_ptr<std::vector<uint8_t>> BufferPool::GetBuffer(size_t size)
+{
+    size_t classIndex = ClassIndexFor(size);
+    if (classIndex >= kClassCount)
+        return nullptr;
+
+    Shared& shared = *_shared;
+    SizeClass& sizeClass = shared.classes[classIndex];
+    std::vector<uint8_t>* buffer = nullptr;
+
+    if (sizeClass.size <= kThreadCachedMaxSize)
+    {
+        ThreadCache* cache = CacheFor(_shared);
+        if (cache && !cache->buffers[classIndex].empty())
+        {
+            buffer = cache->buffers[classIndex].back();
+            cache->buffers[classIndex].pop_back();
+            sizeClass.outstanding++;
+            shared.hits++;
+        }
+    }
+
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (!sizeClass.freeBuffers.empty())
+        {
+            buffer = sizeClass.freeBuffers.back();
+            sizeClass.freeBuffers.pop_back();
+            shared.hits++;
+        }
+        sizeClass.highWater = std::max(sizeClass.highWater, ++sizeClass.outstanding);
+    }
+
+    if (!buffer)
+    {
+        buffer = new std::vector<uint8_t>(sizeClass.size);
+        shared.misses++;
+        shared.residentBytes += sizeClass.size;
+    }
+
+    shared.outstandingBytes += sizeClass.size;
+
+    std::shared_ptr<Shared> owner = _shared;
+    return std::shared_ptr<std::vector<uint8_t>>(buffer,
+                                                 [owner, classIndex](std::vector<uint8_t>* released)
+                                                 {
+                                                     owner->Release(classIndex, released);
+                                                 });
+}
+
+void BufferPool::ReturnBuffer(std::shared_ptr<std::vector<uint8_t>>& buffer)
+{
+    buffer.reset();
+}
+
+BufferPool::Stats BufferPool::GetStats() const
+{
+    Stats stats;
+    stats.hits = _shared->hits.load();
+    stats.misses = _shared->misses.load();
+    stats.residentBytes = _shared->residentBytes.load();
+    stats.outstandingBytes = _shared->outstandingBytes.load();
+    return stats;
+}
+
+void BufferPool::Trim()
+{
+    std::lock_guard<std::mutex> lock(_shared->mutex);
+    _shared->TrimLocked();
+}
+
+BufferPool::Shared::~Shared()
+{
+    for (SizeClass& sizeClass : classes)
+    {
+        for (std::vector<uint8_t>* buffer : sizeClass.freeBuffers)
+            delete buffer;
+        sizeClass.freeBuffers.clear();
+    }
+}
+
+void BufferPool::Shared::Release(size_t classIndex, std::vector<uint8_t>* buffer)
+{
+    SizeClass& sizeClass = classes[classIndex];
+    outstandingBytes -= sizeClass.size;
+
+    if (sizeClass.size <= kThreadCachedMaxSize && t_cache.owner.get() == this && t_cache.buffers[classIndex].size() < kThreadCacheDepth)
+    {
+        sizeClass.outstanding--;
+        t_cache.buffers[classIndex].push_back(buffer);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ReleaseLocked(classIndex, buffer);
+}
+
+void BufferPool::Shared::ReleaseLocked(size_t classIndex, std::vector<uint8_t>* buffer)
+{
+    SizeClass& sizeClass = classes[classIndex];
+    size_t outstandingNow = --sizeClass.outstanding;
+
+    // Keep enough free buffers to get back to the recent high-water mark, drop the rest.
+    size_t wanted = sizeClass.highWater > outstandingNow ? sizeClass.highWater - outstandingNow : 0;
+    if (classIndex == kClassCount - 1)
+        wanted = std::min(wanted, kMaxFreeLargest);
+
+    if (sizeClass.freeBuffers.size() < wanted)
+        sizeClass.freeBuffers.push_back(buffer);
     else
     {
-        auto buffer = _freeBuffers.front();
-        _freeBuffers.pop_front();
-        return buffer;
+        residentBytes -= sizeClass.size;
+        delete buffer;
     }
+
+    if (++returnsSinceTrim >= kTrimInterval)
+        TrimLocked();
 }
 
-void BufferPool::ReturnBuffer(std::shared_ptr<std::vector<uint8_t>> buffer)
+void BufferPool::Shared::TrimLocked()
 {
-    std::lock_guard<std::mutex> lock(_poolMutex);
-    _freeBuffers.push_back(buffer);
+    returnsSinceTrim = 0;
+    for (SizeClass& sizeClass : classes)
+    {
+        size_t outstandingNow = sizeClass.outstanding.load();
+        sizeClass.highWater = std::max(outstandingNow, sizeClass.highWater / 2);
+
+        size_t wanted = sizeClass.highWater - outstandingNow;
+        while (sizeClass.freeBuffers.size() > wanted)
+        {
+            residentBytes -= sizeClass.size;
+            delete sizeClass.freeBuffers.back();
+            sizeClass.freeBuffers.pop_back();
+        }
+    }
 }
@@ -1,25 +1,76 @@
 #ifndef BUFFER_POOL_H
 #define BUFFER_POOL_H
 
-#include <list>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <stddef.h>
 #include <stdint.h>
 #include <vector>
 
+// Size-class buffer pool. Requests are rounded up to the next class (256 B, 1 KB, 4 KB, 16 KB, 64 KB,
+// 256 KB, 1 MB, then the pool maximum), so a 1-byte packet no longer pins a maximum sized buffer.
+//
+// Buffers go back to the pool when the last reference is dropped; ReturnBuffer only releases the caller's
+// reference. Small classes are cached per thread. Each class keeps at most as many free buffers as its
+// recent high-water mark of buffers in use, and that mark decays over time so bursts get trimmed.
 class BufferPool
 {
 public:
-    BufferPool(size_t bufferSize, size_t initialPoolSize);
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t residentBytes = 0;
+        size_t outstandingBytes = 0;
+    };
 
-    std::shared_ptr<std::vector<uint8_t>> GetBuffer();
-    void ReturnBuffer(std::shared_ptr<std::vector<uint8_t>> buffer);
+    explicit BufferPool(size_t maxBufferSize);
+
+    // The returned vector has the size of its class, which is at least size. Returns nullptr above the maximum.
+    std::shared_ptr<std::vector<uint8_t>> GetBuffer(size_t size);
+    void ReturnBuffer(std::shared_ptr<std::vector<uint8_t>>& buffer);
+
+    Stats GetStats() const;
+    size_t MaxBufferSize() const { return _maxBufferSize; }
+    // Re-derives the classes for a new maximum. Only valid before the first GetBuffer.
+    void SetMaxBufferSize(size_t maxBufferSize);
+    void Trim();
+
+    static constexpr size_t kClassCount = 8;
+    static constexpr size_t kThreadCachedMaxSize = 64 * 1024;
+    static constexpr size_t kThreadCacheDepth = 8;
+
+    struct SizeClass
+    {
+        size_t size = 0;
+        std::atomic<size_t> outstanding = 0;
+        size_t highWater = 0;
+        std::vector<std::vector<uint8_t>*> freeBuffers;
+    };
+
+    struct Shared
+    {
+        std::mutex mutex;
+        std::array<SizeClass, kClassCount> classes;
+        std::atomic<uint64_t> hits = 0;
+        std::atomic<uint64_t> misses = 0;
+        std::atomic<size_t> residentBytes = 0;
+        std::atomic<size_t> outstandingBytes = 0;
+        size_t returnsSinceTrim = 0;
+
+        ~Shared();
+        void Release(size_t classIndex, std::vector<uint8_t>* buffer);
+        void ReleaseLocked(size_t classIndex, std::vector<uint8_t>* buffer);
+        void TrimLocked();
+    };
 
 private:
-    size_t _bufferSize;
-    std::list<std::shared_ptr<std::vector<uint8_t>>> _freeBuffers;
-    std::mutex _poolMutex;
+    size_t ClassIndexFor(size_t size) const;
+
+    size_t _maxBufferSize;
+    std::shared_ptr<Shared> _shared;
 };
 
 #endif // BUFFER_POOL_H
@@ -15,8 +15,10 @@
 #include "stb_image.h"
 #include "steam.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <fstream>
 
 #ifdef _WIN32
 typedef HRESULT(WINAPI* DwmSetWindowAttributeProc)(HWND, DWORD, LPCVOID, DWORD);
@@ -170,91 +172,11 @@ static LRESULT CALLBACK WindowProcHook(HWND hwnd, UINT uMsg, WPARAM wParam, LPAR
 
 #endif
 
-inline bool StartsWith(const std::string& str, const std::string& prefix)
-{
-    return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
-}
-
-inline bool EndsWith(const std::string& str, const std::string& suffix)
-{
-    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
-}
-
 void QueueClientBridgeRpcResponse(uint32_t controller_request_id, bool success, const std::string& result_json, const std::string& error)
 {
     IPC::Singleton.QueueWindowBridgeRpcResponse(controller_request_id, success, success ? result_json : error);
 }
 
-std::string ExtractHostFromURL(const std::string& url)
-{
-    // Find scheme
-    size_t scheme_pos = url.find("://");
-    if (scheme_pos == std::string::npos)
-    {
-        LOG(ERROR) << "URL without scheme: " << url;
-        return CefString();
-    }
-    size_t after_scheme = scheme_pos + 3;
-
-    // Find end of authority
-    size_t authority_end = url.find_first_of("/?#", after_scheme);
-    if (authority_end == std::string::npos)
-    {
-        authority_end = url.length();
-    }
-
-    // Extract authority and find last '@' to handle userinfo
-    std::string authority = url.substr(after_scheme, authority_end - after_scheme);
-    size_t at_pos = authority.rfind('@');
-    size_t host_start = (at_pos != std::string::npos) ? (after_scheme + at_pos + 1) : after_scheme;
-
-    // Extract host
-    size_t end;
-    if (url[host_start] == '[')
-    { // IPv6
-        end = url.find(']', host_start + 1);
-        if (end == std::string::npos || end > authority_end)
-        {
-            LOG(ERROR) << "Invalid IPv6 URL: " << url;
-            return CefString();
-        }
-        end++; // Include ']'
-    }
-    else
-    {
-        end = url.find_first_of(":/?#", host_start);
-        if (end == std::string::npos || end > authority_end)
-        {
-            end = authority_end;
-        }
-    }
-
-    return url.substr(host_start, end - host_start);
-}
-
-bool MatchesDomain(const std::string& request_host, const std::string& cookie_domain)
-{
-    if (cookie_domain.size() < 2 || cookie_domain[0] != '.')
-    {
-        return false; // Invalid cookie domain
-    }
-    size_t norm_size = cookie_domain.size() - 1; // Length without the leading dot
-
-    // Exact match: request_host equals cookie_domain without the leading dot
-    if (request_host.size() == norm_size && request_host.compare(0, norm_size, cookie_domain, 1, norm_size) == 0)
-    {
-        return true;
-    }
-
-    // Subdomain match: request_host ends with '.' + cookie_domain without leading dot
-    if (request_host.size() > norm_size + 1 && request_host[request_host.size() - norm_size - 1] == '.' &&
-        request_host.compare(request_host.size() - norm_size, norm_size, cookie_domain, 1, norm_size) == 0)
-    {
-        return true;
-    }
-    return false;
-}
-
 Client::Client(const IPCWindowCreate& settings) : settings(settings)
 {
 }
@@ -275,11 +197,11 @@ void Client::OnFullscreenModeChange(CefRefPtr<CefBrowser> browser, bool fullscre
     if (!isViewsEnabled)
         shared::PlatformSetFullscreen(browser, fullscreen);
 
-    IPC::Singleton.QueueWork(
-        [browser, fullscreen]()
-        {
-            IPC::Singleton.NotifyWindowFullscreenChanged(browser, fullscreen);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser, fullscreen]()
+                                   {
+                                       IPC::Singleton.NotifyWindowFullscreenChanged(browser, fullscreen);
+                                   });
 }
 
 bool Client::OnBeforePopup(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, int popup_id, const CefString& target_url, const CefString& target_frame_name,
@@ -365,11 +287,11 @@ void Client::OnAfterCreated(CefRefPtr<CefBrowser> browser)
     if (settings.iconPath)
         OverrideIcon(browser, *settings.iconPath);
 
-    IPC::Singleton.QueueWork(
-        [browser]()
-        {
-            IPC::Singleton.NotifyWindowOpened(browser);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser]()
+                                   {
+                                       IPC::Singleton.NotifyWindowOpened(browser);
+                                   });
 }
 
 bool Client::DoClose(CefRefPtr<CefBrowser> browser)
@@ -420,73 +342,73 @@ void Client::OnBeforeClose(CefRefPtr<CefBrowser> browser)
 
     LOG(INFO) << "Browser closed " << browser->GetIdentifier();
 
-    IPC::Singleton.QueueWork(
-        [browser]()
-        {
-            IPC::Singleton.NotifyWindowClosed(browser);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser]()
+                                   {
+                                       IPC::Singleton.NotifyWindowClosed(browser);
+                                   });
 
     LOG(INFO) << "OnBeforeClose finished " << browser->GetIdentifier();
 }
 
 void Client::OnLoadingStateChange(CefRefPtr<CefBrowser> browser, bool isLoading, bool canGoBack, bool canGoForward)
 {
-    IPC::Singleton.QueueWork(
-        [browser, isLoading, canGoBack, canGoForward]()
-        {
-            IPC::Singleton.NotifyWindowLoadingStateChanged(browser, isLoading, canGoBack, canGoForward);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser, isLoading, canGoBack, canGoForward]()
+                                   {
+                                       IPC::Singleton.NotifyWindowLoadingStateChanged(browser, isLoading, canGoBack, canGoForward);
+                                   });
 }
 
 void Client::OnLoadEnd(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, int httpStatusCode)
 {
-    IPC::Singleton.QueueWork(
-        [browser, frame, httpStatusCode]()
-        {
-            IPC::Singleton.NotifyWindowFrameLoadEnd(browser, frame, httpStatusCode);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser, frame, httpStatusCode]()
+                                   {
+                                       IPC::Singleton.NotifyWindowFrameLoadEnd(browser, frame, httpStatusCode);
+                                   });
 }
 
 void Client::OnLoadStart(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, TransitionType transition_type)
 {
-    IPC::Singleton.QueueWork(
-        [browser, frame]()
-        {
-            IPC::Singleton.NotifyWindowFrameLoadStart(browser, frame);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser, frame]()
+                                   {
+                                       IPC::Singleton.NotifyWindowFrameLoadStart(browser, frame);
+                                   });
 }
 
 void Client::OnLoadError(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, ErrorCode errorCode, const CefString& errorText, const CefString& failedUrl)
 {
     LOG(ERROR) << "Failed to load URL (" << errorCode << ") '" << failedUrl << "': " << errorText;
 
-    IPC::Singleton.QueueWork(
-        [browser, frame, errorCode, errorText, failedUrl]()
-        {
-            IPC::Singleton.NotifyWindowFrameLoadError(browser, frame, errorCode, errorText, failedUrl);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser, frame, errorCode, errorText, failedUrl]()
+                                   {
+                                       IPC::Singleton.NotifyWindowFrameLoadError(browser, frame, errorCode, errorText, failedUrl);
+                                   });
 }
 
 void Client::OnTakeFocus(CefRefPtr<CefBrowser> browser, bool next)
 {
     LOG(INFO) << "Browser unfocused " << browser->GetIdentifier();
 
-    IPC::Singleton.QueueWork(
-        [browser]()
-        {
-            IPC::Singleton.NotifyWindowUnfocused(browser);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser]()
+                                   {
+                                       IPC::Singleton.NotifyWindowUnfocused(browser);
+                                   });
 }
 
 void Client::OnGotFocus(CefRefPtr<CefBrowser> browser)
 {
     LOG(INFO) << "Browser focused " << browser->GetIdentifier();
 
-    IPC::Singleton.QueueWork(
-        [browser]()
-        {
-            IPC::Singleton.NotifyWindowFocused(browser);
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [browser]()
+                                   {
+                                       IPC::Singleton.NotifyWindowFocused(browser);
+                                   });
 }
 
 void Client::OnBeforeContextMenu(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefContextMenuParams> params, CefRefPtr<CefMenuModel> model)
@@ -623,30 +545,31 @@ void Client::OnDevToolsEvent(CefRefPtr<CefBrowser> browser, const CefString& met
         }
     }
 
-    IPC::Singleton.QueueWork(
-        [p = std::vector<uint8_t>(static_cast<const uint8_t*>(params), static_cast<const uint8_t*>(params) + params_size), m = CefString(method), browser]()
-        {
-            IPC::Singleton.NotifyWindowDevToolsEvent(browser, m, p.data(), p.size());
-        });
+    IPC::Singleton.QueueWindowWork(browser->GetIdentifier(),
+                                   [p = std::vector<uint8_t>(static_cast<const uint8_t*>(params), static_cast<const uint8_t*>(params) + params_size), m = CefString(method), browser]()
+                                   {
+                                       IPC::Singleton.NotifyWindowDevToolsEvent(browser, m, p.data(), p.size());
+                                   });
 }
 
 
+static bool HeaderNameEquals(const std::string& k, const char* name)
+{
+    if (k.size() != std::strlen(name))
+        return false;
+    for (std::size_t i = 0; i < k.size(); ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(k[i])) != std::tolower(static_cast<unsigned char>(name[i])))
+            return false;
+    }
+    return true;
+}
+
 static bool FindHeaderCI(const std::multimap<std::string, std::string>& headers, const char* name, std::string& out)
 {
     for (const auto& [k, v] : headers)
     {
-        if (k.size() != std::strlen(name))
-            continue;
-        bool eq = true;
-        for (std::size_t i = 0; i < k.size(); ++i)
-        {
-            if (std::tolower(static_cast<unsigned char>(k[i])) != std::tolower(static_cast<unsigned char>(name[i])))
-            {
-                eq = false;
-                break;
-            }
-        }
-        if (eq)
+        if (HeaderNameEquals(k, name))
         {
             out = v;
             return true;
@@ -700,23 +623,47 @@ static bool ParseContentRange(const std::string& value, int64_t& start, int64_t&
 class ProxyResourceHandler : public CefResourceHandler
 {
 public:
-    ProxyResourceHandler(int32_t identifier, CefRefPtr<CefRequest> request) : _identifier(identifier), _request(request), _offset(0) {}
+    ProxyResourceHandler(int32_t identifier, CefRefPtr<CefRequest> request, std::shared_ptr<ProxyResponseCache> cache)
+        : _identifier(identifier), _request(request), _offset(0), _cache(std::move(cache))
+    {
+    }
 
     bool Open(CefRefPtr<CefRequest> request, bool& handle_request, CefRefPtr<CefCallback> callback) override
     {
-        std::unique_ptr<IPCProxyResponse> response = IPC::Singleton.WindowProxyRequest(_identifier, request);
-        if (!response)
+        // Deferred open: the controller round trip completes on the IPC thread pool and resumes CEF through
+        // callback, so many proxied loads can be in flight without parking a CEF thread each.
+        handle_request = false;
+
+        if (_cache && _cache->Enabled())
         {
-            // If there's no response, indicate that we're not handling the request
-            // TODO: The not handled flow doesn't seem to work yet
-            handle_request = false;
-            return true;
+            _url = request->GetURL().ToString();
+            CefRequest::HeaderMap headers;
+            request->GetHeaderMap(headers);
+            for (auto& header : headers)
+                _requestHeaders.emplace(header.first.ToString(), header.second.ToString());
+
+            _cacheable = ProxyResponseCache::IsCacheableRequest(request->GetMethod().ToString(), _requestHeaders);
+            std::shared_ptr<const ProxyResponseCache::Entry> entry;
+            if (_cacheable)
+            {
+                switch (_cache->Lookup(_url, _requestHeaders, entry))
+                {
+                case ProxyResponseCache::LookupResult::Fresh:
+                    ServeFromCache(entry);
+                    handle_request = true;
+                    return true;
+                case ProxyResponseCache::LookupResult::Stale:
+                    _revalidating = true;
+                    _unconditionalRequest = request;
+                    request = MakeConditionalRequest(request, *entry);
+                    break;
+                case ProxyResponseCache::LookupResult::Miss:
+                    break;
+                }
+            }
         }
 
-        handle_request = true;
-        _response = std::move(response);
-
-        InitRangeState();
+        SendProxyRequest(request, callback);
         return true;
     }
 
@@ -740,8 +687,8 @@ public:
 
         if (hasRange)
             response_length = _entityTotal;
-        else if (_response->body)
-            response_length = static_cast<int64_t>((*_response->body).size());
+        else if (_body)
+            response_length = static_cast<int64_t>(_body->size());
         else if (_response->lengthMode == 0)
             response_length = _response->bodyLength;
         else
@@ -769,12 +716,12 @@ public:
         if (!_response)
             return false;
 
-        if (_response->body)
+        if (_body)
         {
-            if (_offset < (*_response->body).size())
+            if (_offset < _body->size())
             {
-                size_t bytes_to_copy = std::min(static_cast<size_t>(bytes_to_read), (*_response->body).size() - _offset);
-                memcpy(data_out, (*_response->body).data() + _offset, bytes_to_copy);
+                size_t bytes_to_copy = std::min(static_cast<size_t>(bytes_to_read), _body->size() - _offset);
+                memcpy(data_out, _body->data() + _offset, bytes_to_copy);
                 _offset += bytes_to_copy;
                 bytes_read = static_cast<int>(bytes_to_copy);
                 return true;
@@ -789,13 +736,17 @@ public:
             switch (PumpOnce(stream, data_out, static_cast<size_t>(bytes_to_read), n))
             {
             case PumpState::Delivered:
+                CaptureBody(data_out, n);
                 bytes_read = static_cast<int>(n);
                 return true;
             case PumpState::NeedMore:
             {
-                _pendingData = data_out;
-                _pendingSize = static_cast<size_t>(bytes_to_read);
-                _pendingCb = callback;
+                {
+                    std::lock_guard<std::mutex> lk(_openMutex);
+                    _pendingData = data_out;
+                    _pendingSize = static_cast<size_t>(bytes_to_read);
+                    _pendingCb = callback;
+                }
                 CefRefPtr<ProxyResourceHandler> self(this);
                 stream->RegisterReadWakeup([self]() { self->PumpAsync(); });
                 return true;
@@ -811,18 +762,92 @@ public:
 
     void Cancel() override
     {
-        if (_response && _response->bodyStream)
+        std::shared_ptr<DataStream> stream;
         {
-            const uint32_t id = _response->bodyStream->GetIdentifier();
+            std::lock_guard<std::mutex> lk(_openMutex);
+            _canceled = true;
+            if (_response)
+                stream = std::move(_response->bodyStream);
+            _pendingCb = nullptr;
+            // A canceled body may be truncated, never store it.
+            _capture = nullptr;
+        }
+
+        // Canceling runs the read wakeup, a PumpAsync waiting on it takes _openMutex and sees _canceled.
+        if (stream)
+        {
+            const uint32_t id = stream->GetIdentifier();
             LOG(INFO) << "Canceling stream " << id << ".";
-            _response->bodyStream->MarkCanceled();
+            stream->MarkCanceled();
             IPC::Singleton.CloseStream(id);
-            _response->bodyStream = nullptr;
         }
-        _pendingCb = nullptr;
     }
 
 private:
+    void SendProxyRequest(CefRefPtr<CefRequest> request, CefRefPtr<CefCallback> callback)
+    {
+        CefRefPtr<ProxyResourceHandler> self(this);
+        IPC::Singleton.WindowProxyRequestAsync(_identifier, request,
+                                               [self, callback](std::unique_ptr<IPCProxyResponse> response)
+                                               {
+                                                   self->OnProxyResponse(std::move(response), callback);
+                                               });
+    }
+
+    void OnProxyResponse(std::unique_ptr<IPCProxyResponse> response, CefRefPtr<CefCallback> callback)
+    {
+        CefRefPtr<CefRequest> retry;
+        {
+            std::lock_guard<std::mutex> lk(_openMutex);
+            if (_canceled)
+            {
+                if (response && response->bodyStream)
+                {
+                    response->bodyStream->MarkCanceled();
+                    IPC::Singleton.CloseStream(response->bodyStream->GetIdentifier());
+                }
+                return;
+            }
+
+            if (response && _revalidating && response->status_code == 304)
+            {
+                std::shared_ptr<const ProxyResponseCache::Entry> entry = _cache->Refresh(_url, response->headers);
+                if (response->bodyStream)
+                {
+                    response->bodyStream->MarkCanceled();
+                    IPC::Singleton.CloseStream(response->bodyStream->GetIdentifier());
+                }
+                response = nullptr;
+                _revalidating = false;
+                // The page never asked for a conditional request, so when the entry went away meanwhile it must not
+                // see the 304. Ask again without validators instead.
+                if (entry)
+                    ServeFromCache(entry);
+                else
+                    retry = std::move(_unconditionalRequest);
+            }
+
+            if (response)
+            {
+                _response = std::move(response);
+                if (_response->body)
+                {
+                    _body = std::make_shared<const std::vector<uint8_t>>(std::move(*_response->body));
+                    _response->body.reset();
+                }
+                StoreOrBeginCapture();
+                InitRangeState();
+            }
+        }
+
+        if (retry)
+            SendProxyRequest(retry, callback);
+        else if (_response)
+            callback->Continue();
+        else
+            callback->Cancel();
+    }
+
     void InitRangeState()
     {
         if (!_response)
@@ -848,45 +873,140 @@ private:
 
     PumpState PumpOnce(const std::shared_ptr<DataStream>& stream, void* out, size_t size, size_t& n)
     {
-        n = stream->ReadSome(reinterpret_cast<uint8_t*>(out), size);
+        StreamState state;
+        n = stream->ReadSome(reinterpret_cast<uint8_t*>(out), size, state);
         if (n > 0)
             return PumpState::Delivered;
-        if (stream->State() == StreamState::Active)
+        if (state == StreamState::Active)
             return PumpState::NeedMore;
         CheckStreamIntegrity(stream);
+        FinishCapture(stream);
         return PumpState::Eof;
     }
 
+    // Runs on a pool thread. Holds _openMutex while touching the pending read so Cancel on the IO thread cannot
+    // clear the stream or callback underneath it, the read itself never blocks.
     void PumpAsync()
     {
-        auto stream = _response ? _response->bodyStream : nullptr;
-        if (!_pendingCb || !stream)
-            return;
-
-        size_t n = 0;
-        switch (PumpOnce(stream, _pendingData, _pendingSize, n))
+        std::shared_ptr<DataStream> stream;
+        CefRefPtr<CefResourceReadCallback> cb;
+        int result = 0;
         {
-        case PumpState::Delivered:
+            std::lock_guard<std::mutex> lk(_openMutex);
+            stream = _response ? _response->bodyStream : nullptr;
+            if (_canceled || !_pendingCb || !stream)
+                return;
+
+            size_t n = 0;
+            switch (PumpOnce(stream, _pendingData, _pendingSize, n))
+            {
+            case PumpState::Delivered:
+                CaptureBody(_pendingData, n);
+                result = static_cast<int>(n);
+                cb = _pendingCb;
+                break;
+            case PumpState::NeedMore:
+                break;
+            case PumpState::Eof:
+                cb = _pendingCb;
+                break;
+            }
+            if (cb)
+                _pendingCb = nullptr;
+        }
+
+        if (cb)
         {
-            auto cb = _pendingCb;
-            _pendingCb = nullptr;
-            cb->Continue(static_cast<int>(n));
+            cb->Continue(result);
             return;
         }
-        case PumpState::NeedMore:
+
+        // The wakeup may run right away, so it is registered without the lock.
+        CefRefPtr<ProxyResourceHandler> self(this);
+        stream->RegisterReadWakeup([self]() { self->PumpAsync(); });
+    }
+
+    void ServeFromCache(const std::shared_ptr<const ProxyResponseCache::Entry>& entry)
+    {
+        _response = std::make_unique<IPCProxyResponse>();
+        _response->status_code = entry->statusCode;
+        _response->status_text = entry->statusText;
+        _response->media_type = entry->mediaType;
+        _response->headers = entry->headers;
+        _response->bodyLength = static_cast<int64_t>(entry->body->size());
+        _body = entry->body;
+        _cache->RecordServed(_body->size());
+    }
+
+    static CefRefPtr<CefRequest> MakeConditionalRequest(CefRefPtr<CefRequest> request, const ProxyResponseCache::Entry& entry)
+    {
+        CefRequest::HeaderMap headers;
+        request->GetHeaderMap(headers);
+        // Replace validators rather than adding a second copy of them.
+        for (auto itr = headers.begin(); itr != headers.end();)
         {
-            CefRefPtr<ProxyResourceHandler> self(this);
-            stream->RegisterReadWakeup([self]() { self->PumpAsync(); });
-            return;
+            const std::string name = itr->first.ToString();
+            if (HeaderNameEquals(name, "If-None-Match") || HeaderNameEquals(name, "If-Modified-Since"))
+                itr = headers.erase(itr);
+            else
+                ++itr;
         }
-        case PumpState::Eof:
+        if (!entry.etag.empty())
+            headers.insert({"If-None-Match", entry.etag});
+        if (!entry.lastModified.empty())
+            headers.insert({"If-Modified-Since", entry.lastModified});
+
+        CefRefPtr<CefRequest> conditional = CefRequest::Create();
+        conditional->Set(request->GetURL(), request->GetMethod(), request->GetPostData(), headers);
+        return conditional;
+    }
+
+    // Inline bodies are stored right away, streamed ones are copied while CEF reads them and stored at the end.
+    void StoreOrBeginCapture()
+    {
+        if (!_cacheable)
+            return;
+
+        if (_body)
         {
-            auto cb = _pendingCb;
-            _pendingCb = nullptr;
-            cb->Continue(0);
+            _cache->Store(_url, _requestHeaders, _response->status_code, _response->status_text, _response->media_type, _response->headers, _body);
             return;
         }
+
+        const size_t expected = _response->lengthMode == 0 && _response->bodyLength > 0 ? static_cast<size_t>(_response->bodyLength) : 0;
+        if (!_response->bodyStream || !_cache->IsStorable(_requestHeaders, _response->status_code, _response->headers, expected))
+            return;
+
+        _captureLimit = _cache->MaxEntrySize();
+        _capture = std::make_unique<std::vector<uint8_t>>();
+        _capture->reserve(expected);
+    }
+
+    void CaptureBody(const void* data, size_t size)
+    {
+        if (!_capture)
+            return;
+
+        if (_capture->size() + size > _captureLimit)
+        {
+            _capture = nullptr;
+            return;
         }
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        _capture->insert(_capture->end(), bytes, bytes + size);
+    }
+
+    void FinishCapture(const std::shared_ptr<DataStream>& stream)
+    {
+        if (!_capture || _canceled)
+            return;
+
+        std::unique_ptr<std::vector<uint8_t>> capture = std::move(_capture);
+        if (stream->State() != StreamState::Completed || (_response->lengthMode == 0 && capture->size() != static_cast<size_t>(_response->bodyLength)))
+            return;
+
+        std::shared_ptr<const std::vector<uint8_t>> body(capture.release());
+        _cache->Store(_url, _requestHeaders, _response->status_code, _response->status_text, _response->media_type, _response->headers, std::move(body));
     }
 
     void CheckStreamIntegrity(const std::shared_ptr<DataStream>& stream)
@@ -904,8 +1024,22 @@ private:
     int32_t _identifier;
     CefRefPtr<CefRequest> _request;
     std::unique_ptr<IPCProxyResponse> _response;
+    std::shared_ptr<const std::vector<uint8_t>> _body;
     size_t _offset;
 
+    std::shared_ptr<ProxyResponseCache> _cache;
+    std::string _url;
+    ProxyResponseCache::Headers _requestHeaders;
+    bool _cacheable = false;
+    bool _revalidating = false;
+    // The request as the page sent it, kept while revalidating.
+    CefRefPtr<CefRequest> _unconditionalRequest;
+    std::unique_ptr<std::vector<uint8_t>> _capture;
+    size_t _captureLimit = 0;
+
+    std::mutex _openMutex;
+    bool _canceled = false;
+
     void* _pendingData = nullptr;
     size_t _pendingSize = 0;
     CefRefPtr<CefResourceReadCallback> _pendingCb;
@@ -917,105 +1051,302 @@ private:
     IMPLEMENT_REFCOUNTING(ProxyResourceHandler);
 };
 
-CefRefPtr<CefResourceHandler> Client::GetResourceHandler(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefRequest> request)
+// Serves one file of a mounted directory or asset pack, see MountTable. A single byte range is honoured, anything else
+// gets the whole file. Pack assets are served from the mapping, precompressed when the request accepts it.
+class MountedFileResourceHandler : public CefResourceHandler
 {
-    if (settings.proxyRequests)
-        return new ProxyResourceHandler(browser->GetIdentifier(), request);
+public:
+    explicit MountedFileResourceHandler(MountTable::Resolution resolution) : _resolution(std::move(resolution)) {}
 
+    bool Open(CefRefPtr<CefRequest> request, bool& handle_request, CefRefPtr<CefCallback> callback) override
     {
-        std::lock_guard<std::mutex> lk(_proxyRequestsSetMutex);
-        if (_proxyRequestsSet.find(request->GetURL()) != _proxyRequestsSet.end())
-            return new ProxyResourceHandler(browser->GetIdentifier(), request);
+        handle_request = true;
+        if (_resolution.pack)
+            return OpenPacked(request);
+
+        std::error_code ec;
+        const uint64_t size = _resolution.file.empty() ? 0 : std::filesystem::file_size(_resolution.file, ec);
+        if (!_resolution.file.empty() && !ec)
+            _file.open(_resolution.file, std::ios::binary);
+        if (!_file.is_open())
+        {
+            _status = 404;
+            return true;
+        }
+
+        _size = size;
+        _remaining = size;
+        const std::string range = request->GetHeaderByName("Range").ToString();
+        uint64_t start = 0;
+        uint64_t end = 0;
+        bool satisfiable = true;
+        if (!range.empty() && MountTable::ParseRange(range, size, start, end, satisfiable))
+        {
+            if (!satisfiable)
+            {
+                _status = 416;
+                _remaining = 0;
+                return true;
+            }
+
+            _status = 206;
+            _rangeStart = start;
+            _remaining = end - start + 1;
+            _file.seekg(static_cast<std::streamoff>(start));
+        }
+        return true;
     }
 
+    bool OpenPacked(CefRefPtr<CefRequest> request)
     {
-        std::lock_guard<std::mutex> lk(_proxyDomainsMutex);
-        bool hasProxyDomains = _exactProxyDomains.size() > 0 || _leadingDotProxyDomains.size() > 0;
-        if (!hasProxyDomains)
-            return nullptr;
-    }
+        if (!_resolution.entry)
+        {
+            _status = 404;
+            return true;
+        }
 
-    std::string req_host = ExtractHostFromURL(request->GetURL());
-    if (req_host.size() < 1)
-        return nullptr;
+        const AssetPackEntry& entry = *_resolution.entry;
+        const AssetPackVariant* variant = &entry.variants[(size_t)AssetEncoding::Identity];
+        _size = variant->size;
+        _remaining = _size;
 
-    // Check caches first
-    {
-        std::lock_guard<std::mutex> lk(_proxyCacheMutex);
-        if (_proxyCache.find(req_host) != _proxyCache.end())
-            return new ProxyResourceHandler(browser->GetIdentifier(), request);
-        if (_negativeProxyCache.find(req_host) != _negativeProxyCache.end())
-            return nullptr; // Known non-matching host
-    }
+        const std::string range = request->GetHeaderByName("Range").ToString();
+        uint64_t start = 0;
+        uint64_t end = 0;
+        bool satisfiable = true;
+        if (!range.empty() && MountTable::ParseRange(range, _size, start, end, satisfiable))
+        {
+            // Ranges address the identity representation.
+            if (!satisfiable)
+            {
+                _status = 416;
+                _remaining = 0;
+                return true;
+            }
 
-    // Check exact matches and leading-dot domains
-    bool matchedDomain = false;
-    {
-        std::lock_guard<std::mutex> lk(_proxyDomainsMutex);
-        // Check exact matches
-        if (_exactProxyDomains.find(req_host) != _exactProxyDomains.end())
-            matchedDomain = true;
+            _status = 206;
+            _rangeStart = start;
+            _remaining = end - start + 1;
+        }
         else
         {
-            // Check leading-dot domains for cookie domain matches
-            for (const auto& domain : _leadingDotProxyDomains)
+            const std::string acceptEncoding = request->GetHeaderByName("Accept-Encoding").ToString();
+            const AssetPackVariant& brotli = entry.variants[(size_t)AssetEncoding::Brotli];
+            const AssetPackVariant& gzip = entry.variants[(size_t)AssetEncoding::Gzip];
+            if (brotli.size > 0 && AcceptsEncoding(acceptEncoding, "br"))
             {
-                if (MatchesDomain(req_host, domain))
-                {
-                    matchedDomain = true;
-                    break;
-                }
+                variant = &brotli;
+                _contentEncoding = "br";
+            }
+            else if (gzip.size > 0 && AcceptsEncoding(acceptEncoding, "gzip"))
+            {
+                variant = &gzip;
+                _contentEncoding = "gzip";
             }
+            _remaining = variant->size;
         }
+
+        _packed = _resolution.pack->Data(*variant) + _rangeStart;
+        return true;
     }
 
-    // Cache the result
+    void GetResponseHeaders(CefRefPtr<CefResponse> response, int64_t& response_length, CefString& redirectUrl) override
     {
-        std::lock_guard<std::mutex> lk(_proxyCacheMutex);
-        if (matchedDomain)
+        response->SetStatus(_status);
+        CefResponse::HeaderMap headers;
+        headers.insert({"Accept-Ranges", "bytes"});
+        if (_resolution.pack)
+            headers.insert({"Vary", "Accept-Encoding"});
+        if (!_contentEncoding.empty())
+            headers.insert({"Content-Encoding", _contentEncoding});
+        switch (_status)
         {
-            _proxyCache.insert(req_host);
+        case 200:
+            response->SetStatusText("OK");
+            break;
+        case 206:
+            response->SetStatusText("Partial Content");
+            headers.insert({"Content-Range", "bytes " + std::to_string(_rangeStart) + "-" + std::to_string(_rangeStart + _remaining - 1) + "/" + std::to_string(_size)});
+            break;
+        case 416:
+            response->SetStatusText("Range Not Satisfiable");
+            headers.insert({"Content-Range", "bytes */" + std::to_string(_size)});
+            break;
+        default:
+            response->SetStatusText("Not Found");
+            break;
         }
-        else
+        response->SetHeaderMap(headers);
+        response->SetMimeType(_status == 200 || _status == 206 ? MimeType() : "text/plain");
+        response_length = static_cast<int64_t>(_remaining);
+    }
+
+    bool Read(void* data_out, int bytes_to_read, int& bytes_read, CefRefPtr<CefResourceReadCallback> callback) override
+    {
+        bytes_read = 0;
+        if (_packed && _remaining > 0)
         {
-            _negativeProxyCache.insert(req_host);
+            bytes_read = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(bytes_to_read), _remaining));
+            memcpy(data_out, _packed, static_cast<size_t>(bytes_read));
+            _packed += bytes_read;
+            _remaining -= static_cast<uint64_t>(bytes_read);
+            return true;
         }
+        if (_remaining == 0 || !_file.is_open())
+            return false;
+
+        const size_t toRead = static_cast<size_t>(std::min<uint64_t>(static_cast<uint64_t>(bytes_to_read), _remaining));
+        _file.read(static_cast<char*>(data_out), static_cast<std::streamsize>(toRead));
+        bytes_read = static_cast<int>(_file.gcount());
+        _remaining -= static_cast<uint64_t>(bytes_read);
+        return bytes_read > 0;
     }
 
-    return matchedDomain ? new ProxyResourceHandler(browser->GetIdentifier(), request) : nullptr;
-}
+    void Cancel() override
+    {
+        _file.close();
+        _packed = nullptr;
+    }
 
-cef_return_value_t Client::OnBeforeResourceLoad(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefRequest> request, CefRefPtr<CefCallback> callback)
-{
-    int requestIdentifier = (int)request->GetIdentifier();
-    auto modifyRequestIfNeeded = [&](const std::string& url)
+private:
+    // token is listed in the Accept-Encoding header and not refused with q=0.
+    static bool AcceptsEncoding(const std::string& header, const std::string& token)
     {
-        bool isModified = false;
+        size_t start = 0;
+        while (start < header.size())
         {
-            std::lock_guard<std::mutex> lock(_modifiedRequestsMutex);
-            isModified = _modifiedRequests.find(requestIdentifier) != _modifiedRequests.end();
-            if (!isModified)
-                _modifiedRequests.insert(requestIdentifier);
+            size_t comma = header.find(',', start);
+            if (comma == std::string::npos)
+                comma = header.size();
+
+            const std::string item = header.substr(start, comma - start);
+            start = comma + 1;
+
+            const size_t semicolon = item.find(';');
+            const std::string name = item.substr(0, semicolon);
+            const size_t first = name.find_first_not_of(" \t");
+            const size_t last = name.find_last_not_of(" \t");
+            if (first == std::string::npos || name.substr(first, last - first + 1) != token)
+                continue;
+            if (semicolon == std::string::npos)
+                return true;
+
+            std::string params = item.substr(semicolon + 1);
+            params.erase(std::remove_if(params.begin(), params.end(), [](char c) { return c == ' ' || c == '\t'; }), params.end());
+            return params.find_first_not_of("q=0.") != std::string::npos;
         }
+        return false;
+    }
 
-        if (!isModified)
-            IPC::Singleton.WindowModifyRequest(browser->GetIdentifier(), request, settings.modifyRequestBody);
-    };
+    std::string MimeType() const
+    {
+        if (!_resolution.mimeType.empty())
+            return _resolution.mimeType;
+
+        // Packs leave unknown types empty too, so both mount kinds resolve them the same way.
+        const std::string extension = _resolution.pack ? std::filesystem::path(std::string(_resolution.pack->Path(*_resolution.entry))).extension().string()
+                                                       : _resolution.file.extension().string();
+        const std::string mimeType = extension.size() > 1 ? CefGetMimeType(extension.substr(1)).ToString() : std::string();
+        return mimeType.empty() ? "application/octet-stream" : mimeType;
+    }
+
+    MountTable::Resolution _resolution;
+    std::ifstream _file;
+    const uint8_t* _packed = nullptr;
+    std::string _contentEncoding;
+    int _status = 200;
+    uint64_t _size = 0;
+    uint64_t _rangeStart = 0;
+    uint64_t _remaining = 0;
+
+    IMPLEMENT_REFCOUNTING(MountedFileResourceHandler);
+};
+
+CefRefPtr<CefResourceHandler> Client::GetResourceHandler(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefRequest> request)
+{
+    if (!_mountTable.Empty())
+    {
+        std::optional<MountTable::Resolution> mounted = _mountTable.Resolve(request->GetURL().ToString());
+        if (mounted)
+            return new MountedFileResourceHandler(std::move(*mounted));
+    }
+
+    if (settings.proxyRequests)
+        return new ProxyResourceHandler(browser->GetIdentifier(), request, _proxyResponseCache);
 
-    if (settings.modifyRequests)
+    if (_proxyMatcher.Matches(request->GetURL().ToString()))
+        return new ProxyResourceHandler(browser->GetIdentifier(), request, _proxyResponseCache);
+    return nullptr;
+}
+
+bool Client::ApplyRequestRewriteRules(CefRefPtr<CefRequest> request)
+{
+    const int requestIdentifier = (int)request->GetIdentifier();
+    bool allowUrlRewrite;
     {
-        modifyRequestIfNeeded(request->GetURL());
+        std::lock_guard<std::mutex> lock(_modifiedRequestsMutex);
+        allowUrlRewrite = _rewrittenRequests.find(requestIdentifier) == _rewrittenRequests.end();
     }
 
+    const std::string url = request->GetURL().ToString();
+    RequestRewriter::Result result = _requestRewriter.Evaluate(url, request->GetMethod().ToString(), (int)request->GetResourceType(), allowUrlRewrite);
+    if (result.block)
+        return false;
+
+    if (!result.headerRules.empty())
     {
-        std::lock_guard<std::mutex> lk(_modifyRequestsSetMutex);
-        if (_modifyRequestsSet.find(request->GetURL()) != _modifyRequestsSet.end())
+        CefRequest::HeaderMap cefHeaders;
+        request->GetHeaderMap(cefHeaders);
+        RequestRewriter::Headers headers;
+        for (const auto& header : cefHeaders)
+            headers.emplace(header.first.ToString(), header.second.ToString());
+
+        RequestRewriter::EditHeaders(result, headers);
+        cefHeaders.clear();
+        for (const auto& header : headers)
+            cefHeaders.emplace(header.first, header.second);
+        request->SetHeaderMap(cefHeaders);
+    }
+
+    if (!result.url.empty() && result.url != url)
+    {
+        // CEF turns the new URL into an internal redirect.
         {
-            modifyRequestIfNeeded(request->GetURL());
+            std::lock_guard<std::mutex> lock(_modifiedRequestsMutex);
+            _rewrittenRequests.insert(requestIdentifier);
         }
+        request->SetURL(result.url);
     }
+    return true;
+}
+
+cef_return_value_t Client::OnBeforeResourceLoad(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefRequest> request, CefRefPtr<CefCallback> callback)
+{
+    // Declarative rules run first, only what they leave for custom logic goes to the controller.
+    if (!_requestRewriter.Empty() && !ApplyRequestRewriteRules(request))
+        return RV_CANCEL;
 
-    return RV_CONTINUE;
+    bool shouldModify = settings.modifyRequests;
+    if (!shouldModify)
+        shouldModify = _modifyMatcher.Matches(request->GetURL().ToString());
+
+    if (!shouldModify)
+        return RV_CONTINUE;
+
+    int requestIdentifier = (int)request->GetIdentifier();
+    {
+        std::lock_guard<std::mutex> lock(_modifiedRequestsMutex);
+        if (!_modifiedRequests.insert(requestIdentifier).second)
+            return RV_CONTINUE;
+    }
+
+    // The controller's modifier runs while CEF holds the request, it resumes once the result has been applied.
+    IPC::Singleton.WindowModifyRequestAsync(browser->GetIdentifier(), request, settings.modifyRequestBody,
+                                            [callback]()
+                                            {
+                                                callback->Continue();
+                                            });
+    return RV_CONTINUE_ASYNC;
 }
 
 void Client::OnResourceLoadComplete(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefRequest> request, CefRefPtr<CefResponse> response,
@@ -1024,6 +1355,7 @@ void Client::OnResourceLoadComplete(CefRefPtr<CefBrowser> browser, CefRefPtr<Cef
     std::lock_guard<std::mutex> lock(_modifiedRequestsMutex);
     int requestIdentifier = (int)request->GetIdentifier();
     _modifiedRequests.erase(requestIdentifier);
+    _rewrittenRequests.erase(requestIdentifier);
 }
 
 void Client::OverrideTitle(CefRefPtr<CefBrowser> browser, const std::string& title)
@@ -1080,104 +1412,37 @@ void Client::OverrideIcon(CefRefPtr<CefBrowser> browser, const std::string& icon
     }
 }
 
-void Client::AddUrlToProxy(const std::string& url)
+void Client::AddUrlToProxy(const std::string& url, UrlPatternKind kind)
 {
-    std::lock_guard<std::mutex> lk(_proxyRequestsSetMutex);
-    _proxyRequestsSet.insert(url);
+    _proxyMatcher.Add(kind, url);
 }
 
-void Client::RemoveUrlToProxy(const std::string& url)
+void Client::RemoveUrlToProxy(const std::string& url, UrlPatternKind kind)
 {
-    std::lock_guard<std::mutex> lk(_proxyRequestsSetMutex);
-    _proxyRequestsSet.erase(url);
+    _proxyMatcher.Remove(kind, url);
 }
 
 void Client::AddDomainToProxy(const std::string& domain)
 {
-    // Normalize for consistency
-    bool is_leading_dot = StartsWith(domain, ".");
-    std::string normalized_domain = is_leading_dot ? domain.substr(1) : domain;
-
-    {
-        std::lock_guard<std::mutex> lk(_proxyDomainsMutex);
-        if (is_leading_dot)
-        {
-            _leadingDotProxyDomains.insert(domain);
-            _exactProxyDomains.erase(normalized_domain); // Avoid duplication
-        }
-        else
-        {
-            _exactProxyDomains.insert(domain);
-            _leadingDotProxyDomains.erase("." + domain); // Avoid duplication
-        }
-    }
-
-    // Invalidate negative cache for this domain and its subdomains
-    {
-        std::lock_guard<std::mutex> cache_lk(_proxyCacheMutex);
-        std::vector<std::string> to_remove;
-        for (const auto& cached_host : _negativeProxyCache)
-        {
-            if (cached_host == normalized_domain || // Exact match
-                (is_leading_dot && EndsWith(cached_host, "." + normalized_domain)))
-            { // Subdomain match
-                to_remove.push_back(cached_host);
-            }
-        }
-        for (const auto& host : to_remove)
-        {
-            _negativeProxyCache.erase(host);
-        }
-    }
+    // ".example.com" and "example.com" replace each other, the matcher gets the new rule before the old one goes.
+    const bool leadingDot = !domain.empty() && domain[0] == '.';
+    _proxyMatcher.AddDomain(domain);
+    _proxyMatcher.RemoveDomain(leadingDot ? domain.substr(1) : "." + domain);
 }
 
 void Client::RemoveDomainToProxy(const std::string& domain)
 {
-    // Normalize for consistency
-    bool is_leading_dot = StartsWith(domain, ".");
-    std::string normalized_domain = is_leading_dot ? domain.substr(1) : domain;
-
-    {
-        std::lock_guard<std::mutex> lk(_proxyDomainsMutex);
-        if (is_leading_dot)
-        {
-            _leadingDotProxyDomains.erase(domain);
-        }
-        else
-        {
-            _exactProxyDomains.erase(domain);
-        }
-    }
-
-    // Invalidate positive cache for this domain and its subdomains
-    {
-        std::lock_guard<std::mutex> cache_lk(_proxyCacheMutex);
-        std::vector<std::string> to_remove;
-        for (const auto& cached_host : _proxyCache)
-        {
-            if (cached_host == normalized_domain || // Exact match
-                (is_leading_dot && EndsWith(cached_host, "." + normalized_domain)))
-            { // Subdomain match
-                to_remove.push_back(cached_host);
-            }
-        }
-        for (const auto& host : to_remove)
-        {
-            _proxyCache.erase(host);
-        }
-    }
+    _proxyMatcher.RemoveDomain(domain);
 }
 
 void Client::AddUrlToModify(const std::string& url)
 {
-    std::lock_guard<std::mutex> lk(_modifyRequestsSetMutex);
-    _modifyRequestsSet.insert(url);
+    _modifyMatcher.Add(UrlPatternKind::Exact, url);
 }
 
 void Client::RemoveUrlToModify(const std::string& url)
 {
-    std::lock_guard<std::mutex> lk(_modifyRequestsSetMutex);
-    _modifyRequestsSet.erase(url);
+    _modifyMatcher.Remove(UrlPatternKind::Exact, url);
 }
 
 void Client::AddDevToolsEventMethod(CefRefPtr<CefBrowser> browser, const std::string& method)
@@ -1315,31 +1580,30 @@ bool Client::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefRefPtr<C
 
         const int32_t browser_identifier = browser ? browser->GetIdentifier() : 0;
 
-        IPC::Singleton.QueueBackgroundWork(
-            [request_id, method, payload_json, browser_identifier]()
-            {
-                IPCBridgeRpcResult result = IPC::Singleton.WindowBridgeRpc(browser_identifier, method, payload_json);
-
-                CefPostTask(TID_UI, base::BindOnce(
-                                        [](int32_t browser_identifier, int32_t request_id, IPCBridgeRpcResult result)
-                                        {
-                                            CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(browser_identifier);
-                                            if (!browser)
-                                            {
-                                                return;
-                                            }
-
-                                            CefRefPtr<CefFrame> frame = browser->GetMainFrame();
-                                            if (!frame)
+        IPC::Singleton.WindowBridgeRpcAsync(browser_identifier, method, payload_json,
+                                            [request_id, browser_identifier](IPCBridgeRpcResult result)
                                             {
-                                                return;
-                                            }
-
-                                            SendBridgeRpcResultMessage(frame, PID_RENDERER, kBridgeRpcCallHostResultMessageName, request_id, result.success,
-                                                                       result.success ? result.result_json.value_or("null") : result.error.value_or("Bridge RPC failed."));
-                                        },
-                                        browser_identifier, request_id, result));
-            });
+                                                CefPostTask(TID_UI, base::BindOnce(
+                                                                        [](int32_t browser_identifier, int32_t request_id, IPCBridgeRpcResult result)
+                                                                        {
+                                                                            CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(browser_identifier);
+                                                                            if (!browser)
+                                                                            {
+                                                                                return;
+                                                                            }
+
+                                                                            CefRefPtr<CefFrame> frame = browser->GetMainFrame();
+                                                                            if (!frame)
+                                                                            {
+                                                                                return;
+                                                                            }
+
+                                                                            SendBridgeRpcResultMessage(frame, PID_RENDERER, kBridgeRpcCallHostResultMessageName, request_id, result.success,
+                                                                                                       result.success ? result.result_json.value_or("null")
+                                                                                                                      : result.error.value_or("Bridge RPC failed."));
+                                                                        },
+                                                                        browser_identifier, request_id, result));
+                                            });
 
         return true;
     }
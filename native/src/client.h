@@ -5,6 +5,10 @@
 #include "include/views/cef_browser_view.h"
 #include "include/wrapper/cef_resource_manager.h"
 #include "ipc.h"
+#include "mount_table.h"
+#include "proxy_response_cache.h"
+#include "request_rewriter.h"
+#include "url_matcher.h"
 
 #include <future>
 #include <unordered_map>
@@ -85,10 +89,13 @@ public:
     std::optional<std::future<std::optional<IPCDevToolsMethodResult>>> ExecuteDevToolsMethod(CefRefPtr<CefBrowser> browser, std::string& method, std::string& json);
     void OverrideTitle(CefRefPtr<CefBrowser> browser, const std::string& title);
     void OverrideIcon(CefRefPtr<CefBrowser> browser, const std::string& iconPath);
-    void AddUrlToProxy(const std::string& url);
-    void RemoveUrlToProxy(const std::string& url);
+    void AddUrlToProxy(const std::string& url, UrlPatternKind kind = UrlPatternKind::Exact);
+    void RemoveUrlToProxy(const std::string& url, UrlPatternKind kind = UrlPatternKind::Exact);
     void AddDomainToProxy(const std::string& domain);
     void RemoveDomainToProxy(const std::string& domain);
+    ProxyResponseCache& GetProxyResponseCache() { return *_proxyResponseCache; }
+    MountTable& GetMountTable() { return _mountTable; }
+    RequestRewriter& GetRequestRewriter() { return _requestRewriter; }
     void AddUrlToModify(const std::string& url);
     void RemoveUrlToModify(const std::string& url);
     void AddDevToolsEventMethod(CefRefPtr<CefBrowser> browser, const std::string& method);
@@ -99,6 +106,8 @@ public:
 
 private:
     void SetTitle(CefRefPtr<CefBrowser> browser, const std::string& title);
+    // False when a rule blocks the request.
+    bool ApplyRequestRewriteRules(CefRefPtr<CefRequest> request);
     bool EnsureDevToolsRegistration(CefRefPtr<CefBrowser> browser);
     void CompleteBridgeRpcCall(int32_t request_id, bool success, const std::optional<std::string>& result_json, const std::optional<std::string>& error);
     void FailAllBridgeRpcCalls(const std::string& error);
@@ -110,18 +119,17 @@ private:
     int _messageIdGenerator = 0;
     int _bridgeRpcRequestIdGenerator = 0;
     std::unordered_set<int> _modifiedRequests;
+    // Requests whose URL a rewrite rule changed, they come back through OnBeforeResourceLoad after the redirect.
+    std::unordered_set<int> _rewrittenRequests;
     std::mutex _modifiedRequestsMutex;
     std::string _titleOverride;
-    std::mutex _proxyRequestsSetMutex;
-    std::unordered_set<std::string> _proxyRequestsSet;
-    std::mutex _proxyDomainsMutex;
-    std::unordered_set<std::string> _exactProxyDomains;
-    std::unordered_set<std::string> _leadingDotProxyDomains;
-    std::mutex _proxyCacheMutex;
-    std::unordered_set<std::string> _proxyCache;
-    std::unordered_set<std::string> _negativeProxyCache;
-    std::mutex _modifyRequestsSetMutex;
-    std::unordered_set<std::string> _modifyRequestsSet;
+    // URLs and domains routed through the controller's RequestProxy.
+    UrlMatcher _proxyMatcher;
+    // Shared with the proxy resource handlers, which may outlive the client.
+    std::shared_ptr<ProxyResponseCache> _proxyResponseCache = std::make_shared<ProxyResponseCache>();
+    MountTable _mountTable;
+    UrlMatcher _modifyMatcher;
+    RequestRewriter _requestRewriter;
     std::mutex _devToolsEventMethodsSetMutex;
     std::unordered_set<std::string> _devToolsEventMethodsSet;
     std::mutex _bridgeRpcResultsMutex;
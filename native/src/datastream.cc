@@ -1,75 +1,271 @@
 #include "datastream.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <utility>
 
-DataStream::DataStream(uint32_t identifier, size_t bufferSize) : _identifier(identifier), _buffer(bufferSize), _capacity(bufferSize)
+namespace
 {
+
+std::array<std::atomic<size_t>, static_cast<size_t>(DataStreamKind::Count)> g_kindMaxCapacity = {
+    DataStream::kDefaultMaxCapacity, DataStream::kDefaultMaxCapacity, DataStream::kDefaultMaxCapacity, DataStream::kDefaultMaxCapacity};
+
+} // namespace
+
+StreamMemoryBudget& StreamMemoryBudget::Global()
+{
+    static StreamMemoryBudget budget;
+    return budget;
 }
 
-size_t DataStream::TryWrite(const uint8_t* data, size_t length)
+void StreamMemoryBudget::SetLimit(size_t limit)
 {
-    std::function<void()> wake;
-    size_t written = 0;
+    if (limit == 0)
+        return;
+
+    _limit.store(limit);
+    if (_waiterCount.load() != 0)
+        RunWaiters();
+}
+
+size_t StreamMemoryBudget::TryAcquire(size_t wanted, bool force)
+{
+    size_t current = _current.load();
+    size_t granted;
+    do
     {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_state != StreamState::Active || length == 0)
+        size_t limit = _limit.load();
+        granted = force ? wanted : std::min(wanted, current < limit ? limit - current : 0);
+        if (granted == 0)
             return 0;
+    } while (!_current.compare_exchange_weak(current, current + granted));
 
-        const size_t space = _capacity - _size;
-        const size_t toWrite = std::min(space, length);
+    size_t peak = _peak.load();
+    while (current + granted > peak && !_peak.compare_exchange_weak(peak, current + granted))
+    {
+    }
+    return granted;
+}
 
-        const size_t firstPart = std::min(toWrite, _capacity - _tail);
-        std::copy_n(data, firstPart, _buffer.begin() + _tail);
-        _tail = (_tail + firstPart) % _capacity;
-        if (firstPart < toWrite)
-        {
-            const size_t secondPart = toWrite - firstPart;
-            std::copy_n(data + firstPart, secondPart, _buffer.begin() + _tail);
-            _tail = (_tail + secondPart) % _capacity;
-        }
-        _size += toWrite;
-        written = toWrite;
+void StreamMemoryBudget::Release(size_t bytes)
+{
+    if (bytes == 0)
+        return;
 
-        if (written > 0)
-        {
-            _cv.notify_all();
-            if (_readWakeup)
-                wake = std::exchange(_readWakeup, nullptr);
-        }
-    }
-    if (wake)
-        wake();
-    return written;
+    _current.fetch_sub(bytes);
+    if (_waiterCount.load() == 0)
+        return;
+
+    RunWaiters();
 }
 
-void DataStream::MarkCompleted(uint64_t totalBytes)
+void StreamMemoryBudget::RunWaiters()
 {
-    std::function<void()> wake, spaceWake;
+    std::vector<std::function<void()>> waiters;
+    std::function<void(std::function<void()>)> executor;
     {
         std::lock_guard<std::mutex> lock(_mutex);
-        if (_state != StreamState::Active)
-            return;
-        _state = StreamState::Completed;
-        _finalTotal = totalBytes;
-        _cv.notify_all();
-        wake = std::exchange(_readWakeup, nullptr);
-        spaceWake = std::exchange(_spaceWakeup, nullptr);
+        waiters.swap(_waiters);
+        _waiterCount.store(0);
+        executor = _waiterExecutor;
+    }
+    for (auto& waiter : waiters)
+    {
+        if (executor)
+            executor(std::move(waiter));
+        else
+            waiter();
     }
-    if (wake)
-        wake();
-    if (spaceWake)
-        spaceWake();
 }
 
-void DataStream::MarkCanceled()
+void StreamMemoryBudget::SetWaiterExecutor(std::function<void(std::function<void()>)> executor)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _waiterExecutor = std::move(executor);
+}
+
+bool StreamMemoryBudget::RegisterWaiter(std::function<void()>&& waiter)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Counted before the check so a concurrent Release either sees the waiter or we see its bytes.
+    _waiterCount.fetch_add(1);
+    if (!Exhausted())
+    {
+        _waiterCount.fetch_sub(1);
+        return false;
+    }
+
+    _waiters.push_back(std::move(waiter));
+    return true;
+}
+
+StreamMemoryBudget::Stats StreamMemoryBudget::GetStats() const
+{
+    Stats stats;
+    stats.limit = _limit.load();
+    stats.current = _current.load();
+    stats.peak = _peak.load();
+    return stats;
+}
+
+void DataStream::SetKindMaxCapacity(DataStreamKind kind, size_t maxCapacity)
+{
+    if (kind < DataStreamKind::Count && maxCapacity > 0)
+        g_kindMaxCapacity[static_cast<size_t>(kind)].store(maxCapacity);
+}
+
+size_t DataStream::KindMaxCapacity(DataStreamKind kind)
+{
+    if (kind >= DataStreamKind::Count)
+        kind = DataStreamKind::Generic;
+    return g_kindMaxCapacity[static_cast<size_t>(kind)].load();
+}
+
+DataStream::DataStream(uint32_t identifier, size_t maxCapacity) : _identifier(identifier), _maxCapacity(std::max<size_t>(maxCapacity, 1))
+{
+}
+
+DataStream::~DataStream()
+{
+    StreamMemoryBudget::Global().Release(Buffered());
+
+    Block* block = _readBlock ? _readBlock : _firstBlock.load();
+    while (block)
+    {
+        Block* next = block->next.load();
+        delete block;
+        block = next;
+    }
+    delete _spareBlock.load();
+}
+
+void DataStream::AppendBlock(size_t wanted)
+{
+    size_t capacity = kInitialCapacity;
+    while (capacity < wanted && capacity < kMaxBlockSize)
+        capacity *= 2;
+
+    Block* block = _spareBlock.exchange(nullptr, std::memory_order_acquire);
+    if (block && block->capacity < capacity)
+    {
+        FreeBlock(block);
+        block = nullptr;
+    }
+    if (block)
+    {
+        block->used = 0;
+        block->next.store(nullptr, std::memory_order_relaxed);
+    }
+    else
+    {
+        block = new Block(capacity);
+        _allocatedBytes.fetch_add(capacity, std::memory_order_relaxed);
+    }
+
+    LinkBlock(block);
+    _writeOffset = 0;
+}
+
+void DataStream::LinkBlock(Block* block)
+{
+    // Linked before the bytes in it are published, so the consumer always finds the block it needs.
+    if (_writeBlock)
+    {
+        _writeBlock->used = _writeOffset;
+        _writeBlock->next.store(block, std::memory_order_release);
+    }
+    else
+        _firstBlock.store(block, std::memory_order_release);
+    _writeBlock = block;
+}
+
+void DataStream::RecycleBlock(Block* block)
+{
+    if (!block->storage || State() != StreamState::Active)
+    {
+        FreeBlock(block);
+        return;
+    }
+
+    Block* previous = _spareBlock.exchange(block, std::memory_order_acq_rel);
+    if (previous)
+        FreeBlock(previous);
+}
+
+void DataStream::FreeBlock(Block* block)
+{
+    if (block->storage)
+        _allocatedBytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+    delete block;
+}
+
+size_t DataStream::AcquireSpace(size_t length, bool credited)
+{
+    if (State() != StreamState::Active || length == 0)
+        return 0;
+
+    const size_t buffered = Buffered();
+    const size_t maxCapacity = _maxCapacity.load(std::memory_order_relaxed);
+    const size_t space = buffered < maxCapacity ? maxCapacity - buffered : 0;
+    return StreamMemoryBudget::Global().TryAcquire(std::min(space, length), credited || buffered == 0);
+}
+
+size_t DataStream::TryWrite(const uint8_t* data, size_t length, bool credited)
 {
+    const size_t toWrite = AcquireSpace(length, credited);
+    if (toWrite == 0)
+        return 0;
+
+    const size_t buffered = Buffered();
+    size_t written = 0;
+    while (written < toWrite)
+    {
+        if (!_writeBlock || !_writeBlock->storage || _writeOffset == _writeBlock->capacity)
+            AppendBlock(buffered + toWrite - written);
+
+        const size_t part = std::min(toWrite - written, _writeBlock->capacity - _writeOffset);
+        std::copy_n(data + written, part, _writeBlock->storage.get() + _writeOffset);
+        _writeOffset += part;
+        written += part;
+    }
+
+    // Publishing and checking the flag are both sequentially consistent, pairing with the waiting side.
+    _writtenTotal.fetch_add(toWrite);
+    if (_readWaiting.load())
+        WakeReader();
+    return toWrite;
+}
+
+size_t DataStream::TryAdopt(std::shared_ptr<const std::vector<uint8_t>> buffer, const uint8_t* data, size_t length, bool credited)
+{
+    if (!buffer || length < kMinAdoptSize || buffer->size() > length * 2)
+        return TryWrite(data, length, credited);
+
+    const size_t toAdopt = AcquireSpace(length, credited);
+    if (toAdopt == 0)
+        return 0;
+
+    LinkBlock(new Block(std::move(buffer), data, toAdopt));
+    _writeOffset = toAdopt;
+
+    _writtenTotal.fetch_add(toAdopt);
+    if (_readWaiting.load())
+        WakeReader();
+    return toAdopt;
+}
+
+bool DataStream::MarkFinished(StreamState state)
+{
+    StreamState expected = StreamState::Active;
+    if (!_state.compare_exchange_strong(expected, state))
+        return false;
+
     std::function<void()> wake, spaceWake;
     {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_state != StreamState::Active)
-            return;
-        _state = StreamState::Canceled;
+        std::lock_guard<std::mutex> lock(_wakeupMutex);
+        _readWaiting.store(false);
+        _spaceWaiting.store(false);
         _cv.notify_all();
         wake = std::exchange(_readWakeup, nullptr);
         spaceWake = std::exchange(_spaceWakeup, nullptr);
@@ -78,135 +274,175 @@ void DataStream::MarkCanceled()
         wake();
     if (spaceWake)
         spaceWake();
+    return true;
+}
+
+void DataStream::MarkCompleted(uint64_t totalBytes)
+{
+    if (State() != StreamState::Active)
+        return;
+    // Stored ahead of the state, a reader that sees Completed also sees the total.
+    _finalTotal.store(totalBytes, std::memory_order_release);
+    MarkFinished(StreamState::Completed);
+}
+
+void DataStream::MarkCanceled()
+{
+    MarkFinished(StreamState::Canceled);
 }
 
 void DataStream::MarkError()
 {
-    std::function<void()> wake, spaceWake;
+    MarkFinished(StreamState::Error);
+}
+
+void DataStream::WakeReader()
+{
+    std::function<void()> wake;
     {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_state != StreamState::Active)
-            return;
-        _state = StreamState::Error;
+        std::lock_guard<std::mutex> lock(_wakeupMutex);
+        _readWaiting.store(false);
         _cv.notify_all();
         wake = std::exchange(_readWakeup, nullptr);
-        spaceWake = std::exchange(_spaceWakeup, nullptr);
     }
     if (wake)
         wake();
-    if (spaceWake)
-        spaceWake();
 }
 
-size_t DataStream::ReadSome(uint8_t* buffer, size_t bufferSize)
+void DataStream::WakeWriter()
 {
-    std::function<void()> spaceWake;
-    size_t toRead = 0;
+    std::function<void()> wake;
     {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_size == 0 || bufferSize == 0)
-            return 0;
-
-        toRead = std::min(_size, bufferSize);
-        const size_t firstPart = std::min(toRead, _capacity - _head);
-        std::copy_n(_buffer.begin() + _head, firstPart, buffer);
-        _head = (_head + firstPart) % _capacity;
-        if (firstPart < toRead)
-        {
-            const size_t secondPart = toRead - firstPart;
-            std::copy_n(_buffer.begin() + _head, secondPart, buffer + firstPart);
-            _head = (_head + secondPart) % _capacity;
-        }
-        _size -= toRead;
-        _consumedTotal += toRead;
-
-        spaceWake = std::exchange(_spaceWakeup, nullptr);
+        std::lock_guard<std::mutex> lock(_wakeupMutex);
+        _spaceWaiting.store(false);
+        wake = std::exchange(_spaceWakeup, nullptr);
     }
-    if (spaceWake)
-        spaceWake();
-    return toRead;
+    if (wake)
+        wake();
 }
 
-size_t DataStream::Read(uint8_t* buffer, size_t bufferSize)
+size_t DataStream::CopyOut(uint8_t* buffer, size_t bufferSize)
 {
-    std::function<void()> spaceWake;
-    size_t toRead = 0;
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        if (bufferSize == 0)
-            return 0;
-        _cv.wait(lock, [this] { return _size != 0 || _state != StreamState::Active; });
-        if (_size == 0)
-            return 0;
+    const uint64_t consumed = _consumedTotal.load(std::memory_order_relaxed);
+    const size_t available = static_cast<size_t>(_writtenTotal.load(std::memory_order_acquire) - consumed);
+    const size_t toRead = std::min(available, bufferSize);
+    if (toRead == 0)
+        return 0;
+
+    if (!_readBlock)
+        _readBlock = _firstBlock.load(std::memory_order_acquire);
 
-        toRead = std::min(_size, bufferSize);
-        const size_t firstPart = std::min(toRead, _capacity - _head);
-        std::copy_n(_buffer.begin() + _head, firstPart, buffer);
-        _head = (_head + firstPart) % _capacity;
-        if (firstPart < toRead)
+    size_t read = 0;
+    while (read < toRead)
+    {
+        // Once a block has a successor its fill is final, until then everything available sits in it.
+        Block* next = _readBlock->next.load(std::memory_order_acquire);
+        const size_t end = next ? _readBlock->used : _readBlock->capacity;
+        if (_readOffset == end)
         {
-            const size_t secondPart = toRead - firstPart;
-            std::copy_n(_buffer.begin() + _head, secondPart, buffer + firstPart);
-            _head = (_head + secondPart) % _capacity;
+            RecycleBlock(_readBlock);
+            _readBlock = next;
+            _readOffset = 0;
+            continue;
         }
-        _size -= toRead;
-        _consumedTotal += toRead;
 
-        spaceWake = std::exchange(_spaceWakeup, nullptr);
+        const size_t part = std::min(toRead - read, end - _readOffset);
+        std::copy_n(_readBlock->data + _readOffset, part, buffer + read);
+        _readOffset += part;
+        read += part;
     }
-    if (spaceWake)
-        spaceWake();
+
+    _consumedTotal.store(consumed + toRead);
+    if (_spaceWaiting.load())
+        WakeWriter();
+
+    StreamMemoryBudget::Global().Release(toRead);
+    if (_consumeListener)
+        _consumeListener(toRead, available - toRead);
     return toRead;
 }
 
-StreamState DataStream::State() const
+size_t DataStream::ReadSome(uint8_t* buffer, size_t bufferSize)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _state;
+    if (bufferSize == 0)
+        return 0;
+    return CopyOut(buffer, bufferSize);
 }
 
-bool DataStream::Drained() const
+size_t DataStream::ReadSome(uint8_t* buffer, size_t bufferSize, StreamState& state)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _size == 0 && _state != StreamState::Active;
+    // Every write happens before the state leaves Active, so reading after loading it cannot miss a tail.
+    state = State();
+    return ReadSome(buffer, bufferSize);
 }
 
-uint64_t DataStream::ConsumedTotal() const
+size_t DataStream::Read(uint8_t* buffer, size_t bufferSize)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _consumedTotal;
+    if (bufferSize == 0)
+        return 0;
+
+    size_t read = CopyOut(buffer, bufferSize);
+    if (read > 0)
+        return read;
+
+    {
+        std::unique_lock<std::mutex> lock(_wakeupMutex);
+        while (true)
+        {
+            _readWaiting.store(true);
+            if (Buffered() != 0 || State() != StreamState::Active)
+                break;
+            _cv.wait(lock);
+        }
+        _readWaiting.store(false);
+    }
+    return CopyOut(buffer, bufferSize);
+}
+
+bool DataStream::Drained() const
+{
+    if (State() == StreamState::Active)
+        return false;
+    return Buffered() == 0;
 }
 
-uint64_t DataStream::FinalTotal() const
+void DataStream::SetMaxCapacity(size_t maxCapacity)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _finalTotal;
+    _maxCapacity.store(std::max<size_t>(maxCapacity, 1));
+    if (_spaceWaiting.load())
+        WakeWriter();
 }
 
 void DataStream::RegisterReadWakeup(std::function<void()> cb)
 {
-    std::function<void()> fireNow;
     {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (!isEmpty() || _state != StreamState::Active)
-            fireNow = std::move(cb);
-        else
-            _readWakeup = std::move(cb);
+        std::lock_guard<std::mutex> lock(_wakeupMutex);
+        _readWakeup = std::move(cb);
+        _readWaiting.store(true);
+        if (Buffered() == 0 && State() == StreamState::Active)
+            return;
+        _readWaiting.store(false);
+        cb = std::exchange(_readWakeup, nullptr);
     }
-    if (fireNow)
-        fireNow();
+    if (cb)
+        cb();
 }
 
 void DataStream::RegisterSpaceWakeup(std::function<void()> cb)
 {
-    std::function<void()> fireNow;
+    if (State() == StreamState::Active && Buffered() >= _maxCapacity.load())
     {
-        std::lock_guard<std::mutex> lock(_mutex);
-        if (_size < _capacity || _state != StreamState::Active)
-            fireNow = std::move(cb);
-        else
-            _spaceWakeup = std::move(cb);
+        std::lock_guard<std::mutex> lock(_wakeupMutex);
+        _spaceWakeup = std::move(cb);
+        _spaceWaiting.store(true);
+        if (Buffered() >= _maxCapacity.load() && State() == StreamState::Active)
+            return;
+        _spaceWaiting.store(false);
+        cb = std::exchange(_spaceWakeup, nullptr);
     }
-    if (fireNow)
-        fireNow();
+    else if (State() == StreamState::Active && Buffered() != 0 && StreamMemoryBudget::Global().RegisterWaiter(std::move(cb)))
+        return;
+
+    if (cb)
+        cb();
 }
@@ -1,9 +1,11 @@
 #ifndef DATASTREAM_H
 #define DATASTREAM_H
 
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -15,46 +17,174 @@ enum class StreamState : uint8_t
     Error = 3
 };
 
+// What an incoming stream carries, each kind has its own buffer limit.
+enum class DataStreamKind : uint8_t
+{
+    Generic = 0,
+    ProxyResponseBody = 1,
+    RequestBody = 2,
+    BridgePayload = 3,
+    Count = 4
+};
+
+// Process-wide limit on the bytes buffered in DataStreams. Plain writes that find it exhausted are cut short and
+// the producer waits through RegisterSpaceWakeup. A write into an empty stream always goes through, so a reader
+// blocked on one stream can never be starved by data buffered for others.
+class StreamMemoryBudget
+{
+public:
+    struct Stats
+    {
+        size_t limit = 0;
+        size_t current = 0;
+        size_t peak = 0;
+    };
+
+    static constexpr size_t kDefaultLimit = 128 * 1024 * 1024;
+
+    static StreamMemoryBudget& Global();
+
+    // Set from --ipc-stream-memory-limit, 0 keeps the current limit.
+    void SetLimit(size_t limit);
+    bool Exhausted() const { return _current.load() >= _limit.load(); }
+    // Takes up to wanted bytes, all of them when force is set.
+    size_t TryAcquire(size_t wanted, bool force);
+    void Release(size_t bytes);
+    // Registers waiter to run once bytes are released. Returns false and leaves waiter untouched when the budget
+    // is not exhausted right now.
+    bool RegisterWaiter(std::function<void()>&& waiter);
+    // Waiters are handed to executor so the consumer that released the bytes never runs another stream's producer
+    // on its own thread. Without one they run inline.
+    void SetWaiterExecutor(std::function<void(std::function<void()>)> executor);
+    Stats GetStats() const;
+
+private:
+    void RunWaiters();
+
+    std::atomic<size_t> _limit = kDefaultLimit;
+    std::atomic<size_t> _current = 0;
+    std::atomic<size_t> _peak = 0;
+    std::atomic<size_t> _waiterCount = 0;
+    std::mutex _mutex;
+    std::vector<std::function<void()>> _waiters;
+    std::function<void(std::function<void()>)> _waiterExecutor;
+};
+
+// Single-producer/single-consumer byte queue. Data lives in a chain of blocks that the producer appends and the
+// consumer frees behind itself, a block is either owned by the stream or a slice of an adopted receive buffer, so neither side ever waits for the other: positions and state are atomics and
+// the wakeup mutex is only taken once a side has announced that it is waiting. Blocks start at kInitialCapacity
+// and are sized after the current backlog, up to kMaxBlockSize. One drained block is kept for reuse while the
+// stream is active.
+//
+// TryWrite must be called by one producer at a time and the Read functions by one consumer at a time, a hand-off
+// between threads needs its own synchronization like the space wakeup provides. The Mark functions may race.
 class DataStream
 {
 public:
-    DataStream(uint32_t identifier, size_t bufferSize = 10 * 1024 * 1024);
+    static constexpr size_t kInitialCapacity = 16 * 1024;
+    static constexpr size_t kMaxBlockSize = 256 * 1024;
+    static constexpr size_t kMinAdoptSize = 4 * 1024;
+    static constexpr size_t kDefaultMaxCapacity = 10 * 1024 * 1024;
+
+    // Set from the --ipc-*-stream-capacity flags before Start, 0 keeps the current limit.
+    static void SetKindMaxCapacity(DataStreamKind kind, size_t maxCapacity);
+    static size_t KindMaxCapacity(DataStreamKind kind);
 
-    size_t TryWrite(const uint8_t* data, size_t length);
+    DataStream(uint32_t identifier, size_t maxCapacity = kDefaultMaxCapacity);
+    ~DataStream();
+
+    // Credited bytes were already promised to the sender, they count against the memory budget but are never
+    // refused because of it.
+    size_t TryWrite(const uint8_t* data, size_t length, bool credited = false);
+    // Like TryWrite, but queues data in place and keeps buffer alive until it is read. Small slices, and slices
+    // that would pin a buffer more than twice their size, are copied instead.
+    size_t TryAdopt(std::shared_ptr<const std::vector<uint8_t>> buffer, const uint8_t* data, size_t length, bool credited = false);
 
     void MarkCompleted(uint64_t totalBytes);
     void MarkCanceled();
     void MarkError();
 
     size_t ReadSome(uint8_t* buffer, size_t bufferSize);
+    // Also reports the state seen before reading, a result of 0 with any state but Active means the stream is
+    // drained.
+    size_t ReadSome(uint8_t* buffer, size_t bufferSize, StreamState& state);
 
     size_t Read(uint8_t* buffer, size_t bufferSize);
 
-    StreamState State() const;
+    StreamState State() const { return _state.load(std::memory_order_acquire); }
     bool Drained() const;
-    uint64_t ConsumedTotal() const;
-    uint64_t FinalTotal() const;
-    uint64_t Capacity() const { return _capacity; }
+    uint64_t ConsumedTotal() const { return _consumedTotal.load(std::memory_order_acquire); }
+    uint64_t FinalTotal() const { return _finalTotal.load(std::memory_order_acquire); }
+    uint64_t Capacity() const { return _maxCapacity.load(std::memory_order_relaxed); }
+    size_t AllocatedBytes() const { return _allocatedBytes.load(std::memory_order_relaxed); }
+    // Only affects future writes, buffered bytes above a lowered limit stay.
+    void SetMaxCapacity(size_t maxCapacity);
 
     void RegisterReadWakeup(std::function<void()> cb);
 
     void RegisterSpaceWakeup(std::function<void()> cb);
 
+    // Called with the number of bytes taken out by every Read/ReadSome and the bytes still buffered, on the
+    // consumer thread. Must be set before the stream is shared with other threads.
+    void SetConsumeListener(std::function<void(size_t consumed, size_t buffered)> listener) { _consumeListener = std::move(listener); }
+
     uint32_t GetIdentifier() const { return _identifier; }
 
 private:
+    struct Block
+    {
+        explicit Block(size_t capacity) : storage(new uint8_t[capacity]), data(storage.get()), capacity(capacity) {}
+        Block(std::shared_ptr<const std::vector<uint8_t>> owner, const uint8_t* data, size_t length)
+            : owner(std::move(owner)), data(data), capacity(length), used(length)
+        {
+        }
+
+        std::unique_ptr<uint8_t[]> storage;
+        std::shared_ptr<const std::vector<uint8_t>> owner;
+        const uint8_t* data;
+        size_t capacity;
+        // Final fill, written before next is published.
+        size_t used = 0;
+        std::atomic<Block*> next = nullptr;
+    };
+
     uint32_t _identifier;
-    std::vector<uint8_t> _buffer;
-    mutable std::mutex _mutex;
+    std::atomic<size_t> _maxCapacity;
+    std::atomic<StreamState> _state = StreamState::Active;
+    std::atomic<uint64_t> _finalTotal = 0;
+    std::atomic<size_t> _allocatedBytes = 0;
+    std::atomic<Block*> _firstBlock = nullptr;
+    std::atomic<Block*> _spareBlock = nullptr;
+    std::function<void(size_t consumed, size_t buffered)> _consumeListener;
+
+    // Producer side.
+    alignas(64) std::atomic<uint64_t> _writtenTotal = 0;
+    Block* _writeBlock = nullptr;
+    size_t _writeOffset = 0;
+
+    // Consumer side.
+    alignas(64) std::atomic<uint64_t> _consumedTotal = 0;
+    Block* _readBlock = nullptr;
+    size_t _readOffset = 0;
+
+    // Wakeups, the flags tell the other side that it has to take the mutex.
+    alignas(64) std::atomic<bool> _readWaiting = false;
+    std::atomic<bool> _spaceWaiting = false;
+    std::mutex _wakeupMutex;
     std::condition_variable _cv;
-    size_t _head = 0, _tail = 0, _size = 0, _capacity;
-    StreamState _state = StreamState::Active;
-    uint64_t _consumedTotal = 0;
-    uint64_t _finalTotal = 0;
     std::function<void()> _readWakeup;
     std::function<void()> _spaceWakeup;
 
-    bool isEmpty() const { return _size == 0; }
+    size_t Buffered() const { return static_cast<size_t>(_writtenTotal.load() - _consumedTotal.load()); }
+    bool MarkFinished(StreamState state);
+    size_t AcquireSpace(size_t length, bool credited);
+    void LinkBlock(Block* block);
+    void AppendBlock(size_t wanted);
+    void RecycleBlock(Block* block);
+    void FreeBlock(Block* block);
+    size_t CopyOut(uint8_t* buffer, size_t bufferSize);
+    void WakeReader();
+    void WakeWriter();
 };
 
 #endif // DATASTREAM_H
@@ -15,6 +15,7 @@
 #include "include/wrapper/cef_closure_task.h"
 #include "include/wrapper/cef_stream_resource_handler.h"
 
+#include <algorithm>
 #include <future>
 #include <include/cef_app.h>
 #include <iomanip>
@@ -38,7 +39,6 @@ namespace
 
 constexpr uint8_t kIPCProxyBodyElementStream = 3;
 constexpr size_t kInlineBodyElementFramingSize = sizeof(uint8_t) + sizeof(uint32_t);
-constexpr size_t kStreamChunkSize = 65536;
 constexpr size_t kBridgeRpcInlinePayloadFramingSize = sizeof(uint8_t) + sizeof(uint32_t);
 constexpr size_t kBinaryInlinePayloadFramingSize = sizeof(uint8_t) + sizeof(uint32_t);
 
@@ -79,16 +79,66 @@ bool WriteInlineBridgeRpcResult(PacketWriter& writer, bool success, const std::s
     return writer.write<bool>(success) && WriteInlineBridgeRpcPayload(writer, payload);
 }
 
+// Layout per rule: uint8 UrlPatternKind, string urlPattern, string method, uint32 resourceTypes, bool block,
+// string rewriteUrl, uint32 n + n * (string name, string value) to set, uint32 m + m * string name to remove.
+std::optional<std::vector<RequestRewriteRule>> ReadRequestRewriteRules(PacketReader& reader)
+{
+    std::optional<uint32_t> count = reader.read<uint32_t>();
+    if (!count)
+        return std::nullopt;
+
+    std::vector<RequestRewriteRule> rules;
+    for (uint32_t i = 0; i < *count; i++)
+    {
+        std::optional<uint8_t> urlKind = reader.read<uint8_t>();
+        std::optional<std::string> urlPattern = reader.readSizePrefixedString();
+        std::optional<std::string> method = reader.readSizePrefixedString();
+        std::optional<uint32_t> resourceTypes = reader.read<uint32_t>();
+        std::optional<bool> block = reader.read<bool>();
+        std::optional<std::string> rewriteUrl = reader.readSizePrefixedString();
+        std::optional<uint32_t> setCount = reader.read<uint32_t>();
+        if (!urlKind || *urlKind > (uint8_t)UrlPatternKind::Glob || !urlPattern || !method || !resourceTypes || !block || !rewriteUrl || !setCount)
+            return std::nullopt;
+
+        RequestRewriteRule rule;
+        rule.urlKind = (UrlPatternKind)*urlKind;
+        rule.urlPattern = std::move(*urlPattern);
+        rule.method = std::move(*method);
+        rule.resourceTypes = *resourceTypes;
+        rule.block = *block;
+        rule.rewriteUrl = std::move(*rewriteUrl);
+        for (uint32_t j = 0; j < *setCount; j++)
+        {
+            std::optional<std::string> name = reader.readSizePrefixedString();
+            std::optional<std::string> value = reader.readSizePrefixedString();
+            if (!name || !value)
+                return std::nullopt;
+            rule.setHeaders.emplace_back(std::move(*name), std::move(*value));
+        }
+
+        std::optional<uint32_t> removeCount = reader.read<uint32_t>();
+        if (!removeCount)
+            return std::nullopt;
+        for (uint32_t j = 0; j < *removeCount; j++)
+        {
+            std::optional<std::string> name = reader.readSizePrefixedString();
+            if (!name)
+                return std::nullopt;
+            rule.removeHeaders.push_back(std::move(*name));
+        }
+        rules.push_back(std::move(rule));
+    }
+    return rules;
+}
+
 } // namespace
 
 IPC IPC::Singleton;
 
-IPC::IPC() : _ipcBufferPool(sizeof(IPCPacketHeader) + MAXIMUM_IPC_SIZE, 4)
+IPC::IPC() : _ipcBufferPool(MAXIMUM_IPC_SIZE)
 {
-    _requestIdCounter = 0;
     _streamIdentifierCounter = 0;
     _readBuffer.resize(4096);
-    _sendBuffer.resize(4096);
 }
 
 IPC::~IPC()
@@ -96,6 +146,30 @@ IPC::~IPC()
     Stop();
 }
 
+void IPC::SetTransportLimits(size_t maxPacketSize, size_t inlineThreshold)
+{
+    _maxPacketSize = std::clamp<size_t>(maxPacketSize, MINIMUM_IPC_SIZE, MAXIMUM_IPC_SIZE);
+    _inlineThreshold = std::min(inlineThreshold, _maxPacketSize);
+    _ipcBufferPool.SetMaxBufferSize(_maxPacketSize);
+    PacketWriter::SetDefaultMaxSize(_maxPacketSize);
+    LOG(INFO) << "IPC transport limits (maxPacketSize = " << _maxPacketSize << ", inlineThreshold = " << _inlineThreshold << ").";
+}
+
+void IPC::SetControllerCapabilities(uint32_t capabilities)
+{
+    _controllerCapabilities = capabilities;
+    LOG(INFO) << "IPC controller capabilities " << capabilities << ".";
+}
+
+void IPC::NotifyReady()
+{
+    PacketWriter writer;
+    writer.write<uint32_t>((uint32_t)_maxPacketSize);
+    writer.write<uint32_t>((uint32_t)_inlineThreshold);
+    writer.write<uint32_t>(kRuntimeCapabilities);
+    Notify(OpcodeClientNotification::Ready, std::move(writer));
+}
+
 #ifndef JUSTCEF_NATIVE_VERSION
 #define JUSTCEF_NATIVE_VERSION 0
 #endif
@@ -113,8 +187,35 @@ void IPC::Start()
 
     _stopped = false;
 
-    _worker.Start();
-    _threadPool.AddWorkers(4);
+    if (_shm.IsAttached())
+    {
+        // Last packet on the pipe: everything after it is written to the shared memory ring.
+        IPCPacketHeader marker = MakePacketHeader(PacketType::Notification, (uint8_t)OpcodeClientNotification::TransportSwitch, 0, 0);
+        if (_pipe.Write(&marker, sizeof(marker), true) == sizeof(marker))
+        {
+            _shmWriteActive = true;
+            LOG(INFO) << "Switched IPC writes to the shared memory transport.";
+        }
+    }
+
+    _threadPool.Start();
+    StreamMemoryBudget::Global().SetWaiterExecutor(
+        [this](std::function<void()> waiter)
+        {
+            if (!_threadPool.Enqueue(waiter))
+                waiter();
+        });
+    _writerStopping = false;
+    for (size_t i = 0; i < kLaneCount; i++)
+    {
+        Lane lane = (Lane)i;
+        _outboundLanes[i].thread = std::thread(
+            [this, lane]()
+            {
+                RunWriter(lane);
+            });
+        _outboundLanes[i].thread.detach();
+    }
     _thread = std::thread(
         [this]()
         {
@@ -142,10 +243,29 @@ void IPC::Stop()
     if (_stopped)
         return;
 
-    LOG(INFO) << "Stopping IPC.";
+    BufferPool::Stats poolStats = _ipcBufferPool.GetStats();
+    StreamMemoryBudget::Stats streamMemory = StreamMemoryBudget::Global().GetStats();
+    LOG(INFO) << "Stopping IPC (received bytes copied = " << _receivedBytesCopied.load() << ", buffer pool hits = " << poolStats.hits << ", misses = " << poolStats.misses
+              << ", resident bytes = " << poolStats.residentBytes << ", stream memory = " << streamMemory.current << ", peak = " << streamMemory.peak << " of "
+              << streamMemory.limit << ").";
+    ThreadPool::Stats poolTasks = _threadPool.GetStats();
+    LOG(INFO) << "Thread pool: " << poolTasks.workers << " workers (" << poolTasks.blockedWorkers << " blocked), " << poolTasks.tasksRun << " tasks run, queue depth "
+              << poolTasks.queuedTasks << " (peak " << poolTasks.peakQueuedTasks << "), task latency average " << poolTasks.averageLatencyUs << " us, max "
+              << poolTasks.maxLatencyUs << " us.";
+    OutboundStats outbound = OutboundQueueStats();
+    LOG(INFO) << "Outbound queue: " << outbound.pendingPackets << " packets pending (response bytes = " << outbound.pendingBytes[(size_t)OutboundClass::Response]
+              << ", control bytes = " << outbound.pendingBytes[(size_t)OutboundClass::Control] << ", stream bytes = " << outbound.pendingBytes[(size_t)OutboundClass::Stream]
+              << ").";
 
     _stopped = true;
 
+    {
+        std::lock_guard<std::mutex> lk(_outboundMutex);
+        _writerStopping = true;
+    }
+    for (OutboundLane& lane : _outboundLanes)
+        lane.condition.notify_one();
+
 #ifdef _WIN32
     if (_readThreadId != 0)
     {
@@ -157,36 +277,27 @@ void IPC::Stop()
         }
     }
 #endif
+    _shm.Close();
     _pipe.Close();
 
     LOG(INFO) << "Stopped pipe.";
 
-    _worker.Stop();
-    LOG(INFO) << "Stopped worker.";
+    _windowExecutors.Clear();
+    LOG(INFO) << "Cleared window work.";
 
     _threadPool.Stop();
     LOG(INFO) << "Stopped thread pool.";
 
     LOG(INFO) << "Cancelling pending requests...";
 
-    std::unordered_map<uint32_t, std::shared_ptr<IPCPendingRequest>> pendingRequests;
-
-    {
-        std::lock_guard<std::mutex> lk(_requestMapMutex);
-        pendingRequests = _pendingRequests;
-    }
-
-    {
-        for (auto& pendingRequest : pendingRequests)
-        {
-            {
-                std::unique_lock lk(pendingRequest.second->mutex);
-                pendingRequest.second->ready = true;
-            }
-
-            pendingRequest.second->conditionVariable.notify_one();
-        }
-    }
+    // Requests that were not flushed yet still have their packet in the writer, it completes them through onAbort
+    // once it drops the packet. Completing them here could free borrowed bodies the writer still references. A
+    // request the writer marks flushed after this sweep is completed by the writer itself.
+    _pendingRequests.TakeAll(true,
+                             [this](IPCPendingRequest pendingRequest)
+                             {
+                                 CompletePendingRequest(std::move(pendingRequest), std::nullopt);
+                             });
 
     LOG(INFO) << "Cancelled pending requests.";
 
@@ -214,34 +325,22 @@ void IPC::Stop()
         }
         for (auto& [id, reply] : pending)
         {
-            const uint8_t status = static_cast<uint8_t>(StreamDataStatus::Closed);
-            WriteResponse(reply.requestId, reply.opcode, &status, sizeof(status));
+            std::shared_ptr<const uint8_t> status = std::make_shared<const uint8_t>(static_cast<uint8_t>(StreamDataStatus::Closed));
+            const IOSegment body = {status.get(), sizeof(uint8_t)};
+            WriteResponse(reply.requestId, reply.opcode, &body, 1, status);
         }
     }
 
     LOG(INFO) << "Closed data streams.";
 
-    {
-        std::unordered_map<uint32_t, std::shared_ptr<IncomingStreamDispatcher>> incomingStreamDispatchers;
-
-        {
-            std::lock_guard<std::mutex> lk(_incomingStreamDispatchersMutex);
-            incomingStreamDispatchers.swap(_incomingStreamDispatchers);
-        }
-
-        for (auto& incomingStreamDispatcher : incomingStreamDispatchers)
-        {
-            std::lock_guard<std::mutex> lk(incomingStreamDispatcher.second->mutex);
-            std::queue<std::function<void()>> emptyQueue;
-            incomingStreamDispatcher.second->queue.swap(emptyQueue);
-        }
-    }
+    _incomingStreamExecutors.Clear();
 
     {
         std::lock_guard<std::mutex> lk(_outgoingStreamsMutex);
         for (auto& outgoingStream : _outgoingStreams)
             outgoingStream.second->store(true);
         _outgoingStreams.clear();
+        _clientStreamUploads.clear();
     }
 
     /*LOG(INFO) << "Joining IPC threads...";
@@ -270,10 +369,12 @@ void IPC::Run()
     LOG(INFO) << "IPC running.";
 
     IPCPacketHeader header;
+    // The packet whose Fragment frames are being received, per lane. Other packets arrive in between.
+    InboundPacket fragmentedPackets[kLaneCount];
 
     while (IsAvailable())
     {
-        size_t headerBytesRead = _pipe.Read(&header, sizeof(IPCPacketHeader), true);
+        size_t headerBytesRead = ReadTransport(&header, sizeof(IPCPacketHeader));
         if (headerBytesRead == 0)
         {
             LOG(INFO) << "Pipe closed. Parent process likely wants child to exit.";
@@ -288,224 +389,264 @@ void IPC::Run()
             return;
         }
 
-        size_t bodySize = header.size + sizeof(uint32_t) - sizeof(IPCPacketHeader);
-        if (bodySize > MAXIMUM_IPC_SIZE)
-        {
-            LOG(INFO) << "Invalid packet size (" << bodySize << " bytes). Shutting down.";
-            CloseEverything();
-            return;
-        }
-
-        if (_readBuffer.size() < bodySize)
-            _readBuffer.resize(bodySize);
-
-        size_t bodyBytesRead = _pipe.Read(_readBuffer.data(), bodySize, true);
-        if (bodyBytesRead != bodySize)
-        {
-            LOG(INFO) << "Invalid body (bodyBytesRead = " << bodyBytesRead << ", bodySize = " << bodySize << "). Shutting down.";
-            CloseEverything();
-            return;
-        }
-
-        LOG(INFO) << "Received packet (packetType = " << (int)header.packetType << ", opcode = " << (int)header.opcode << ")";
-
-        if (header.packetType == PacketType::Response)
+        size_t frameSize = header.size + sizeof(uint32_t) - sizeof(IPCPacketHeader);
+        if (header.packetType == PacketType::Fragment)
         {
-            std::shared_ptr<IPCPendingRequest> pPendingRequest;
-
+            if (frameSize > kLaneFragmentSize || header.requestId >= kLaneCount)
             {
-                std::lock_guard<std::mutex> lk(_requestMapMutex);
-                pPendingRequest = _pendingRequests[header.requestId];
+                LOG(INFO) << "Invalid fragment (frameSize = " << frameSize << ", lane = " << header.requestId << "). Shutting down.";
+                CloseEverything();
+                return;
             }
 
+            InboundPacket& fragmented = fragmentedPackets[header.requestId];
+            if (!fragmented.active)
             {
-                std::unique_lock lk(pPendingRequest->mutex);
-                pPendingRequest->ready = true;
-                if (bodySize > 0)
+                // The first slice starts with the header of the fragmented packet.
+                IPCPacketHeader innerHeader;
+                if (frameSize < sizeof(IPCPacketHeader) || ReadTransport(&innerHeader, sizeof(IPCPacketHeader)) != sizeof(IPCPacketHeader) ||
+                    innerHeader.packetType == PacketType::Fragment || !BeginInboundPacket(innerHeader, fragmented))
                 {
-                    pPendingRequest->responseBody.resize(bodySize);
-                    memcpy(pPendingRequest->responseBody.data(), _readBuffer.data(), bodySize);
+                    LOG(INFO) << "Invalid first fragment. Shutting down.";
+                    CloseEverything();
+                    return;
                 }
+                frameSize -= sizeof(IPCPacketHeader);
             }
 
-            pPendingRequest->conditionVariable.notify_one();
-        }
-        else if (header.packetType == PacketType::Request)
-        {
-            std::shared_ptr<std::vector<uint8_t>> readBuffer = _ipcBufferPool.GetBuffer();
-            if (readBuffer->size() < bodySize)
+            if (frameSize > fragmented.bodySize - fragmented.received || !ReadInboundBody(fragmented, frameSize))
             {
-                LOG(WARNING) << "Skipped packet that is too large for IPC buffer pool.";
-                continue;
+                LOG(INFO) << "Invalid fragment (frameSize = " << frameSize << ", received = " << fragmented.received << ", bodySize = " << fragmented.bodySize
+                          << "). Shutting down.";
+                if (fragmented.readBuffer)
+                    _ipcBufferPool.ReturnBuffer(fragmented.readBuffer);
+                CloseEverything();
+                return;
             }
 
-            memcpy(readBuffer->data(), _readBuffer.data(), bodySize);
-
-            auto packetHandler = [this, header, bodySize, readBuffer]()
-            {
-                PacketReader reader(readBuffer->data(), bodySize);
-                PacketWriter writer;
-                bool should_write_response = HandleRequest(header.requestId, (OpcodeController)header.opcode, reader, writer);
-                _ipcBufferPool.ReturnBuffer(readBuffer);
-                if (!should_write_response)
-                {
-                    return;
-                }
-
-                WriteResponse(header.requestId, header.opcode, writer.data(), writer.size());
-            };
+            if (!(header.opcode & kFragmentLast))
+                continue;
 
-            OpcodeController opcode = (OpcodeController)header.opcode;
-            if ((opcode == OpcodeController::StreamOpen || opcode == OpcodeController::StreamData || opcode == OpcodeController::StreamClose) && bodySize >= sizeof(uint32_t))
-            {
-                uint32_t streamIdentifier;
-                memcpy(&streamIdentifier, readBuffer->data(), sizeof(uint32_t));
-                if (!QueueIncomingStreamWork(streamIdentifier, std::move(packetHandler)))
-                {
-                    _ipcBufferPool.ReturnBuffer(readBuffer);
-                }
-            }
-            else
-            {
-                if (!_threadPool.Enqueue(std::move(packetHandler)))
-                {
-                    _ipcBufferPool.ReturnBuffer(readBuffer);
-                }
-            }
-        }
-        else if (header.packetType == PacketType::Notification)
-        {
-            std::shared_ptr<std::vector<uint8_t>> readBuffer = _ipcBufferPool.GetBuffer();
-            if (readBuffer->size() < bodySize)
+            InboundPacket packet = std::move(fragmented);
+            fragmented = InboundPacket();
+            if (packet.received != packet.bodySize)
             {
-                LOG(WARNING) << "Skipped packet that is too large for IPC buffer pool.";
-                continue;
+                LOG(INFO) << "Fragmented packet ended early (received = " << packet.received << ", bodySize = " << packet.bodySize << "). Shutting down.";
+                if (packet.readBuffer)
+                    _ipcBufferPool.ReturnBuffer(packet.readBuffer);
+                CloseEverything();
+                return;
             }
 
-            memcpy(readBuffer->data(), _readBuffer.data(), bodySize);
+            if (!DispatchPacket(packet))
+                return;
+            continue;
+        }
 
-            if (!_threadPool.Enqueue(
-                    [this, header, bodySize, readBuffer]()
-                    {
-                        PacketReader reader(readBuffer->data(), bodySize);
-                        HandleNotification((OpcodeControllerNotification)header.opcode, reader);
-                        _ipcBufferPool.ReturnBuffer(readBuffer);
-                    }))
-            {
-                _ipcBufferPool.ReturnBuffer(readBuffer);
-            }
+        InboundPacket packet;
+        if (!BeginInboundPacket(header, packet))
+        {
+            CloseEverything();
+            return;
         }
-        else
+
+        if (!ReadInboundBody(packet, packet.bodySize))
         {
-            LOG(INFO) << "Unknown packet type.";
+            LOG(INFO) << "Invalid body (bodyBytesRead = " << packet.received << ", bodySize = " << packet.bodySize << "). Shutting down.";
+            if (packet.readBuffer)
+                _ipcBufferPool.ReturnBuffer(packet.readBuffer);
             CloseEverything();
             return;
         }
+
+        if (!DispatchPacket(packet))
+            return;
     }
 
     LOG(INFO) << "IPC stopped.";
 }
 
-bool IPC::QueueIncomingStreamWork(uint32_t identifier, std::function<void()> work)
+bool IPC::BeginInboundPacket(const IPCPacketHeader& header, InboundPacket& packet)
 {
-    if (!IsAvailable())
+    size_t bodySize = header.size + sizeof(uint32_t) - sizeof(IPCPacketHeader);
+    if (bodySize > _maxPacketSize)
     {
+        LOG(INFO) << "Invalid packet size (" << bodySize << " bytes). Shutting down.";
         return false;
     }
 
-    std::shared_ptr<IncomingStreamDispatcher> dispatcher;
+    // The header tells us where the body ends up, so it is read straight into its final owner: the
+    // pending request for responses, a pool buffer handed to the handler for requests and notifications.
+    packet.header = header;
+    packet.bodySize = bodySize;
+    packet.received = 0;
+    packet.active = true;
+    if (header.packetType == PacketType::Response)
     {
-        std::lock_guard<std::mutex> lk(_incomingStreamDispatchersMutex);
-        auto& existingDispatcher = _incomingStreamDispatchers[identifier];
-        if (!existingDispatcher)
-        {
-            existingDispatcher = std::make_shared<IncomingStreamDispatcher>();
-        }
+        packet.responseBody.resize(bodySize);
+        packet.destination = packet.responseBody.data();
+    }
+    else if (bodySize > 0)
+    {
+        packet.readBuffer = _ipcBufferPool.GetBuffer(bodySize);
+        packet.destination = packet.readBuffer ? packet.readBuffer->data() : nullptr;
+    }
+    return true;
+}
+
+bool IPC::ReadInboundBody(InboundPacket& packet, size_t size)
+{
+    if (size == 0)
+        return true;
 
-        dispatcher = existingDispatcher;
+    uint8_t* destination = packet.destination;
+    if (!destination)
+    {
+        if (_readBuffer.size() < size)
+            _readBuffer.resize(size);
+        destination = _readBuffer.data();
     }
+    else
+    {
+        destination += packet.received;
+    }
+
+    size_t bytesRead = ReadTransport(destination, size);
+    packet.received += bytesRead;
+    return bytesRead == size;
+}
+
+bool IPC::DispatchPacket(InboundPacket& packet)
+{
+    const IPCPacketHeader header = packet.header;
+    const size_t bodySize = packet.bodySize;
+    std::shared_ptr<std::vector<uint8_t>> readBuffer = std::move(packet.readBuffer);
+
+    LOG(INFO) << "Received packet (packetType = " << (int)header.packetType << ", opcode = " << (int)header.opcode << ")";
 
-    bool shouldSchedule = false;
+    if (header.packetType == PacketType::Notification && (OpcodeControllerNotification)header.opcode == OpcodeControllerNotification::TransportSwitch)
     {
-        std::lock_guard<std::mutex> lk(dispatcher->mutex);
-        dispatcher->queue.push(std::move(work));
-        if (!dispatcher->running)
+        if (readBuffer)
+            _ipcBufferPool.ReturnBuffer(readBuffer);
+
+        if (!_shmWriteActive)
         {
-            dispatcher->running = true;
-            shouldSchedule = true;
+            LOG(INFO) << "Received transport switch without a shared memory transport. Shutting down.";
+            CloseEverything();
+            return false;
         }
-    }
 
-    if (!shouldSchedule)
-    {
+        LOG(INFO) << "Switched IPC reads to the shared memory transport.";
+        _shmReadActive = true;
         return true;
     }
 
-    if (_threadPool.Enqueue(
-            [this, identifier, dispatcher]
-            {
-                ProcessIncomingStreamDispatcher(identifier, dispatcher);
-            }))
+    if (header.packetType != PacketType::Response && bodySize > 0 && !readBuffer)
     {
+        LOG(WARNING) << "Skipped packet that is too large for IPC buffer pool.";
         return true;
     }
 
+    if (header.packetType == PacketType::Response)
     {
-        std::lock_guard<std::mutex> lk(dispatcher->mutex);
-        if (!dispatcher->queue.empty())
+        std::optional<IPCPendingRequest> pendingRequest = _pendingRequests.Take(header.requestId);
+        if (!pendingRequest)
         {
-            dispatcher->queue.pop();
+            LOG(WARNING) << "Received response for unknown request " << header.requestId << ".";
+            return true;
         }
-        dispatcher->running = false;
-    }
 
-    std::lock_guard<std::mutex> dispatchersLock(_incomingStreamDispatchersMutex);
-    auto dispatcherItr = _incomingStreamDispatchers.find(identifier);
-    if (dispatcherItr != _incomingStreamDispatchers.end() && dispatcherItr->second == dispatcher)
+        CompletePendingRequest(std::move(*pendingRequest), std::move(packet.responseBody));
+    }
+    else if (header.packetType == PacketType::Request)
     {
-        std::lock_guard<std::mutex> dispatcherLock(dispatcher->mutex);
-        if (!dispatcher->running && dispatcher->queue.empty())
+        auto packetHandler = [this, header, bodySize, readBuffer]() mutable
         {
-            _incomingStreamDispatchers.erase(dispatcherItr);
-        }
-    }
+            PacketReader reader(readBuffer ? readBuffer->data() : nullptr, bodySize, readBuffer);
+            PacketWriter writer;
+            bool should_write_response = HandleRequest(header.requestId, (OpcodeController)header.opcode, reader, writer);
+            if (readBuffer)
+                _ipcBufferPool.ReturnBuffer(readBuffer);
+            if (!should_write_response)
+            {
+                return;
+            }
 
-    return false;
-}
+            WriteResponse(header.requestId, header.opcode, std::move(writer));
+        };
 
-void IPC::ProcessIncomingStreamDispatcher(uint32_t identifier, std::shared_ptr<IncomingStreamDispatcher> dispatcher)
-{
-    while (true)
-    {
-        std::function<void()> work;
+        OpcodeController opcode = (OpcodeController)header.opcode;
+        if ((opcode == OpcodeController::StreamOpen || opcode == OpcodeController::StreamData || opcode == OpcodeController::StreamEnd ||
+             opcode == OpcodeController::StreamClose) &&
+            bodySize >= sizeof(uint32_t))
         {
-            std::lock_guard<std::mutex> lk(dispatcher->mutex);
-            if (dispatcher->queue.empty())
+            uint32_t streamIdentifier;
+            memcpy(&streamIdentifier, readBuffer->data(), sizeof(uint32_t));
+            if (!QueueIncomingStreamWork(streamIdentifier, std::move(packetHandler)))
             {
-                dispatcher->running = false;
-                break;
+                _ipcBufferPool.ReturnBuffer(readBuffer);
+            }
+        }
+        else
+        {
+            if (!_threadPool.Enqueue(std::move(packetHandler)) && readBuffer)
+            {
+                _ipcBufferPool.ReturnBuffer(readBuffer);
             }
-
-            work = std::move(dispatcher->queue.front());
-            dispatcher->queue.pop();
         }
-
-        work();
     }
-
-    std::lock_guard<std::mutex> dispatchersLock(_incomingStreamDispatchersMutex);
-    auto dispatcherItr = _incomingStreamDispatchers.find(identifier);
-    if (dispatcherItr != _incomingStreamDispatchers.end() && dispatcherItr->second == dispatcher)
+    else if (header.packetType == PacketType::Notification)
     {
-        std::lock_guard<std::mutex> dispatcherLock(dispatcher->mutex);
-        if (!dispatcher->running && dispatcher->queue.empty())
+        auto packetHandler = [this, header, bodySize, readBuffer]() mutable
+        {
+            PacketReader reader(readBuffer ? readBuffer->data() : nullptr, bodySize, readBuffer);
+            HandleNotification((OpcodeControllerNotification)header.opcode, reader);
+            if (readBuffer)
+                _ipcBufferPool.ReturnBuffer(readBuffer);
+        };
+
+        // Stream data shares the per-stream queue with StreamOpen/StreamEnd/StreamClose so it lands in order.
+        if ((OpcodeControllerNotification)header.opcode == OpcodeControllerNotification::StreamData && bodySize >= sizeof(uint32_t))
         {
-            _incomingStreamDispatchers.erase(dispatcherItr);
+            uint32_t streamIdentifier;
+            memcpy(&streamIdentifier, readBuffer->data(), sizeof(uint32_t));
+            if (!QueueIncomingStreamWork(streamIdentifier, std::move(packetHandler)))
+            {
+                _ipcBufferPool.ReturnBuffer(readBuffer);
+            }
+        }
+        else if (!_threadPool.Enqueue(std::move(packetHandler)) && readBuffer)
+        {
+            _ipcBufferPool.ReturnBuffer(readBuffer);
         }
     }
+    else
+    {
+        LOG(INFO) << "Unknown packet type.";
+        CloseEverything();
+        return false;
+    }
+
+    return true;
+}
+
+bool IPC::QueueIncomingStreamWork(uint32_t identifier, std::function<void()> work)
+{
+    if (!IsAvailable())
+    {
+        return false;
+    }
+
+    return _incomingStreamExecutors.Post(identifier, std::move(work));
+}
+
+std::vector<uint8_t> IPC::Call(OpcodeClient opcode, const uint8_t* body, size_t size)
+{
+    IOSegment bodySegment = {body, body ? size : 0};
+    return Call(opcode, &bodySegment, 1);
 }
 
-std::vector<uint8_t> IPC::Call(OpcodeClient opcode, const uint8_t* body, size_t size, std::function<void()> afterWrite)
+std::vector<uint8_t> IPC::Call(OpcodeClient opcode, const IOSegment* bodySegments, size_t bodySegmentCount)
 {
     if (!IsAvailable())
         return std::vector<uint8_t>();
@@ -515,215 +656,480 @@ std::vector<uint8_t> IPC::Call(OpcodeClient opcode, const uint8_t* body, size_t
         LOG(ERROR) << "!!!!!!WARNING!!!!!! Do not make remote calls on UI thread !!!!!!WARNING!!!!!!";
     }
 
-    uint32_t requestId = ++_requestIdCounter;
-    std::shared_ptr<IPCPendingRequest> pPendingRequest = std::make_shared<IPCPendingRequest>();
-    pPendingRequest->requestId = requestId;
-    pPendingRequest->ready = false;
-    pPendingRequest->opcode = opcode;
+    // The body is borrowed, onComplete only runs after the writer thread has flushed or dropped the packet.
+    std::shared_ptr<std::promise<std::vector<uint8_t>>> promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    std::future<std::vector<uint8_t>> future = promise->get_future();
+    CallAsync(opcode, bodySegments, bodySegmentCount, nullptr,
+              [promise](std::optional<std::vector<uint8_t>> response)
+              {
+                  promise->set_value(response ? std::move(*response) : std::vector<uint8_t>());
+              });
 
+    std::vector<uint8_t> response;
     {
-        std::lock_guard<std::mutex> lk(_requestMapMutex);
-        _pendingRequests[requestId] = pPendingRequest;
+        ThreadPool::BlockingScope blocking(_threadPool);
+        response = future.get();
     }
+    LOG(INFO) << "Got response";
+    return response;
+}
 
-    {
-        std::lock_guard<std::mutex> lk(_writeMutex);
-
-        size_t packetLength = sizeof(IPCPacketHeader) + size;
-        if (_sendBuffer.size() < packetLength)
-            _sendBuffer.resize(packetLength);
+void IPC::CallAsync(OpcodeClient opcode, PacketWriter writer, IPCCallCallback onComplete, std::function<void()> afterWrite)
+{
+    OutboundPacket packet;
+    packet.storage = writer.release();
+    packet.afterWrite = std::move(afterWrite);
+    CallAsync(opcode, std::move(packet), std::move(onComplete));
+}
 
-        IPCPacketHeader* pHeader = (IPCPacketHeader*)_sendBuffer.data();
-        pHeader->size = (uint32_t)(packetLength - sizeof(uint32_t));
-        pHeader->opcode = (uint8_t)opcode;
-        pHeader->packetType = PacketType::Request;
-        pHeader->requestId = requestId;
+void IPC::CallAsync(OpcodeClient opcode, const IOSegment* bodySegments, size_t bodySegmentCount, std::shared_ptr<const void> keepAlive, IPCCallCallback onComplete,
+                    std::function<void()> afterWrite)
+{
+    OutboundPacket packet;
+    packet.body.reserve(bodySegmentCount);
+    for (size_t i = 0; i < bodySegmentCount; i++)
+    {
+        if (bodySegments[i].size == 0)
+            continue;
 
-        LOG(INFO) << "Sent request (packetType = " << (int)pHeader->packetType << ", opcode = " << (int)pHeader->opcode << "), waiting for response";
+        packet.body.push_back(bodySegments[i]);
+    }
 
-        if (body && size > 0)
-            memcpy(_sendBuffer.data() + sizeof(IPCPacketHeader), body, size);
+    packet.keepAlive = std::move(keepAlive);
+    packet.afterWrite = std::move(afterWrite);
+    CallAsync(opcode, std::move(packet), std::move(onComplete));
+}
 
-        _pipe.Write(_sendBuffer.data(), packetLength, true);
-    }
+void IPC::CallAsync(OpcodeClient opcode, OutboundPacket packet, IPCCallCallback onComplete)
+{
+    IPCPendingRequest pendingRequest;
+    pendingRequest.opcode = opcode;
+    pendingRequest.onComplete = std::move(onComplete);
 
-    if (afterWrite)
+    if (!IsAvailable())
     {
-        afterWrite();
+        CompletePendingRequest(std::move(pendingRequest), std::nullopt);
+        return;
     }
 
+    std::optional<uint32_t> requestId = _pendingRequests.Insert(std::move(pendingRequest));
+    if (!requestId)
     {
-        std::unique_lock lk(pPendingRequest->mutex);
-        pPendingRequest->conditionVariable.wait(lk,
-                                                [pPendingRequest]
-                                                {
-                                                    return pPendingRequest->ready;
-                                                });
+        LOG(ERROR) << "Too many requests in flight (" << _pendingRequests.InFlight() << "), dropping request (opcode = " << (int)opcode << ").";
+        CompletePendingRequest(std::move(pendingRequest), std::nullopt);
+        return;
     }
 
-    LOG(INFO) << "Got response";
+    size_t bodySize = packet.storage.size();
+    for (const IOSegment& segment : packet.body)
+        bodySize += segment.size;
 
+    packet.header = MakePacketHeader(PacketType::Request, (uint8_t)opcode, *requestId, bodySize);
+    packet.onAbort = [this, requestId = *requestId]()
     {
-        std::lock_guard<std::mutex> lk(_requestMapMutex);
-        _pendingRequests.erase(requestId);
-    }
+        std::optional<IPCPendingRequest> pendingRequest = _pendingRequests.Take(requestId);
+        if (pendingRequest)
+            CompletePendingRequest(std::move(*pendingRequest), std::nullopt);
+    };
 
-    return pPendingRequest->responseBody;
+    LOG(INFO) << "Sent request (packetType = " << (int)packet.header.packetType << ", opcode = " << (int)packet.header.opcode << ")";
+    EnqueuePacket(std::move(packet));
 }
 
-void IPC::Notify(OpcodeClientNotification opcode, const PacketWriter& writer, std::function<void()> afterWrite, std::function<void()> onAbort)
+void IPC::CompletePendingRequest(IPCPendingRequest pendingRequest, std::optional<std::vector<uint8_t>> response)
 {
-    Notify(opcode, writer.data(), writer.size(), std::move(afterWrite), std::move(onAbort));
-}
+    if (!pendingRequest.onComplete)
+        return;
 
-void IPC::Notify(OpcodeClientNotification opcode, const uint8_t* body, size_t size, std::function<void()> afterWrite, std::function<void()> onAbort)
-{
-    if (!IsAvailable())
+    // Completions may parse large responses or start follow-up calls, keep them off the reader and writer threads.
+    auto completionState = std::make_shared<std::pair<IPCCallCallback, std::optional<std::vector<uint8_t>>>>(std::move(pendingRequest.onComplete), std::move(response));
+    std::function<void()> completion = [completionState]()
     {
-        if (onAbort)
-        {
-            onAbort();
-        }
-        return;
-    }
+        completionState->first(std::move(completionState->second));
+    };
 
+    if (!_threadPool.Enqueue(completion))
+        completion();
+}
+
+void IPC::Notify(OpcodeClientNotification opcode, PacketWriter writer, std::function<void()> afterWrite, std::function<void()> onAbort)
+{
     if (CefCurrentlyOn(TID_UI))
     {
         LOG(ERROR) << "!!!!!!WARNING!!!!!! Do not make remote calls on UI thread !!!!!!WARNING!!!!!!";
     }
 
-    std::lock_guard<std::mutex> lk(_writeMutex);
-
-    size_t packetLength = sizeof(IPCPacketHeader) + size;
-    if (_sendBuffer.size() < packetLength)
-        _sendBuffer.resize(packetLength);
+    OutboundPacket packet;
+    packet.storage = writer.release();
+    packet.header = MakePacketHeader(PacketType::Notification, (uint8_t)opcode, 0, packet.storage.size());
+    packet.afterWrite = std::move(afterWrite);
+    packet.onAbort = std::move(onAbort);
 
-    IPCPacketHeader* pHeader = (IPCPacketHeader*)_sendBuffer.data();
-    pHeader->size = (uint32_t)(packetLength - sizeof(uint32_t));
-    pHeader->opcode = (uint8_t)opcode;
-    pHeader->packetType = PacketType::Notification;
-    pHeader->requestId = 0;
-
-    LOG(INFO) << "Sent notification (packetType = " << (int)pHeader->packetType << ", opcode = " << (int)pHeader->opcode << ")";
+    LOG(INFO) << "Sent notification (packetType = " << (int)packet.header.packetType << ", opcode = " << (int)packet.header.opcode << ")";
+    EnqueuePacket(std::move(packet));
+}
 
+void IPC::Notify(OpcodeClientNotification opcode, const uint8_t* body, size_t size, std::function<void()> afterWrite, std::function<void()> onAbort)
+{
+    PacketWriter writer;
     if (body && size > 0)
-        memcpy(_sendBuffer.data() + sizeof(IPCPacketHeader), body, size);
+        writer.writeBytes(body, size);
 
-    if (_pipe.Write(_sendBuffer.data(), packetLength, true) != packetLength)
-    {
-        if (onAbort)
-        {
-            onAbort();
-        }
-        LOG(INFO) << "Failed to write entire notification packet.";
-        CloseEverything();
-        return;
-    }
+    Notify(opcode, std::move(writer), std::move(afterWrite), std::move(onAbort));
+}
 
-    if (afterWrite)
+void IPC::Notify(OpcodeClientNotification opcode, const IOSegment* bodySegments, size_t bodySegmentCount, std::shared_ptr<const void> keepAlive)
+{
+    OutboundPacket packet;
+    packet.body.reserve(bodySegmentCount);
+    size_t bodySize = 0;
+    for (size_t i = 0; i < bodySegmentCount; i++)
     {
-        afterWrite();
+        if (bodySegments[i].size == 0)
+            continue;
+
+        packet.body.push_back(bodySegments[i]);
+        bodySize += bodySegments[i].size;
     }
+
+    packet.header = MakePacketHeader(PacketType::Notification, (uint8_t)opcode, 0, bodySize);
+    packet.keepAlive = std::move(keepAlive);
+
+    LOG(INFO) << "Sent notification (packetType = " << (int)packet.header.packetType << ", opcode = " << (int)packet.header.opcode << ")";
+    EnqueuePacket(std::move(packet));
 }
 
-void IPC::QueueResponse(OpcodeController opcode, uint32_t requestId, const PacketWriter& writer, std::function<void()> afterWrite, std::function<void()> onAbort)
+void IPC::QueueResponse(OpcodeController opcode, uint32_t requestId, PacketWriter writer, std::function<void()> afterWrite, std::function<void()> onAbort)
 {
-    if (!IsAvailable())
-    {
-        if (onAbort)
-        {
-            onAbort();
-        }
-        return;
-    }
+    OutboundPacket packet;
+    packet.storage = writer.release();
+    packet.header = MakePacketHeader(PacketType::Response, (uint8_t)opcode, requestId, packet.storage.size());
+    packet.afterWrite = std::move(afterWrite);
+    packet.onAbort = std::move(onAbort);
+
+    LOG(INFO) << "Sent queued response (packetType = " << (int)packet.header.packetType << ", opcode = " << (int)packet.header.opcode << ")";
+    EnqueuePacket(std::move(packet));
+}
 
-    size_t packetLength = sizeof(IPCPacketHeader) + writer.size();
-    std::shared_ptr<std::vector<uint8_t>> packet = _ipcBufferPool.GetBuffer();
-    if (packet->size() < packetLength)
+void IPC::WriteResponse(uint32_t requestId, uint8_t opcode, const IOSegment* bodySegments, size_t bodySegmentCount, std::shared_ptr<const void> keepAlive)
+{
+    OutboundPacket packet;
+    packet.body.reserve(bodySegmentCount);
+    size_t bodySize = 0;
+    for (size_t i = 0; i < bodySegmentCount; i++)
     {
-        LOG(ERROR) << "Queued response packet exceeds buffer pool capacity.";
-        _ipcBufferPool.ReturnBuffer(packet);
-        if (onAbort)
-        {
-            onAbort();
-        }
-        return;
+        if (bodySegments[i].size == 0)
+            continue;
+
+        packet.body.push_back(bodySegments[i]);
+        bodySize += bodySegments[i].size;
     }
 
-    IPCPacketHeader* pHeader = reinterpret_cast<IPCPacketHeader*>(packet->data());
-    pHeader->size = static_cast<uint32_t>(packetLength - sizeof(uint32_t));
-    pHeader->opcode = static_cast<uint8_t>(opcode);
-    pHeader->packetType = PacketType::Response;
-    pHeader->requestId = requestId;
+    packet.header = MakePacketHeader(PacketType::Response, opcode, requestId, bodySize);
+    packet.keepAlive = std::move(keepAlive);
 
-    if (writer.size() > 0)
-    {
-        memcpy(packet->data() + sizeof(IPCPacketHeader), writer.data(), writer.size());
+    LOG(INFO) << "Sent response (packetType = " << (int)packet.header.packetType << ", opcode = " << (int)packet.header.opcode << ")";
+    EnqueuePacket(std::move(packet));
+}
+
+void IPC::WriteResponse(uint32_t requestId, uint8_t opcode, PacketWriter writer)
+{
+    OutboundPacket packet;
+    packet.storage = writer.release();
+    packet.header = MakePacketHeader(PacketType::Response, opcode, requestId, packet.storage.size());
+
+    LOG(INFO) << "Sent response (packetType = " << (int)packet.header.packetType << ", opcode = " << (int)packet.header.opcode << ")";
+    EnqueuePacket(std::move(packet));
+}
+
+IPC::Lane IPC::LaneFor(const IPCPacketHeader& header)
+{
+    if (header.packetType == PacketType::Request)
+    {
+        OpcodeClient opcode = (OpcodeClient)header.opcode;
+        if (opcode == OpcodeClient::StreamOpen || opcode == OpcodeClient::StreamData || opcode == OpcodeClient::StreamEnd || opcode == OpcodeClient::StreamClose)
+            return Lane::Bulk;
+    }
+    else if (header.packetType == PacketType::Notification && (OpcodeClientNotification)header.opcode == OpcodeClientNotification::StreamData)
+    {
+        return Lane::Bulk;
     }
 
-    if (!QueueBackgroundWork(
-            [this, packet, packetLength, afterWrite = std::move(afterWrite)]() mutable
-            {
-                WriteQueuedResponsePacket(packet->data(), packetLength);
-                if (afterWrite)
-                {
-                    afterWrite();
-                }
-                _ipcBufferPool.ReturnBuffer(packet);
-            }))
+    return Lane::Control;
+}
+
+OutboundClass IPC::ClassFor(const OutboundPacket& packet, uint32_t& streamId)
+{
+    streamId = 0;
+    const IPCPacketHeader& header = packet.header;
+    if (header.packetType == PacketType::Response)
+        return OutboundClass::Response;
+
+    bool stream = false;
+    if (header.packetType == PacketType::Request)
     {
-        _ipcBufferPool.ReturnBuffer(packet);
-        if (onAbort)
+        OpcodeClient opcode = (OpcodeClient)header.opcode;
+        stream = opcode == OpcodeClient::StreamOpen || opcode == OpcodeClient::StreamData || opcode == OpcodeClient::StreamEnd || opcode == OpcodeClient::StreamClose;
+    }
+    else if (header.packetType == PacketType::Notification)
+    {
+        stream = (OpcodeClientNotification)header.opcode == OpcodeClientNotification::StreamData;
+    }
+    if (!stream)
+        return OutboundClass::Control;
+
+    // Every stream packet starts with the uint32 stream id, in the owned storage or the first borrowed segment.
+    if (packet.storage.size() >= sizeof(uint32_t))
+        memcpy(&streamId, packet.storage.data(), sizeof(uint32_t));
+    else if (packet.storage.empty() && !packet.body.empty() && packet.body.front().size >= sizeof(uint32_t))
+        memcpy(&streamId, packet.body.front().data, sizeof(uint32_t));
+    return OutboundClass::Stream;
+}
+
+void IPC::EnqueuePacket(OutboundPacket packet)
+{
+    uint32_t streamId;
+    const OutboundClass outboundClass = ClassFor(packet, streamId);
+    const size_t bytes = packet.header.size + sizeof(uint32_t);
+    {
+        std::lock_guard<std::mutex> lk(_outboundMutex);
+        if (IsAvailable() && !_writerStopping)
         {
-            onAbort();
+            OutboundLane& lane = _outboundLanes[(size_t)LaneFor(packet.header)];
+            lane.queue.Push(outboundClass, streamId, bytes, std::move(packet));
+            lane.condition.notify_one();
+            return;
         }
     }
+
+    if (packet.onAbort)
+    {
+        packet.onAbort();
+    }
 }
 
-void IPC::WriteResponse(uint32_t requestId, uint8_t opcode, const uint8_t* body, size_t size)
+size_t IPC::AppendPacketSegments(const OutboundPacket& packet, std::vector<IOSegment>& segments)
 {
-    if (!IsAvailable())
+    size_t totalBytes = sizeof(IPCPacketHeader);
+    segments.push_back({&packet.header, sizeof(IPCPacketHeader)});
+    if (!packet.storage.empty())
+    {
+        segments.push_back({packet.storage.data(), packet.storage.size()});
+        totalBytes += packet.storage.size();
+    }
+    for (const IOSegment& segment : packet.body)
+    {
+        segments.push_back(segment);
+        totalBytes += segment.size;
+    }
+    return totalBytes;
+}
+
+void IPC::AbortOutbound(std::vector<OutboundPacket>& batch)
+{
+    for (auto& packet : batch)
+        PostPacketCallback(std::move(packet.onAbort));
+    batch.clear();
+}
+
+void IPC::PostPacketCallback(std::function<void()> callback)
+{
+    if (!callback)
         return;
 
-    std::lock_guard<std::mutex> lk(_writeMutex);
+    // Callbacks may block or start follow-up calls, a writer thread must never wait on them.
+    if (!_threadPool.Enqueue(callback))
+        callback();
+}
 
-    size_t packetLength = sizeof(IPCPacketHeader) + size;
-    if (_sendBuffer.size() < packetLength)
-        _sendBuffer.resize(packetLength);
+void IPC::RunWriter(Lane lane)
+{
+    const char* laneName = lane == Lane::Bulk ? "bulk" : "control";
+    LOG(INFO) << "IPC " << laneName << " writer running.";
+
+    OutboundLane& outbound = _outboundLanes[(size_t)lane];
+    // A bulk batch is bounded by one fragment, so the control writer never waits longer than for one slice. Controllers
+    // that cannot reassemble fragments get large packets whole.
+    const size_t maxBatchBytes = lane == Lane::Bulk ? kLaneFragmentSize : kMaxCoalescedBytes;
+    std::vector<OutboundPacket> batch;
+    std::vector<IOSegment> segments;
+    while (true)
+    {
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lk(_outboundMutex);
+            outbound.condition.wait(lk,
+                                    [this, &outbound]
+                                    {
+                                        return !outbound.queue.Empty() || _writerStopping;
+                                    });
+
+            stopping = _writerStopping;
+            if (stopping)
+            {
+                batch = outbound.queue.TakeAll();
+            }
+            else
+            {
+                // Coalesce whatever is queued into one gathered write, in scheduler order. Large packets still go
+                // out alone so the batch never holds more than one big body.
+                size_t batchBytes = 0;
+                while (!outbound.queue.Empty() && batch.size() < kMaxCoalescedPackets)
+                {
+                    size_t packetBytes = outbound.queue.Front().header.size + sizeof(uint32_t);
+                    if (!batch.empty() && batchBytes + packetBytes > maxBatchBytes)
+                        break;
 
-    IPCPacketHeader* pHeader = (IPCPacketHeader*)_sendBuffer.data();
-    pHeader->size = (uint32_t)(packetLength - sizeof(uint32_t));
-    pHeader->opcode = opcode;
-    pHeader->packetType = PacketType::Response;
-    pHeader->requestId = requestId;
+                    batchBytes += packetBytes;
+                    batch.push_back(outbound.queue.Pop());
+                }
+            }
+        }
 
-    LOG(INFO) << "Sent response (packetType = " << (int)pHeader->packetType << ", opcode = " << (int)pHeader->opcode << ")";
+        if (stopping)
+        {
+            AbortOutbound(batch);
+            break;
+        }
 
-    if (body && size > 0)
-        memcpy(_sendBuffer.data() + sizeof(IPCPacketHeader), body, size);
+        bool written;
+        if (batch.size() == 1 && batch.front().header.size + sizeof(uint32_t) > kLaneFragmentSize && HasControllerCapability(kControllerCapabilityFragments))
+        {
+            written = WriteFragmented(lane, batch.front(), segments);
+        }
+        else
+        {
+            size_t totalBytes = 0;
+            segments.clear();
+            for (auto& packet : batch)
+                totalBytes += AppendPacketSegments(packet, segments);
+
+            AcquireTransport(lane);
+            written = WriteTransportV(segments.data(), segments.size()) == totalBytes;
+            ReleaseTransport();
+        }
 
-    if (_pipe.Write(_sendBuffer.data(), packetLength, true) != packetLength)
-    {
-        LOG(INFO) << "Failed to write entire response packet.";
-        CloseEverything();
+        if (!written)
+        {
+            LOG(INFO) << "Failed to write entire packet batch on the " << laneName << " lane.";
+            {
+                std::lock_guard<std::mutex> lk(_outboundMutex);
+                _writerStopping = true;
+                for (OutboundLane& other : _outboundLanes)
+                {
+                    for (auto& packet : other.queue.TakeAll())
+                        batch.push_back(std::move(packet));
+                    other.condition.notify_one();
+                }
+            }
+
+            AbortOutbound(batch);
+            CloseEverything();
+            break;
+        }
+
+        // Only the flush bookkeeping runs on the writer, see PostPacketCallback.
+        for (auto& packet : batch)
+        {
+            if (packet.header.packetType == PacketType::Request && _pendingRequests.MarkFlushed(packet.header.requestId) && _stopped)
+            {
+                // Stop may have swept the table before this request was marked flushed, nothing else would take it.
+                std::optional<IPCPendingRequest> pendingRequest = _pendingRequests.Take(packet.header.requestId);
+                if (pendingRequest)
+                    CompletePendingRequest(std::move(*pendingRequest), std::nullopt);
+            }
+            PostPacketCallback(std::move(packet.afterWrite));
+        }
+        batch.clear();
     }
+
+    LOG(INFO) << "IPC " << laneName << " writer stopped.";
 }
 
-void IPC::WriteQueuedResponsePacket(const uint8_t* packet, size_t packetLength)
+bool IPC::WriteFragmented(Lane lane, const OutboundPacket& packet, std::vector<IOSegment>& segments)
 {
-    if (!IsAvailable())
-        return;
+    std::vector<IOSegment> packetSegments;
+    const size_t totalBytes = AppendPacketSegments(packet, packetSegments);
 
-    std::lock_guard<std::mutex> lk(_writeMutex);
+    size_t index = 0;
+    size_t offset = 0;
+    size_t written = 0;
+    while (written < totalBytes)
+    {
+        const size_t length = std::min(kLaneFragmentSize, totalBytes - written);
+        const IPCPacketHeader frame = MakePacketHeader(PacketType::Fragment, written + length == totalBytes ? kFragmentLast : 0, (uint32_t)lane, length);
+
+        segments.clear();
+        segments.push_back({&frame, sizeof(IPCPacketHeader)});
+        for (size_t remaining = length; remaining > 0;)
+        {
+            const IOSegment& segment = packetSegments[index];
+            const size_t take = std::min(segment.size - offset, remaining);
+            segments.push_back({static_cast<const uint8_t*>(segment.data) + offset, take});
+            remaining -= take;
+            offset += take;
+            if (offset == segment.size)
+            {
+                index++;
+                offset = 0;
+            }
+        }
 
-    const IPCPacketHeader* pHeader = reinterpret_cast<const IPCPacketHeader*>(packet);
-    LOG(INFO) << "Sent queued response (packetType = " << static_cast<int>(pHeader->packetType) << ", opcode = " << static_cast<int>(pHeader->opcode) << ")";
+        // The transport is released between slices, the other lane's packets go out in between.
+        AcquireTransport(lane);
+        const bool sliceWritten = WriteTransportV(segments.data(), segments.size()) == sizeof(IPCPacketHeader) + length;
+        ReleaseTransport();
+        if (!sliceWritten)
+            return false;
+        written += length;
+    }
+    return true;
+}
 
-    if (_pipe.Write(packet, packetLength, true) != packetLength)
+void IPC::AcquireTransport(Lane lane)
+{
+    std::unique_lock<std::mutex> lk(_transportMutex);
+    if (lane == Lane::Control)
     {
-        LOG(INFO) << "Failed to write entire queued response packet.";
-        CloseEverything();
+        _transportControlWaiters++;
+        _transportCondition.wait(lk,
+                                 [this]
+                                 {
+                                     return !_transportBusy;
+                                 });
+        _transportControlWaiters--;
+    }
+    else
+    {
+        _transportCondition.wait(lk,
+                                 [this]
+                                 {
+                                     return !_transportBusy && _transportControlWaiters == 0;
+                                 });
+    }
+    _transportBusy = true;
+}
+
+void IPC::ReleaseTransport()
+{
+    {
+        std::lock_guard<std::mutex> lk(_transportMutex);
+        _transportBusy = false;
+    }
+    _transportCondition.notify_all();
+}
+
+IPC::OutboundStats IPC::OutboundQueueStats()
+{
+    OutboundStats stats;
+    std::lock_guard<std::mutex> lk(_outboundMutex);
+    for (OutboundLane& lane : _outboundLanes)
+    {
+        for (size_t i = 0; i < kOutboundClassCount; i++)
+            stats.pendingBytes[i] += lane.queue.PendingBytes((OutboundClass)i);
+        stats.pendingPackets += lane.queue.Size();
     }
+    return stats;
 }
 
 std::shared_ptr<DataStream> IPC::FindIncomingStream(uint32_t identifier)
@@ -733,16 +1139,36 @@ std::shared_ptr<DataStream> IPC::FindIncomingStream(uint32_t identifier)
     return itr != _dataStreams.end() ? itr->second : nullptr;
 }
 
-std::shared_ptr<DataStream> IPC::GetOrCreateIncomingStream(uint32_t identifier)
+std::shared_ptr<DataStream> IPC::GetOrCreateIncomingStream(uint32_t identifier, DataStreamKind kind)
 {
+    // The controller may have a full credit window in flight, the buffer limit must always cover it.
+    size_t maxCapacity = std::max(DataStream::KindMaxCapacity(kind), kStreamInitialCredit);
+
     std::lock_guard<std::mutex> lk(_dataStreamsMutex);
     auto itr = _dataStreams.find(identifier);
     if (itr != _dataStreams.end())
     {
+        // StreamOpen may have created it before the consumer knew what it carries.
+        if (kind != DataStreamKind::Generic)
+            itr->second->SetMaxCapacity(maxCapacity);
         return itr->second;
     }
 
-    std::shared_ptr<DataStream> stream = std::make_shared<DataStream>(identifier);
+    std::shared_ptr<DataStream> stream = std::make_shared<DataStream>(identifier, maxCapacity);
+
+    // Whatever the reader consumed is free space again, hand it back to the controller as credit in batches. A
+    // controller sending StreamData requests is paced by their replies instead.
+    if (HasControllerCapability(kControllerCapabilityStreamCredit))
+    {
+        std::shared_ptr<IncomingStreamCredit> credit = std::make_shared<IncomingStreamCredit>();
+        credit->identifier = identifier;
+        stream->SetConsumeListener(
+            [this, credit](size_t consumed, size_t buffered)
+            {
+                ReturnStreamCredit(credit, consumed, buffered == 0);
+            });
+    }
+
     _dataStreams[identifier] = stream;
     return stream;
 }
@@ -765,11 +1191,11 @@ void IPC::ResumePendingStreamReply(uint32_t streamId)
         status = static_cast<uint8_t>(StreamDataStatus::Closed);
     else
     {
-        const size_t remaining = pending.buf.size() - pending.written;
+        const size_t remaining = pending.size - pending.written;
         if (remaining > 0)
-            pending.written += dataStream->TryWrite(pending.buf.data() + pending.written, remaining);
+            pending.written += dataStream->TryAdopt(pending.owner, pending.data + pending.written, remaining);
 
-        if (pending.written == pending.buf.size())
+        if (pending.written == pending.size)
             status = static_cast<uint8_t>(StreamDataStatus::Accepted);
         else if (dataStream->State() != StreamState::Active)
             status = static_cast<uint8_t>(StreamDataStatus::Canceled);
@@ -784,7 +1210,9 @@ void IPC::ResumePendingStreamReply(uint32_t streamId)
         }
     }
 
-    WriteResponse(pending.requestId, pending.opcode, &status, sizeof(status));
+    std::shared_ptr<const uint8_t> body = std::make_shared<const uint8_t>(status);
+    const IOSegment segment = {body.get(), sizeof(uint8_t)};
+    WriteResponse(pending.requestId, pending.opcode, &segment, 1, std::move(body));
 }
 
 void IPC::QueueDeferredStreamWriters(std::vector<std::function<void()>> streamWriters)
@@ -819,6 +1247,14 @@ bool IPC::HandleRequest(uint32_t requestId, OpcodeController opcode, PacketReade
             },
             reader.remainingSize());
         return true;
+    case OpcodeController::GetStreamMemoryStats:
+    {
+        StreamMemoryBudget::Stats stats = StreamMemoryStats();
+        writer.write<uint64_t>(stats.limit);
+        writer.write<uint64_t>(stats.current);
+        writer.write<uint64_t>(stats.peak);
+        return true;
+    }
     case OpcodeController::WindowCreate:
         HandleWindowCreate(reader, writer);
         return true;
@@ -924,17 +1360,19 @@ bool IPC::HandleRequest(uint32_t requestId, OpcodeController opcode, PacketReade
                 return true;
             }
 
-            std::vector<uint8_t> chunk;
+            // The stream adopts the received packet buffer, the part that does not fit keeps a reference to it.
+            const size_t chunkSize = reader.remainingSize();
+            PendingStreamReply pending{requestId, static_cast<uint8_t>(opcode), reader.owner(), nullptr, chunkSize, 0, *identifier};
             reader.copyTo(
-                [&chunk](const uint8_t* data, size_t size)
+                [&](const uint8_t* data, size_t size)
                 {
-                    chunk.assign(data, data + size);
+                    pending.data = data;
+                    pending.written = dataStream->TryAdopt(pending.owner, data, size);
                     return true;
                 },
-                reader.remainingSize());
+                chunkSize);
 
-            const size_t written = dataStream->TryWrite(chunk.data(), chunk.size());
-            if (written == chunk.size())
+            if (pending.written == chunkSize)
             {
                 writer.write<uint8_t>(static_cast<uint8_t>(StreamDataStatus::Accepted));
                 return true;
@@ -945,11 +1383,21 @@ bool IPC::HandleRequest(uint32_t requestId, OpcodeController opcode, PacketReade
                 return true;
             }
 
+            // Without a pooled buffer the packet sits in the shared read buffer, which is reused for the next one.
+            if (!pending.owner)
+            {
+                auto rest = std::make_shared<std::vector<uint8_t>>(pending.data + pending.written, pending.data + chunkSize);
+                _receivedBytesCopied += rest->size();
+                pending.data = rest->data();
+                pending.size = rest->size();
+                pending.written = 0;
+                pending.owner = std::move(rest);
+            }
+
             const uint32_t streamId = *identifier;
             {
                 std::lock_guard<std::mutex> lk(_pendingStreamRepliesMutex);
-                _pendingStreamReplies[streamId] =
-                    PendingStreamReply{requestId, static_cast<uint8_t>(opcode), std::move(chunk), written, streamId};
+                _pendingStreamReplies[streamId] = std::move(pending);
             }
             dataStream->RegisterSpaceWakeup([this, streamId]() { ResumePendingStreamReply(streamId); });
             return false;
@@ -999,6 +1447,9 @@ bool IPC::HandleRequest(uint32_t requestId, OpcodeController opcode, PacketReade
             std::shared_ptr<std::atomic<bool>> cancelFlag = GetOutgoingStreamCancelFlag(*identifier);
             if (cancelFlag)
                 cancelFlag->store(true);
+
+            // An upload waiting for credit would otherwise never notice.
+            HandleStreamCredit(*identifier, 0, StreamDataStatus::Canceled);
         }
         return true;
     }
@@ -1031,6 +1482,30 @@ bool IPC::HandleRequest(uint32_t requestId, OpcodeController opcode, PacketReade
     case OpcodeController::WindowRemoveDomainToProxy:
         HandleRemoveDomainToProxy(reader, writer);
         return true;
+    case OpcodeController::WindowSetProxyCache:
+        HandleWindowSetProxyCache(reader, writer);
+        return true;
+    case OpcodeController::WindowPurgeProxyCache:
+        HandleWindowPurgeProxyCache(reader, writer);
+        return true;
+    case OpcodeController::WindowGetProxyCacheStats:
+        HandleWindowGetProxyCacheStats(reader, writer);
+        return true;
+    case OpcodeController::WindowMount:
+        HandleWindowMount(reader, writer);
+        return true;
+    case OpcodeController::WindowUnmount:
+        HandleWindowUnmount(reader, writer);
+        return true;
+    case OpcodeController::WindowAddUrlPatternToProxy:
+        HandleAddUrlPatternToProxy(reader, writer);
+        return true;
+    case OpcodeController::WindowRemoveUrlPatternToProxy:
+        HandleRemoveUrlPatternToProxy(reader, writer);
+        return true;
+    case OpcodeController::WindowSetRequestRewriteRules:
+        HandleWindowSetRequestRewriteRules(reader, writer);
+        return true;
     case OpcodeController::WindowAddUrlToModify:
         HandleAddUrlToModify(reader, writer);
         return true;
@@ -1065,44 +1540,249 @@ void IPC::HandleNotification(OpcodeControllerNotification opcode, PacketReader&
         LOG(ERROR) << "Exit received.";
         CloseEverything();
         break;
+    case OpcodeControllerNotification::StreamData:
+        HandleStreamDataNotification(reader);
+        break;
+    case OpcodeControllerNotification::StreamCredit:
+    {
+        std::optional<uint32_t> identifier = reader.read<uint32_t>();
+        std::optional<uint32_t> credit = reader.read<uint32_t>();
+        std::optional<uint8_t> status = reader.read<uint8_t>();
+        if (identifier && credit && status)
+            HandleStreamCredit(*identifier, *credit, static_cast<StreamDataStatus>(*status));
+        break;
+    }
     default:
         LOG(ERROR) << "Unknown notification opcode " << (uint32_t)opcode << ".";
         break;
     }
 }
 
-bool IPC::OpenClientStream(uint32_t identifier)
+void IPC::HandleStreamDataNotification(PacketReader& reader)
 {
-    if (!IsAvailable())
+    std::optional<uint32_t> identifier = reader.read<uint32_t>();
+    if (!identifier)
+        return;
+
+    bool canceled;
     {
-        return false;
+        std::lock_guard<std::mutex> lk(_dataStreamsMutex);
+        canceled = _canceledIncomingStreams.find(*identifier) != _canceledIncomingStreams.end();
     }
 
-    Call(OpcodeClient::StreamOpen, reinterpret_cast<uint8_t*>(&identifier), sizeof(uint32_t));
-    return true;
+    if (canceled)
+    {
+        SendStreamCredit(*identifier, 0, StreamDataStatus::Canceled);
+        return;
+    }
+
+    std::shared_ptr<DataStream> dataStream = FindIncomingStream(*identifier);
+    if (!dataStream)
+    {
+        SendStreamCredit(*identifier, 0, StreamDataStatus::Closed);
+        return;
+    }
+
+    // The credit window is smaller than the stream buffer, so everything the controller may send always fits.
+    const size_t chunkSize = reader.remainingSize();
+    size_t written = 0;
+    reader.copyTo(
+        [&](const uint8_t* data, size_t size)
+        {
+            written = dataStream->TryAdopt(reader.owner(), data, size, true);
+            return true;
+        },
+        chunkSize);
+
+    if (written == chunkSize)
+        return;
+
+    if (dataStream->State() == StreamState::Active)
+    {
+        LOG(ERROR) << "Stream " << *identifier << " exceeded its credit window, dropping it.";
+        dataStream->MarkError();
+    }
+    SendStreamCredit(*identifier, 0, StreamDataStatus::Canceled);
+}
+
+void IPC::ReturnStreamCredit(std::shared_ptr<IncomingStreamCredit> credit, size_t consumed, bool drained)
+{
+    if (credit->unacknowledged.fetch_add(consumed) + consumed < kStreamCreditThreshold)
+        return;
+
+    // While the stream memory budget is exhausted credit is held back so the controller stops sending, unless the
+    // reader already drained this stream and is waiting for more.
+    if (!drained && StreamMemoryBudget::Global().Exhausted())
+    {
+        if (credit->deferred.exchange(true))
+            return;
+
+        std::function<void()> retry = [this, credit]()
+        {
+            credit->deferred = false;
+            ReturnStreamCredit(credit, 0, false);
+        };
+        if (StreamMemoryBudget::Global().RegisterWaiter(std::move(retry)))
+            return;
+        credit->deferred = false;
+    }
+
+    size_t amount = credit->unacknowledged.exchange(0);
+    if (amount > 0 && IsAvailable())
+        SendStreamCredit(credit->identifier, amount, StreamDataStatus::Accepted);
 }
 
-bool IPC::StreamClientData(uint32_t identifier, const uint8_t* data, size_t size)
+void IPC::SendStreamCredit(uint32_t identifier, size_t credit, StreamDataStatus status)
 {
-    std::vector<uint8_t> packet(sizeof(uint32_t) + size);
-    memcpy(packet.data(), &identifier, sizeof(uint32_t));
-    if (size > 0)
-        memcpy(packet.data() + sizeof(uint32_t), data, size);
+    PacketWriter writer;
+    writer.write<uint32_t>(identifier);
+    writer.write<uint32_t>(static_cast<uint32_t>(credit));
+    writer.write<uint8_t>(static_cast<uint8_t>(status));
+    Notify(OpcodeClientNotification::StreamCredit, std::move(writer));
+}
 
-    std::vector<uint8_t> response = Call(OpcodeClient::StreamData, packet.data(), packet.size());
-    if (response.empty())
+void IPC::StartClientStreamUpload(uint32_t identifier, std::shared_ptr<std::atomic<bool>> cancelFlag, std::shared_ptr<const void> owner, const uint8_t* data, size_t size)
+{
+    if (cancelFlag->load() || !IsAvailable())
     {
-        return false;
+        RemoveOutgoingStream(identifier);
+        return;
     }
 
-    PacketReader reader(response.data(), response.size());
-    std::optional<bool> accepted = reader.read<bool>();
-    return accepted && *accepted;
+    std::shared_ptr<ClientStreamUpload> upload = std::make_shared<ClientStreamUpload>();
+    upload->identifier = identifier;
+    upload->cancelFlag = std::move(cancelFlag);
+    upload->owner = std::move(owner);
+    upload->data = data;
+    upload->size = size;
+    upload->lastCreditAt = std::chrono::steady_clock::now();
+
+    PacketWriter writer;
+    writer.write<uint32_t>(identifier);
+    if (!HasControllerCapability(kControllerCapabilityStreamCredit))
+    {
+        CallAsync(OpcodeClient::StreamOpen, std::move(writer),
+                  [this, upload](std::optional<std::vector<uint8_t>> response)
+                  {
+                      if (!response)
+                      {
+                          RemoveOutgoingStream(upload->identifier);
+                          return;
+                      }
+
+                      ContinueClientStreamUpload(upload);
+                  });
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(_outgoingStreamsMutex);
+        _clientStreamUploads[identifier] = upload;
+    }
+
+    // The controller handles StreamOpen and StreamData for one stream in arrival order, so data follows the open
+    // right away instead of waiting for its reply.
+    CallAsync(OpcodeClient::StreamOpen, std::move(writer), nullptr);
+
+    PumpClientStreamUpload(upload);
+}
+
+void IPC::PumpClientStreamUpload(std::shared_ptr<ClientStreamUpload> upload)
+{
+    bool finish = false;
+    {
+        std::lock_guard<std::mutex> lk(upload->mutex);
+        if (upload->finished)
+            return;
+
+        while (upload->offset < upload->size && upload->credit > 0 && !upload->cancelFlag->load() && IsAvailable())
+        {
+            size_t chunkSize = std::min({upload->chunkSizer.ChunkSize(), upload->credit, upload->size - upload->offset});
+            IOSegment segments[] = {{&upload->identifier, sizeof(uint32_t)}, {upload->data + upload->offset, chunkSize}};
+            Notify(OpcodeClientNotification::StreamData, segments, 2, upload);
+            upload->offset += chunkSize;
+            upload->credit -= chunkSize;
+        }
+
+        if (upload->offset >= upload->size || upload->cancelFlag->load() || !IsAvailable())
+        {
+            upload->finished = true;
+            finish = true;
+        }
+    }
+
+    if (finish)
+        FinishClientStreamUpload(upload);
+}
+
+void IPC::ContinueClientStreamUpload(std::shared_ptr<ClientStreamUpload> upload)
+{
+    if (upload->offset >= upload->size || !IsAvailable() || upload->cancelFlag->load())
+    {
+        FinishClientStreamUpload(upload);
+        return;
+    }
+
+    const size_t chunkSize = std::min(upload->chunkSizer.ChunkSize(), upload->size - upload->offset);
+    const auto sentAt = std::chrono::steady_clock::now();
+    IOSegment segments[] = {{&upload->identifier, sizeof(uint32_t)}, {upload->data + upload->offset, chunkSize}};
+    CallAsync(OpcodeClient::StreamData, segments, 2, upload,
+              [this, upload, chunkSize, sentAt](std::optional<std::vector<uint8_t>> response)
+              {
+                  std::optional<bool> accepted = std::nullopt;
+                  if (response && !response->empty())
+                  {
+                      PacketReader reader(response->data(), response->size());
+                      accepted = reader.read<bool>();
+                  }
+
+                  if (!accepted || !*accepted)
+                  {
+                      FinishClientStreamUpload(upload);
+                      return;
+                  }
+
+                  upload->offset += chunkSize;
+                  upload->chunkSizer.RecordTransfer(chunkSize, std::chrono::steady_clock::now() - sentAt);
+                  ContinueClientStreamUpload(upload);
+              });
 }
 
-void IPC::CloseClientStream(uint32_t identifier)
+void IPC::HandleStreamCredit(uint32_t identifier, size_t credit, StreamDataStatus status)
 {
-    Call(OpcodeClient::StreamClose, reinterpret_cast<uint8_t*>(&identifier), sizeof(uint32_t));
+    std::shared_ptr<ClientStreamUpload> upload;
+    {
+        std::lock_guard<std::mutex> lk(_outgoingStreamsMutex);
+        auto itr = _clientStreamUploads.find(identifier);
+        if (itr == _clientStreamUploads.end())
+            return;
+        upload = itr->second;
+    }
+
+    if (status != StreamDataStatus::Accepted)
+    {
+        upload->cancelFlag->store(true);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lk(upload->mutex);
+        upload->credit += credit;
+
+        const auto now = std::chrono::steady_clock::now();
+        upload->chunkSizer.RecordTransfer(credit, now - upload->lastCreditAt);
+        upload->lastCreditAt = now;
+    }
+
+    PumpClientStreamUpload(upload);
+}
+
+void IPC::FinishClientStreamUpload(std::shared_ptr<ClientStreamUpload> upload)
+{
+    RemoveOutgoingStream(upload->identifier);
+
+    PacketWriter writer;
+    writer.write<uint32_t>(upload->identifier);
+    CallAsync(OpcodeClient::StreamClose, std::move(writer), nullptr);
 }
 
 std::shared_ptr<std::atomic<bool>> IPC::RegisterOutgoingStream(uint32_t identifier)
@@ -1124,6 +1804,7 @@ void IPC::RemoveOutgoingStream(uint32_t identifier)
 {
     std::lock_guard<std::mutex> lk(_outgoingStreamsMutex);
     _outgoingStreams.erase(identifier);
+    _clientStreamUploads.erase(identifier);
 }
 
 bool IPC::SerializePostData(PacketWriter& writer, CefRefPtr<CefPostData> postData, std::vector<std::function<void()>>& streamWriters)
@@ -1152,7 +1833,8 @@ bool IPC::SerializePostData(PacketWriter& writer, CefRefPtr<CefPostData> postDat
         if (elementType == CefPostDataElement::Type::PDE_TYPE_BYTES)
         {
             size_t dataSize = element->GetBytesCount();
-            bool fitsInline = dataSize <= static_cast<size_t>(std::numeric_limits<uint32_t>::max()) && writer.size() + kInlineBodyElementFramingSize + dataSize <= MAXIMUM_IPC_SIZE;
+            bool fitsInline = dataSize <= static_cast<size_t>(std::numeric_limits<uint32_t>::max()) && dataSize <= _inlineThreshold &&
+                              writer.size() + kInlineBodyElementFramingSize + dataSize <= _maxPacketSize;
 
             if (fitsInline)
             {
@@ -1181,32 +1863,7 @@ bool IPC::SerializePostData(PacketWriter& writer, CefRefPtr<CefPostData> postDat
                 streamWriters.push_back(
                     [this, streamIdentifier, cancelFlag, data]()
                     {
-                        if (cancelFlag->load())
-                        {
-                            RemoveOutgoingStream(streamIdentifier);
-                            return;
-                        }
-
-                        if (!OpenClientStream(streamIdentifier))
-                        {
-                            RemoveOutgoingStream(streamIdentifier);
-                            return;
-                        }
-
-                        size_t offset = 0;
-                        while (offset < data->size() && IsAvailable() && !cancelFlag->load())
-                        {
-                            size_t chunkSize = std::min(kStreamChunkSize, data->size() - offset);
-                            if (!StreamClientData(streamIdentifier, data->data() + offset, chunkSize))
-                            {
-                                break;
-                            }
-
-                            offset += chunkSize;
-                        }
-
-                        RemoveOutgoingStream(streamIdentifier);
-                        CloseClientStream(streamIdentifier);
+                        StartClientStreamUpload(streamIdentifier, cancelFlag, data, data->data(), data->size());
                     });
             }
         }
@@ -1235,7 +1892,7 @@ bool IPC::SerializeBridgeRpcPayload(PacketWriter& writer, const std::string& pay
         return false;
     }
 
-    if (payload.size() <= MAXIMUM_IPC_SIZE - writer.size() - kBridgeRpcInlinePayloadFramingSize)
+    if (payload.size() <= _inlineThreshold && payload.size() <= _maxPacketSize - writer.size() - kBridgeRpcInlinePayloadFramingSize)
     {
         if (onAbort)
         {
@@ -1270,32 +1927,7 @@ bool IPC::SerializeBridgeRpcPayload(PacketWriter& writer, const std::string& pay
     streamWriters.push_back(
         [this, streamIdentifier, cancelFlag, sharedPayload]()
         {
-            if (cancelFlag->load())
-            {
-                RemoveOutgoingStream(streamIdentifier);
-                return;
-            }
-
-            if (!OpenClientStream(streamIdentifier))
-            {
-                RemoveOutgoingStream(streamIdentifier);
-                return;
-            }
-
-            size_t offset = 0;
-            while (offset < sharedPayload->size() && IsAvailable() && !cancelFlag->load())
-            {
-                size_t chunkSize = std::min(kStreamChunkSize, sharedPayload->size() - offset);
-                if (!StreamClientData(streamIdentifier, reinterpret_cast<const uint8_t*>(sharedPayload->data()) + offset, chunkSize))
-                {
-                    break;
-                }
-
-                offset += chunkSize;
-            }
-
-            RemoveOutgoingStream(streamIdentifier);
-            CloseClientStream(streamIdentifier);
+            StartClientStreamUpload(streamIdentifier, cancelFlag, sharedPayload, reinterpret_cast<const uint8_t*>(sharedPayload->data()), sharedPayload->size());
         });
 
     return true;
@@ -1309,7 +1941,7 @@ bool IPC::SerializeBinaryPayload(PacketWriter& writer, const uint8_t* payload, s
         return false;
     }
 
-    if (size <= MAXIMUM_IPC_SIZE - writer.size() - kBinaryInlinePayloadFramingSize)
+    if (size <= _inlineThreshold && size <= _maxPacketSize - writer.size() - kBinaryInlinePayloadFramingSize)
     {
         if (onAbort)
         {
@@ -1345,20 +1977,7 @@ bool IPC::SerializeBinaryPayload(PacketWriter& writer, const uint8_t* payload, s
         streamWriters.push_back(
             [this, streamIdentifier, cancelFlag]()
             {
-                if (cancelFlag->load())
-                {
-                    RemoveOutgoingStream(streamIdentifier);
-                    return;
-                }
-
-                if (!OpenClientStream(streamIdentifier))
-                {
-                    RemoveOutgoingStream(streamIdentifier);
-                    return;
-                }
-
-                RemoveOutgoingStream(streamIdentifier);
-                CloseClientStream(streamIdentifier);
+                StartClientStreamUpload(streamIdentifier, cancelFlag, nullptr, nullptr, 0);
             });
 
         return true;
@@ -1370,32 +1989,7 @@ bool IPC::SerializeBinaryPayload(PacketWriter& writer, const uint8_t* payload, s
     streamWriters.push_back(
         [this, streamIdentifier, cancelFlag, sharedPayload]()
         {
-            if (cancelFlag->load())
-            {
-                RemoveOutgoingStream(streamIdentifier);
-                return;
-            }
-
-            if (!OpenClientStream(streamIdentifier))
-            {
-                RemoveOutgoingStream(streamIdentifier);
-                return;
-            }
-
-            size_t offset = 0;
-            while (offset < sharedPayload->size() && IsAvailable() && !cancelFlag->load())
-            {
-                size_t chunkSize = std::min(kStreamChunkSize, sharedPayload->size() - offset);
-                if (!StreamClientData(streamIdentifier, sharedPayload->data() + offset, chunkSize))
-                {
-                    break;
-                }
-
-                offset += chunkSize;
-            }
-
-            RemoveOutgoingStream(streamIdentifier);
-            CloseClientStream(streamIdentifier);
+            StartClientStreamUpload(streamIdentifier, cancelFlag, sharedPayload, sharedPayload->data(), sharedPayload->size());
         });
 
     return true;
@@ -1430,9 +2024,10 @@ bool IPC::DeserializeBridgeRpcPayload(PacketReader& reader, std::string& payload
             return false;
         }
 
-        std::shared_ptr<DataStream> bodyStream = GetOrCreateIncomingStream(*streamId);
+        std::shared_ptr<DataStream> bodyStream = GetOrCreateIncomingStream(*streamId, DataStreamKind::BridgePayload);
         payload.resize(*payloadSize);
 
+        ThreadPool::BlockingScope blocking(_threadPool);
         size_t totalRead = 0;
         while (totalRead < payload.size())
         {
@@ -1468,12 +2063,12 @@ void IPC::QueueWindowBridgeRpcResponse(uint32_t requestId, bool success, const s
 
     if (streamWriters.empty())
     {
-        QueueResponse(OpcodeController::WindowBridgeRpc, requestId, writer);
+        QueueResponse(OpcodeController::WindowBridgeRpc, requestId, std::move(writer));
         return;
     }
 
     QueueResponse(
-        OpcodeController::WindowBridgeRpc, requestId, writer,
+        OpcodeController::WindowBridgeRpc, requestId, std::move(writer),
         [this, streamWriters = std::move(streamWriters)]() mutable
         {
             QueueDeferredStreamWriters(std::move(streamWriters));
@@ -1523,6 +2118,13 @@ void IPC::CloseStream(uint32_t identifier)
     StreamCancel(identifier);
 }
 
+void IPC::StreamCancel(uint32_t identifier)
+{
+    PacketWriter writer;
+    writer.write<uint32_t>(identifier);
+    CallAsync(OpcodeClient::StreamCancel, std::move(writer), nullptr);
+}
+
 void IPC::ReleaseIncomingStream(uint32_t identifier)
 {
     std::shared_ptr<DataStream> dataStream = nullptr;
@@ -1541,10 +2143,24 @@ void IPC::ReleaseIncomingStream(uint32_t identifier)
 }
 
 std::unique_ptr<IPCProxyResponse> IPC::WindowProxyRequest(int32_t identifier, CefRefPtr<CefRequest> request)
+{
+    std::shared_ptr<std::promise<std::unique_ptr<IPCProxyResponse>>> promise = std::make_shared<std::promise<std::unique_ptr<IPCProxyResponse>>>();
+    std::future<std::unique_ptr<IPCProxyResponse>> future = promise->get_future();
+    WindowProxyRequestAsync(identifier, request,
+                            [promise](std::unique_ptr<IPCProxyResponse> response)
+                            {
+                                promise->set_value(std::move(response));
+                            });
+    ThreadPool::BlockingScope blocking(_threadPool);
+    return future.get();
+}
+
+void IPC::WindowProxyRequestAsync(int32_t identifier, CefRefPtr<CefRequest> request, std::function<void(std::unique_ptr<IPCProxyResponse> response)> onComplete)
 {
     if (!IsAvailable())
     {
-        return nullptr;
+        onComplete(nullptr);
+        return;
     }
 
     PacketWriter writer;
@@ -1566,358 +2182,406 @@ std::unique_ptr<IPCProxyResponse> IPC::WindowProxyRequest(int32_t identifier, Ce
     if (!SerializePostData(writer, postData, streamWriters))
     {
         LOG(ERROR) << "Failed to serialize proxy request post data.";
-        return nullptr;
+        onComplete(nullptr);
+        return;
     }
 
-    std::vector<uint8_t> response = Call(OpcodeClient::WindowProxyRequest, writer.data(), writer.size(),
-                                         [this, streamWriters = std::move(streamWriters)]() mutable
-                                         {
-                                             QueueDeferredStreamWriters(std::move(streamWriters));
-                                         });
-    std::unique_ptr<IPCProxyResponse> result = nullptr;
+    CallAsync(
+        OpcodeClient::WindowProxyRequest, std::move(writer),
+        [this, onComplete = std::move(onComplete)](std::optional<std::vector<uint8_t>> response)
+        {
+            onComplete(response && !response->empty() ? ParseProxyResponse(*response) : nullptr);
+        },
+        [this, streamWriters = std::move(streamWriters)]() mutable
+        {
+            QueueDeferredStreamWriters(std::move(streamWriters));
+        });
+}
+
+std::unique_ptr<IPCProxyResponse> IPC::ParseProxyResponse(const std::vector<uint8_t>& response)
+{
+    PacketReader reader(response.data(), response.size());
 
-    if (!response.empty())
+    // Deserialize method
+    std::optional<uint32_t> statusCode = reader.read<uint32_t>();
+    if (!statusCode)
     {
-        PacketReader reader(response.data(), response.size());
+        LOG(ERROR) << "Failed to read status code.";
+        return nullptr;
+    }
 
-        // Deserialize method
-        std::optional<uint32_t> statusCode = reader.read<uint32_t>();
-        if (!statusCode)
-        {
-            LOG(ERROR) << "Failed to read status code.";
-            return nullptr;
-        }
+    std::optional<std::string> statusText = reader.readSizePrefixedString();
+    if (!statusText)
+    {
+        LOG(ERROR) << "Failed to read status text.";
+        return nullptr;
+    }
+
+    // Deserialize headers
+    std::optional<uint32_t> responseHeaderCount = reader.read<uint32_t>();
+    if (!responseHeaderCount)
+    {
+        LOG(ERROR) << "Failed to read response header count.";
+        return nullptr;
+    }
 
-        std::optional<std::string> statusText = reader.readSizePrefixedString();
-        if (!statusText)
+    std::optional<std::string> mediaType = std::nullopt;
+    std::multimap<std::string, std::string> responseHeaders;
+    for (uint32_t i = 0; i < *responseHeaderCount; ++i)
+    {
+        std::optional<std::string> key = reader.readSizePrefixedString();
+        if (!key)
         {
-            LOG(ERROR) << "Failed to read status text.";
+            LOG(ERROR) << "Failed to read response header key text.";
             return nullptr;
         }
 
-        // Deserialize headers
-        std::optional<uint32_t> responseHeaderCount = reader.read<uint32_t>();
-        if (!responseHeaderCount)
+        std::optional<std::string> value = reader.readSizePrefixedString();
+        if (!value)
         {
-            LOG(ERROR) << "Failed to read response header count.";
+            LOG(ERROR) << "Failed to read response header value text.";
             return nullptr;
         }
 
-        std::optional<std::string> mediaType = std::nullopt;
-        std::multimap<std::string, std::string> responseHeaders;
-        for (uint32_t i = 0; i < *responseHeaderCount; ++i)
-        {
-            std::optional<std::string> key = reader.readSizePrefixedString();
-            if (!key)
-            {
-                LOG(ERROR) << "Failed to read response header key text.";
-                return nullptr;
-            }
-
-            std::optional<std::string> value = reader.readSizePrefixedString();
-            if (!value)
-            {
-                LOG(ERROR) << "Failed to read response header value text.";
-                return nullptr;
-            }
-
-            if (key && value && (*key).c_str() && (*value).c_str() &&
+        if (key && value && (*key).c_str() && (*value).c_str() &&
 #ifdef _WIN32
-                stricmp((*key).c_str(), "content-type") == 0
+            stricmp((*key).c_str(), "content-type") == 0
 #else
-                strcasecmp((*key).c_str(), "content-type") == 0
+            strcasecmp((*key).c_str(), "content-type") == 0
 #endif
-            )
-            {
-                size_t semicolonPos = (*value).find(';');
-                mediaType = semicolonPos != std::string::npos ? (*value).substr(0, semicolonPos) : *value;
-            }
-
-            responseHeaders.insert({*key, *value});
+        )
+        {
+            size_t semicolonPos = (*value).find(';');
+            mediaType = semicolonPos != std::string::npos ? (*value).substr(0, semicolonPos) : *value;
         }
 
-        // Deserialize elements
-        std::optional<uint8_t> bodyType = reader.read<uint8_t>();
-        if (!bodyType)
+        responseHeaders.insert({*key, *value});
+    }
+
+    // Deserialize elements
+    std::optional<uint8_t> bodyType = reader.read<uint8_t>();
+    if (!bodyType)
+    {
+        LOG(ERROR) << "Failed to read body type.";
+        return nullptr;
+    }
+
+    std::optional<std::vector<uint8_t>> body = std::nullopt;
+    std::shared_ptr<DataStream> bodyStream = nullptr;
+    int64_t streamBodyLength = -1;
+    uint8_t streamLengthMode = 0;
+    if (*bodyType == 1)
+    {
+        std::optional<uint32_t> bodySize = reader.read<uint32_t>();
+        if (!bodySize)
         {
-            LOG(ERROR) << "Failed to read body type.";
+            LOG(ERROR) << "Failed to read body size.";
             return nullptr;
         }
 
-        std::optional<std::vector<uint8_t>> body = std::nullopt;
-        std::shared_ptr<DataStream> bodyStream = nullptr;
-        int64_t streamBodyLength = -1;
-        uint8_t streamLengthMode = 0;
-        if (*bodyType == 1)
+        if (*bodySize > 0)
         {
-            std::optional<uint32_t> bodySize = reader.read<uint32_t>();
-            if (!bodySize)
+            std::vector<uint8_t> data(*bodySize);
+            if (!reader.readBytes(data.data(), *bodySize))
             {
-                LOG(ERROR) << "Failed to read body size.";
+                LOG(ERROR) << "Proxy missing body (bodySize = " << *bodySize << ", remainingSize = " << reader.remainingSize() << ")";
                 return nullptr;
             }
 
-            if (*bodySize > 0)
-            {
-                std::vector<uint8_t> data(*bodySize);
-                if (!reader.readBytes(data.data(), *bodySize))
-                {
-                    LOG(ERROR) << "Proxy missing body (bodySize = " << *bodySize << ", remainingSize = " << reader.remainingSize() << ")";
-                    return nullptr;
-                }
-
-                body = data;
-            }
+            body = std::move(data);
         }
-        else if (*bodyType == 2)
+    }
+    else if (*bodyType == 2)
+    {
+        std::optional<int64_t> bodyLength = reader.read<int64_t>();
+        std::optional<uint8_t> lengthMode = reader.read<uint8_t>();
+        std::optional<uint32_t> streamId = reader.read<uint32_t>();
+        if (!bodyLength || !lengthMode || !streamId)
         {
-            std::optional<int64_t> bodyLength = reader.read<int64_t>();
-            std::optional<uint8_t> lengthMode = reader.read<uint8_t>();
-            std::optional<uint32_t> streamId = reader.read<uint32_t>();
-            if (!bodyLength || !lengthMode || !streamId)
-            {
-                LOG(ERROR) << "Failed to read stream body length / mode / id.";
-                return nullptr;
-            }
-
-            streamBodyLength = *bodyLength;
-            streamLengthMode = *lengthMode;
-            bodyStream = GetOrCreateIncomingStream(*streamId);
+            LOG(ERROR) << "Failed to read stream body length / mode / id.";
+            return nullptr;
         }
 
-        result = std::unique_ptr<IPCProxyResponse>(new IPCProxyResponse());
-        result->status_code = (int32_t)*statusCode;
-        result->status_text = *statusText;
-        result->headers = responseHeaders;
-        result->media_type = mediaType;
-        result->body = body;
-        result->bodyStream = bodyStream;
-        result->bodyLength = streamBodyLength;
-        result->lengthMode = streamLengthMode;
-
-        return result;
+        streamBodyLength = *bodyLength;
+        streamLengthMode = *lengthMode;
+        bodyStream = GetOrCreateIncomingStream(*streamId, DataStreamKind::ProxyResponseBody);
     }
 
-    return nullptr;
+    std::unique_ptr<IPCProxyResponse> result = std::unique_ptr<IPCProxyResponse>(new IPCProxyResponse());
+    result->status_code = (int32_t)*statusCode;
+    result->status_text = *statusText;
+    result->headers = responseHeaders;
+    result->media_type = mediaType;
+    result->body = body;
+    result->bodyStream = bodyStream;
+    result->bodyLength = streamBodyLength;
+    result->lengthMode = streamLengthMode;
+
+    return result;
 }
 
 void IPC::WindowModifyRequest(int32_t identifier, CefRefPtr<CefRequest> request, bool modifyRequestBody)
+{
+    std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+    std::future<void> future = promise->get_future();
+    WindowModifyRequestAsync(identifier, request, modifyRequestBody,
+                             [promise]()
+                             {
+                                 promise->set_value();
+                             });
+    ThreadPool::BlockingScope blocking(_threadPool);
+    future.wait();
+}
+
+void IPC::WindowModifyRequestAsync(int32_t identifier, CefRefPtr<CefRequest> request, bool modifyRequestBody, std::function<void()> onComplete)
 {
     if (!IsAvailable())
     {
+        onComplete();
         return;
     }
 
-    std::vector<uint8_t> response;
+    PacketWriter writer;
+    std::vector<std::function<void()>> streamWriters;
+    writer.write<int32_t>(identifier);
+    writer.writeSizePrefixedString(request->GetMethod());
+    writer.writeSizePrefixedString(request->GetURL());
+
+    CefRequest::HeaderMap headers;
+    request->GetHeaderMap(headers);
+    writer.write<int32_t>((int32_t)headers.size());
+    for (auto& header : headers)
     {
-        PacketWriter writer;
-        std::vector<std::function<void()>> streamWriters;
-        writer.write<int32_t>(identifier);
-        writer.writeSizePrefixedString(request->GetMethod());
-        writer.writeSizePrefixedString(request->GetURL());
+        writer.writeSizePrefixedString(header.first);
+        writer.writeSizePrefixedString(header.second);
+    }
 
-        CefRequest::HeaderMap headers;
-        request->GetHeaderMap(headers);
-        writer.write<int32_t>((int32_t)headers.size());
-        for (auto& header : headers)
+    CefRefPtr<CefPostData> postData = request->GetPostData();
+    if (modifyRequestBody)
+    {
+        if (!SerializePostData(writer, postData, streamWriters))
         {
-            writer.writeSizePrefixedString(header.first);
-            writer.writeSizePrefixedString(header.second);
+            LOG(ERROR) << "Failed to serialize modify request post data.";
+            onComplete();
+            return;
         }
+    }
+    else if (!writer.write<int32_t>(0))
+    {
+        LOG(ERROR) << "Failed to serialize empty modify request body.";
+        onComplete();
+        return;
+    }
 
-        CefRefPtr<CefPostData> postData = request->GetPostData();
-        if (modifyRequestBody)
+    CallAsync(
+        OpcodeClient::WindowModifyRequest, std::move(writer),
+        [this, request, modifyRequestBody, onComplete = std::move(onComplete)](std::optional<std::vector<uint8_t>> response)
         {
-            if (!SerializePostData(writer, postData, streamWriters))
-            {
-                LOG(ERROR) << "Failed to serialize modify request post data.";
-                return;
-            }
-        }
-        else if (!writer.write<int32_t>(0))
+            if (response && !response->empty())
+                ApplyModifyResponse(request, modifyRequestBody, *response);
+            onComplete();
+        },
+        [this, streamWriters = std::move(streamWriters)]() mutable
         {
-            LOG(ERROR) << "Failed to serialize empty modify request body.";
-            return;
-        }
+            QueueDeferredStreamWriters(std::move(streamWriters));
+        });
+}
+
+void IPC::ApplyModifyResponse(CefRefPtr<CefRequest> request, bool modifyRequestBody, const std::vector<uint8_t>& response)
+{
+    PacketReader reader(response.data(), response.size());
+
+    std::optional<std::string> method = reader.readSizePrefixedString();
+    if (!method)
+    {
+        LOG(ERROR) << "Failed to read method.";
+        return;
+    }
 
-        response = Call(OpcodeClient::WindowModifyRequest, writer.data(), writer.size(),
-                        [this, streamWriters = std::move(streamWriters)]() mutable
-                        {
-                            QueueDeferredStreamWriters(std::move(streamWriters));
-                        });
+    std::optional<std::string> url = reader.readSizePrefixedString();
+    if (!url)
+    {
+        LOG(ERROR) << "Failed to read url.";
+        return;
     }
 
-    if (!response.empty())
+    // Deserialize headers
+    std::optional<uint32_t> headerCount = reader.read<uint32_t>();
+    if (!headerCount)
     {
-        PacketReader reader(response.data(), response.size());
+        LOG(ERROR) << "Failed to read header count.";
+        return;
+    }
 
-        std::optional<std::string> method = reader.readSizePrefixedString();
-        if (!method)
+    CefRequest::HeaderMap headers;
+    for (uint32_t i = 0; i < *headerCount; ++i)
+    {
+        std::optional<std::string> key = reader.readSizePrefixedString();
+        if (!key)
         {
-            LOG(ERROR) << "Failed to read method.";
+            LOG(ERROR) << "Failed to read key.";
             return;
         }
-
-        std::optional<std::string> url = reader.readSizePrefixedString();
-        if (!url)
+        std::optional<std::string> value = reader.readSizePrefixedString();
+        if (!value)
         {
-            LOG(ERROR) << "Failed to read url.";
+            LOG(ERROR) << "Failed to read value.";
             return;
         }
 
-        // Deserialize headers
-        std::optional<uint32_t> headerCount = reader.read<uint32_t>();
-        if (!headerCount)
-        {
-            LOG(ERROR) << "Failed to read header count.";
-            return;
-        }
+        headers.insert(std::make_pair(*key, *value));
+    }
+
+    // Deserialize elements
+    std::optional<uint32_t> elementCount = reader.read<uint32_t>();
+    if (!elementCount)
+    {
+        LOG(ERROR) << "Failed to read element count.";
+        return;
+    }
 
-        CefRequest::HeaderMap headers;
-        for (uint32_t i = 0; i < *headerCount; ++i)
+    if (modifyRequestBody)
+    {
+        CefRefPtr<CefPostData> postData = CefPostData::Create();
+        for (uint32_t i = 0; i < *elementCount; ++i)
         {
-            std::optional<std::string> key = reader.readSizePrefixedString();
-            if (!key)
-            {
-                LOG(ERROR) << "Failed to read key.";
-                return;
-            }
-            std::optional<std::string> value = reader.readSizePrefixedString();
-            if (!value)
+            std::optional<uint8_t> elementType = reader.read<uint8_t>();
+            if (!elementType)
             {
-                LOG(ERROR) << "Failed to read value.";
+                LOG(ERROR) << "Failed to read element type.";
                 return;
             }
 
-            headers.insert(std::make_pair(*key, *value));
-        }
-
-        // Deserialize elements
-        std::optional<uint32_t> elementCount = reader.read<uint32_t>();
-        if (!elementCount)
-        {
-            LOG(ERROR) << "Failed to read element count.";
-            return;
-        }
-
-        if (modifyRequestBody)
-        {
-            CefRefPtr<CefPostData> postData = CefPostData::Create();
-            for (uint32_t i = 0; i < *elementCount; ++i)
+            if (*elementType == CefPostDataElement::Type::PDE_TYPE_BYTES)
             {
-                std::optional<uint8_t> elementType = reader.read<uint8_t>();
-                if (!elementType)
+                std::optional<uint32_t> dataSize = reader.read<uint32_t>();
+                if (!dataSize)
                 {
-                    LOG(ERROR) << "Failed to read element type.";
+                    LOG(ERROR) << "Failed to read data size.";
                     return;
                 }
-
-                if (*elementType == CefPostDataElement::Type::PDE_TYPE_BYTES)
+                if (!reader.hasAvailable(*dataSize))
                 {
-                    std::optional<uint32_t> dataSize = reader.read<uint32_t>();
-                    if (!dataSize)
-                    {
-                        LOG(ERROR) << "Failed to read data size.";
-                        return;
-                    }
-                    if (!reader.hasAvailable(*dataSize))
-                    {
-                        LOG(ERROR) << "Not enough data available to read body.";
-                        return;
-                    }
+                    LOG(ERROR) << "Not enough data available to read body.";
+                    return;
+                }
 
-                    CefRefPtr<CefPostDataElement> element = CefPostDataElement::Create();
-                    reader.copyTo(
-                        [element](const uint8_t* data, size_t size)
-                        {
-                            element->SetToBytes(size, data);
-                            return true;
-                        },
-                        *dataSize);
+                CefRefPtr<CefPostDataElement> element = CefPostDataElement::Create();
+                reader.copyTo(
+                    [element](const uint8_t* data, size_t size)
+                    {
+                        element->SetToBytes(size, data);
+                        return true;
+                    },
+                    *dataSize);
 
-                    postData->AddElement(element);
-                }
-                else if (*elementType == CefPostDataElement::Type::PDE_TYPE_FILE)
+                postData->AddElement(element);
+            }
+            else if (*elementType == CefPostDataElement::Type::PDE_TYPE_FILE)
+            {
+                std::optional<std::string> fileName = reader.readSizePrefixedString();
+                if (!fileName)
                 {
-                    std::optional<std::string> fileName = reader.readSizePrefixedString();
-                    if (!fileName)
-                    {
-                        LOG(ERROR) << "Failed to read file name.";
-                        return;
-                    }
-                    CefRefPtr<CefPostDataElement> element = CefPostDataElement::Create();
-                    element->SetToFile(*fileName);
-                    postData->AddElement(element);
+                    LOG(ERROR) << "Failed to read file name.";
+                    return;
                 }
-                else if (*elementType == kIPCProxyBodyElementStream)
+                CefRefPtr<CefPostDataElement> element = CefPostDataElement::Create();
+                element->SetToFile(*fileName);
+                postData->AddElement(element);
+            }
+            else if (*elementType == kIPCProxyBodyElementStream)
+            {
+                std::optional<int64_t> dataSize = reader.read<int64_t>();
+                if (!dataSize)
                 {
-                    std::optional<int64_t> dataSize = reader.read<int64_t>();
-                    if (!dataSize)
-                    {
-                        LOG(ERROR) << "Failed to read stream data size.";
-                        return;
-                    }
+                    LOG(ERROR) << "Failed to read stream data size.";
+                    return;
+                }
 
-                    std::optional<uint32_t> streamId = reader.read<uint32_t>();
-                    if (!streamId)
-                    {
-                        LOG(ERROR) << "Failed to read stream id.";
-                        return;
-                    }
+                std::optional<uint32_t> streamId = reader.read<uint32_t>();
+                if (!streamId)
+                {
+                    LOG(ERROR) << "Failed to read stream id.";
+                    return;
+                }
 
-                    std::shared_ptr<DataStream> bodyStream = GetOrCreateIncomingStream(*streamId);
+                std::shared_ptr<DataStream> bodyStream = GetOrCreateIncomingStream(*streamId, DataStreamKind::RequestBody);
 
-                    std::vector<uint8_t> data;
-                    if (*dataSize > 0)
-                        data.reserve(static_cast<size_t>(*dataSize));
+                // Read straight into the element bytes, grown as they arrive. The declared size only sizes the
+                // reservation, capped at one packet, so a bogus size cannot allocate ahead of the data.
+                std::vector<uint8_t> data;
+                if (*dataSize > 0)
+                    data.reserve(std::min(static_cast<size_t>(*dataSize), _maxPacketSize));
 
-                    uint8_t buffer[kStreamChunkSize];
-                    int64_t remaining = *dataSize;
-                    while (remaining < 0 || remaining > 0)
+                size_t received = 0;
+                int64_t remaining = *dataSize;
+                ThreadPool::BlockingScope blocking(_threadPool);
+                while (remaining < 0 || remaining > 0)
+                {
+                    if (data.size() - received < StreamChunkSizer::kMinChunkClass)
                     {
-                        size_t requestedBytes = remaining >= 0 ? std::min(static_cast<size_t>(remaining), sizeof(buffer)) : sizeof(buffer);
-                        size_t bytesRead = bodyStream->Read(buffer, requestedBytes);
-                        if (bytesRead == 0)
-                            break;
-
-                        data.insert(data.end(), buffer, buffer + bytesRead);
-                        if (remaining >= 0)
-                            remaining -= static_cast<int64_t>(bytesRead);
+                        size_t grown = std::max(data.size() * 2, received + StreamChunkSizer::kMaxChunkClass);
+                        if (remaining > 0)
+                            grown = std::min(grown, received + static_cast<size_t>(remaining));
+                        data.resize(grown);
                     }
 
-                    if (*dataSize >= 0 && remaining > 0)
-                    {
-                        ReleaseIncomingStream(*streamId);
-                        LOG(ERROR) << "Failed to fully read streamed request body element.";
-                        return;
-                    }
+                    size_t bytesRead = bodyStream->Read(data.data() + received, data.size() - received);
+                    if (bytesRead == 0)
+                        break;
+
+                    received += bytesRead;
+                    if (remaining >= 0)
+                        remaining -= static_cast<int64_t>(bytesRead);
+                }
+                data.resize(received);
 
-                    CefRefPtr<CefPostDataElement> element = CefPostDataElement::Create();
-                    element->SetToBytes(data.size(), data.empty() ? nullptr : data.data());
-                    postData->AddElement(element);
+                if (*dataSize >= 0 && remaining > 0)
+                {
                     ReleaseIncomingStream(*streamId);
+                    LOG(ERROR) << "Failed to fully read streamed request body element.";
+                    return;
                 }
-            }
 
-            request->SetPostData(postData);
+                CefRefPtr<CefPostDataElement> element = CefPostDataElement::Create();
+                element->SetToBytes(data.size(), data.empty() ? nullptr : data.data());
+                postData->AddElement(element);
+                ReleaseIncomingStream(*streamId);
+            }
         }
 
-        // LOG(INFO) << "Request modifier:\n  Method: " << *method << "\nURL: " << *url << "\nHeaders: ";
-        // for (const auto& header : headers) {
-        //     LOG(INFO) << "  " << header.first << ": " << header.second;
-        // }
-
-        request->SetMethod(*method);
-        request->SetURL(*url);
-        request->SetHeaderMap(headers);
+        request->SetPostData(postData);
     }
+
+    // LOG(INFO) << "Request modifier:\n  Method: " << *method << "\nURL: " << *url << "\nHeaders: ";
+    // for (const auto& header : headers) {
+    //     LOG(INFO) << "  " << header.first << ": " << header.second;
+    // }
+
+    request->SetMethod(*method);
+    request->SetURL(*url);
+    request->SetHeaderMap(headers);
 }
 
 IPCBridgeRpcResult IPC::WindowBridgeRpc(int32_t identifier, const std::string& method, const std::string& payload_json)
+{
+    std::shared_ptr<std::promise<IPCBridgeRpcResult>> promise = std::make_shared<std::promise<IPCBridgeRpcResult>>();
+    std::future<IPCBridgeRpcResult> future = promise->get_future();
+    WindowBridgeRpcAsync(identifier, method, payload_json,
+                         [promise](IPCBridgeRpcResult result)
+                         {
+                             promise->set_value(std::move(result));
+                         });
+    ThreadPool::BlockingScope blocking(_threadPool);
+    return future.get();
+}
+
+void IPC::WindowBridgeRpcAsync(int32_t identifier, const std::string& method, const std::string& payload_json, std::function<void(IPCBridgeRpcResult result)> onComplete)
 {
     if (!IsAvailable())
     {
-        return MakeBridgeRpcResult(false, "null", "IPC is not available.");
+        onComplete(MakeBridgeRpcResult(false, "null", "IPC is not available."));
+        return;
     }
 
     PacketWriter writer;
@@ -1926,7 +2590,8 @@ IPCBridgeRpcResult IPC::WindowBridgeRpc(int32_t identifier, const std::string& m
     writer.writeSizePrefixedString(method);
     if (!SerializeBridgeRpcPayload(writer, payload_json, streamWriters))
     {
-        return MakeBridgeRpcResult(false, "null", "Failed to serialize the bridge RPC payload.");
+        onComplete(MakeBridgeRpcResult(false, "null", "Failed to serialize the bridge RPC payload."));
+        return;
     }
 
     std::function<void()> afterWrite = nullptr;
@@ -1938,13 +2603,23 @@ IPCBridgeRpcResult IPC::WindowBridgeRpc(int32_t identifier, const std::string& m
         };
     }
 
-    std::vector<uint8_t> response = Call(OpcodeClient::WindowBridgeRpc, writer.data(), writer.size(), std::move(afterWrite));
-    if (response.empty())
+    CallAsync(
+        OpcodeClient::WindowBridgeRpc, std::move(writer),
+        [this, onComplete = std::move(onComplete)](std::optional<std::vector<uint8_t>> response)
+        {
+            onComplete(ParseBridgeRpcResponse(response));
+        },
+        std::move(afterWrite));
+}
+
+IPCBridgeRpcResult IPC::ParseBridgeRpcResponse(const std::optional<std::vector<uint8_t>>& response)
+{
+    if (!response || response->empty())
     {
         return MakeBridgeRpcResult(false, "null", "Bridge RPC returned an empty response.");
     }
 
-    PacketReader reader(response.data(), response.size());
+    PacketReader reader(response->data(), response->size());
     std::optional<bool> success = reader.read<bool>();
     if (!success)
     {
@@ -2053,7 +2728,7 @@ void IPC::NotifyWindowFullscreenChanged(CefRefPtr<CefBrowser> browser, bool full
     PacketWriter writer;
     writer.write(browser->GetIdentifier());
     writer.write(fullscreen);
-    Notify(OpcodeClientNotification::WindowFullscreenChanged, writer);
+    Notify(OpcodeClientNotification::WindowFullscreenChanged, std::move(writer));
 }
 
 void IPC::NotifyWindowFrameLoadStart(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame)
@@ -2063,7 +2738,7 @@ void IPC::NotifyWindowFrameLoadStart(CefRefPtr<CefBrowser> browser, CefRefPtr<Ce
     writer.writeSizePrefixedString(frame ? frame->GetIdentifier() : "");
     writer.write(frame ? frame->IsMain() : false);
     writer.writeSizePrefixedString(frame ? frame->GetURL() : "");
-    Notify(OpcodeClientNotification::WindowFrameLoadStart, writer);
+    Notify(OpcodeClientNotification::WindowFrameLoadStart, std::move(writer));
 }
 
 void IPC::NotifyWindowFrameLoadEnd(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, int httpStatusCode)
@@ -2074,7 +2749,7 @@ void IPC::NotifyWindowFrameLoadEnd(CefRefPtr<CefBrowser> browser, CefRefPtr<CefF
     writer.write(frame ? frame->IsMain() : false);
     writer.writeSizePrefixedString(frame ? frame->GetURL() : "");
     writer.write<int32_t>(httpStatusCode);
-    Notify(OpcodeClientNotification::WindowFrameLoadEnd, writer);
+    Notify(OpcodeClientNotification::WindowFrameLoadEnd, std::move(writer));
 }
 
 void IPC::NotifyWindowFrameLoadError(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, cef_errorcode_t errorCode, const CefString& errorText, const CefString& url)
@@ -2086,7 +2761,7 @@ void IPC::NotifyWindowFrameLoadError(CefRefPtr<CefBrowser> browser, CefRefPtr<Ce
     writer.write((int32_t)errorCode);
     writer.writeSizePrefixedString(errorText);
     writer.writeSizePrefixedString(url);
-    Notify(OpcodeClientNotification::WindowFrameLoadError, writer);
+    Notify(OpcodeClientNotification::WindowFrameLoadError, std::move(writer));
 }
 
 void IPC::NotifyWindowLoadingStateChanged(CefRefPtr<CefBrowser> browser, bool isLoading, bool canGoBack, bool canGoForward)
@@ -2096,7 +2771,7 @@ void IPC::NotifyWindowLoadingStateChanged(CefRefPtr<CefBrowser> browser, bool is
     writer.write(isLoading);
     writer.write(canGoBack);
     writer.write(canGoForward);
-    Notify(OpcodeClientNotification::WindowLoadingStateChanged, writer);
+    Notify(OpcodeClientNotification::WindowLoadingStateChanged, std::move(writer));
 }
 
 void IPC::NotifyWindowDevToolsEvent(CefRefPtr<CefBrowser> browser, const CefString& method, const uint8_t* result, size_t result_size)
@@ -2122,7 +2797,7 @@ void IPC::NotifyWindowDevToolsEvent(CefRefPtr<CefBrowser> browser, const CefStri
         };
     }
 
-    Notify(OpcodeClientNotification::WindowDevToolsEvent, writer, std::move(afterWrite), std::move(onAbort));
+    Notify(OpcodeClientNotification::WindowDevToolsEvent, std::move(writer), std::move(afterWrite), std::move(onAbort));
 }
 
 #ifdef _WIN32
@@ -2135,8 +2810,34 @@ void IPC::SetHandles(int readFd, int writeFd)
 {
     _pipe.SetHandles(readFd, writeFd);
 }
+
+bool IPC::AttachSharedMemoryTransport(int shmFd, int livenessReadFd)
+{
+    return _shm.Attach(shmFd, livenessReadFd);
+}
 #endif
 
+size_t IPC::ReadTransport(void* buffer, size_t size)
+{
+    if (_shmReadActive)
+        return _shm.Read(buffer, size, true);
+    return _pipe.Read(buffer, size, true);
+}
+
+size_t IPC::WriteTransport(const void* buffer, size_t size)
+{
+    if (_shmWriteActive)
+        return _shm.Write(buffer, size, true);
+    return _pipe.Write(buffer, size, true);
+}
+
+size_t IPC::WriteTransportV(const IOSegment* segments, size_t count)
+{
+    if (_shmWriteActive)
+        return _shm.WriteV(segments, count);
+    return _pipe.WriteV(segments, count);
+}
+
 class WindowDelegate : public CefWindowDelegate
 {
 public:
@@ -2453,7 +3154,7 @@ bool IPC::HandleWindowBridgeRpcRequest(uint32_t requestId, PacketReader& reader,
                                      if (!browser)
                                      {
                                          WriteInlineBridgeRpcResult(writer, false, "HandleWindowBridgeRpc called while the browser is already closed.");
-                                         IPC::Singleton.QueueResponse(OpcodeController::WindowBridgeRpc, requestId, writer);
+                                         IPC::Singleton.QueueResponse(OpcodeController::WindowBridgeRpc, requestId, std::move(writer));
                                          return;
                                      }
 
@@ -2462,7 +3163,7 @@ bool IPC::HandleWindowBridgeRpcRequest(uint32_t requestId, PacketReader& reader,
                                      if (!client)
                                      {
                                          WriteInlineBridgeRpcResult(writer, false, "HandleWindowBridgeRpc failed to acquire the client.");
-                                         IPC::Singleton.QueueResponse(OpcodeController::WindowBridgeRpc, requestId, writer);
+                                         IPC::Singleton.QueueResponse(OpcodeController::WindowBridgeRpc, requestId, std::move(writer));
                                          return;
                                      }
 
@@ -3556,7 +4257,7 @@ bool IPC::HandleWindowExecuteDevToolsMethodRequest(uint32_t requestId, PacketRea
     }
 
     QueueResponse(
-        OpcodeController::WindowExecuteDevToolsMethod, requestId, writer,
+        OpcodeController::WindowExecuteDevToolsMethod, requestId, std::move(writer),
         [this, streamWriters = std::move(streamWriters)]() mutable
         {
             QueueDeferredStreamWriters(std::move(streamWriters));
@@ -3743,6 +4444,144 @@ void HandleRemoveUrlToProxy(PacketReader& reader, PacketWriter& writer)
     LOG(INFO) << "Removed URL to proxy: " + *url;
 }
 
+void HandleAddUrlPatternToProxy(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleAddUrlPatternToProxy(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    std::optional<uint8_t> kind = reader.read<uint8_t>();
+    std::optional<std::string> pattern = reader.readSizePrefixedString();
+    if (!identifier || !kind || *kind > (uint8_t)UrlPatternKind::Glob || !pattern)
+    {
+        LOG(ERROR) << "HandleAddUrlPatternToProxy called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleAddUrlPatternToProxy called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleAddUrlPatternToProxy client is null. Ignored.";
+        return;
+    }
+
+    pClient->AddUrlToProxy(*pattern, (UrlPatternKind)*kind);
+    LOG(INFO) << "Added URL pattern to proxy: " + *pattern;
+}
+
+void HandleRemoveUrlPatternToProxy(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleRemoveUrlPatternToProxy(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    std::optional<uint8_t> kind = reader.read<uint8_t>();
+    std::optional<std::string> pattern = reader.readSizePrefixedString();
+    if (!identifier || !kind || *kind > (uint8_t)UrlPatternKind::Glob || !pattern)
+    {
+        LOG(ERROR) << "HandleRemoveUrlPatternToProxy called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleRemoveUrlPatternToProxy called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleRemoveUrlPatternToProxy client is null. Ignored.";
+        return;
+    }
+
+    pClient->RemoveUrlToProxy(*pattern, (UrlPatternKind)*kind);
+    LOG(INFO) << "Removed URL pattern to proxy: " + *pattern;
+}
+
+void HandleWindowSetRequestRewriteRules(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleWindowSetRequestRewriteRules(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    std::optional<std::vector<RequestRewriteRule>> rules = ReadRequestRewriteRules(reader);
+    if (!identifier || !rules)
+    {
+        LOG(ERROR) << "HandleWindowSetRequestRewriteRules called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleWindowSetRequestRewriteRules called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleWindowSetRequestRewriteRules client is null. Ignored.";
+        return;
+    }
+
+    const size_t count = rules->size();
+    pClient->GetRequestRewriter().SetRules(std::move(*rules));
+    LOG(INFO) << "Set " << count << " request rewrite rules.";
+}
+
 void HandleAddDomainToProxy(PacketReader& reader, PacketWriter& writer)
 {
     if (!CefCurrentlyOn(TID_UI))
@@ -3833,6 +4672,247 @@ void HandleRemoveDomainToProxy(PacketReader& reader, PacketWriter& writer)
     LOG(INFO) << "Removed domain to proxy: " + *url;
 }
 
+void HandleWindowSetProxyCache(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleWindowSetProxyCache(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    std::optional<uint64_t> capacity = reader.read<uint64_t>();
+    if (!identifier || !capacity)
+    {
+        LOG(ERROR) << "HandleWindowSetProxyCache called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleWindowSetProxyCache called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleWindowSetProxyCache client is null. Ignored.";
+        return;
+    }
+
+    pClient->GetProxyResponseCache().SetCapacity(static_cast<size_t>(*capacity));
+    LOG(INFO) << "Proxy response cache capacity set to " << *capacity << " bytes.";
+}
+
+void HandleWindowPurgeProxyCache(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleWindowPurgeProxyCache(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    std::optional<bool> prefix = reader.read<bool>();
+    std::optional<std::string> url = reader.readSizePrefixedString();
+    if (!identifier || !prefix || !url)
+    {
+        LOG(ERROR) << "HandleWindowPurgeProxyCache called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleWindowPurgeProxyCache called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleWindowPurgeProxyCache client is null. Ignored.";
+        return;
+    }
+
+    size_t removed = pClient->GetProxyResponseCache().Purge(*url, *prefix);
+    writer.write<uint32_t>(static_cast<uint32_t>(removed));
+    LOG(INFO) << "Purged " << removed << " proxy response cache entries for " << (*prefix ? "prefix " : "URL ") << *url;
+}
+
+void HandleWindowGetProxyCacheStats(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleWindowGetProxyCacheStats(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    if (!identifier)
+    {
+        LOG(ERROR) << "HandleWindowGetProxyCacheStats called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleWindowGetProxyCacheStats called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleWindowGetProxyCacheStats client is null. Ignored.";
+        return;
+    }
+
+    ProxyResponseCache::Stats stats = pClient->GetProxyResponseCache().GetStats();
+    writer.write<uint64_t>(stats.hits);
+    writer.write<uint64_t>(stats.misses);
+    writer.write<uint64_t>(stats.revalidations);
+    writer.write<uint64_t>(stats.notModified);
+    writer.write<uint64_t>(stats.stores);
+    writer.write<uint64_t>(stats.evictions);
+    writer.write<uint64_t>(stats.bytesServed);
+    writer.write<uint64_t>(stats.entries);
+    writer.write<uint64_t>(stats.bytes);
+    writer.write<uint64_t>(stats.capacity);
+}
+
+void HandleWindowMount(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleWindowMount(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    std::optional<std::string> urlPrefix = reader.readSizePrefixedString();
+    std::optional<std::string> path = reader.readSizePrefixedString();
+    if (!identifier || !urlPrefix || !path)
+    {
+        LOG(ERROR) << "HandleWindowMount called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleWindowMount called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleWindowMount client is null. Ignored.";
+        return;
+    }
+
+    bool mounted = pClient->GetMountTable().Add(*urlPrefix, MountTable::PathFromUtf8(*path));
+    writer.write<bool>(mounted);
+    if (mounted)
+        LOG(INFO) << "Mounted " << *path << " at " << *urlPrefix;
+    else
+        LOG(ERROR) << "Failed to mount " << *path << " at " << *urlPrefix << ", not a directory or asset pack.";
+}
+
+void HandleWindowUnmount(PacketReader& reader, PacketWriter& writer)
+{
+    if (!CefCurrentlyOn(TID_UI))
+    {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+
+        CefPostTask(TID_UI, base::BindOnce(
+                                [](std::promise<void> promise, PacketReader& reader, PacketWriter& writer)
+                                {
+                                    HandleWindowUnmount(reader, writer);
+                                    promise.set_value();
+                                },
+                                std::move(promise), std::ref(reader), std::ref(writer)));
+
+        future.wait();
+        return;
+    }
+
+    std::optional<int32_t> identifier = reader.read<int32_t>();
+    std::optional<std::string> urlPrefix = reader.readSizePrefixedString();
+    if (!identifier || !urlPrefix)
+    {
+        LOG(ERROR) << "HandleWindowUnmount called without valid data. Ignored.";
+        return;
+    }
+    CefRefPtr<CefBrowser> browser = ClientManager::GetInstance()->AcquirePointer(*identifier);
+    if (!browser)
+    {
+        LOG(ERROR) << "HandleWindowUnmount called while CefBrowser is already closed. Ignored.";
+        return;
+    }
+
+    CefRefPtr<CefClient> client = browser->GetHost()->GetClient();
+    Client* pClient = (Client*)client.get();
+    if (!pClient)
+    {
+        LOG(ERROR) << "HandleWindowUnmount client is null. Ignored.";
+        return;
+    }
+
+    bool removed = pClient->GetMountTable().Remove(*urlPrefix);
+    writer.write<bool>(removed);
+    LOG(INFO) << "Unmounted " << *urlPrefix << (removed ? "." : ", it was not mounted.");
+}
+
 void HandleAddUrlToModify(PacketReader& reader, PacketWriter& writer)
 {
     if (!CefCurrentlyOn(TID_UI))
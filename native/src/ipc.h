@@ -5,14 +5,20 @@
 #include "datastream.h"
 #include "include/cef_keyboard_handler.h"
 #include "include/cef_response.h"
+#include "outbound_scheduler.h"
 #include "packet_reader.h"
 #include "packet_writer.h"
+#include "pending_request_table.h"
 #include "pipe.h"
+#include "shm_transport.h"
+#include "stream_chunk_sizer.h"
+#include "serial_executor.h"
 #include "thread_pool.h"
-#include "work_queue.h"
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <optional>
 #include <queue>
@@ -25,13 +31,18 @@
 
 class Client;
 
+// Upper bound and default of the negotiated packet size. The controller may ask for less with
+// --ipc-max-packet-size, but never below MINIMUM_IPC_SIZE so the largest stream chunk still fits.
 #define MAXIMUM_IPC_SIZE 10 * 1024 * 1024
+#define MINIMUM_IPC_SIZE 1024 * 1024
 
 enum class PacketType : uint8_t
 {
     Request = 0,
     Response = 1,
-    Notification = 2
+    Notification = 2,
+    // Slice of a larger packet, see kLaneFragmentSize.
+    Fragment = 3
 };
 
 enum class StreamDataStatus : uint8_t
@@ -102,13 +113,25 @@ enum class OpcodeController : uint8_t
     WindowRemoveDomainToProxy = 55,
     WindowGetZoom = 56,
     WindowBridgeRpc = 57,
-    StreamEnd = 58
+    StreamEnd = 58,
+    WindowSetProxyCache = 59,           // int32 identifier, uint64 capacity in bytes, 0 turns it off
+    WindowPurgeProxyCache = 60,         // int32 identifier, bool prefix, string url -> uint32 removed
+    WindowGetProxyCacheStats = 61,      // int32 identifier -> ProxyResponseCache::Stats, see HandleWindowGetProxyCacheStats
+    WindowMount = 62,                   // int32 identifier, string urlPrefix, string path -> bool mounted
+    WindowUnmount = 63,                 // int32 identifier, string urlPrefix -> bool removed
+    WindowAddUrlPatternToProxy = 64,    // int32 identifier, uint8 UrlPatternKind, string pattern
+    WindowRemoveUrlPatternToProxy = 65, // int32 identifier, uint8 UrlPatternKind, string pattern
+    WindowSetRequestRewriteRules = 66,  // int32 identifier, rules, see ReadRequestRewriteRules
+    GetStreamMemoryStats = 67           // -> uint64 limit, uint64 current, uint64 peak
 };
 
 // Notifications from controller
 enum class OpcodeControllerNotification : uint8_t
 {
-    Exit = 0
+    Exit = 0,
+    TransportSwitch = 1,
+    StreamData = 2,
+    StreamCredit = 3
 };
 
 // Requests from client
@@ -147,17 +170,47 @@ enum class OpcodeClientNotification : uint8_t
     WindowFrameLoadEnd = 14,
     WindowFrameLoadError = 15,
     WindowDevToolsEvent = 16,
-    WindowLoadingStateChanged = 17
+    WindowLoadingStateChanged = 17,
+    TransportSwitch = 18,
+    StreamData = 19,
+    StreamCredit = 20
 };
 
+// Stream data travels as StreamData notifications (uint32 streamId, bytes). A sender may have at most
+// kStreamInitialCredit bytes unacknowledged; the receiver hands consumed bytes back with StreamCredit
+// notifications (uint32 streamId, uint32 credit, uint8 StreamDataStatus) once at least kStreamCreditThreshold
+// bytes were read, or immediately with credit 0 and Canceled/Closed when the stream is gone.
+// Keep in sync with cpp/Packet.h.
+constexpr size_t kStreamInitialCredit = 1024 * 1024;
+constexpr size_t kStreamCreditThreshold = 256 * 1024;
+
+// Protocol extensions the controller understands, passed as a bit set with --ipc-capabilities. A controller that
+// passes none (the C# one) gets the original protocol: without kControllerCapabilityStreamCredit uploads go as one
+// StreamData request per chunk, each waiting for its reply, and no StreamCredit notifications are sent. Without
+// kControllerCapabilityFragments packets are never split into Fragment frames.
+// Keep in sync with cpp/Packet.h.
+constexpr uint32_t kControllerCapabilityStreamCredit = 0x01;
+constexpr uint32_t kControllerCapabilityFragments = 0x02;
+// Reported back in Ready with the same bits: the extensions this runtime accepts from the controller.
+constexpr uint32_t kRuntimeCapabilities = kControllerCapabilityStreamCredit | kControllerCapabilityFragments;
+
+// Outbound traffic runs on two lanes that share the transport: the bulk lane carries StreamOpen/StreamData/StreamEnd/
+// StreamClose, the control lane everything else whatever its size, so calls and notifications keep their order.
+// Each lane has its own writer and keeps its own order, there is no order between lanes. When the controller
+// supports it, a packet larger than kLaneFragmentSize is written as Fragment frames, each carrying the next slice of
+// the serialized packet (header included), so the other lane never waits behind more than one slice. The frame
+// request id names the lane the packet belongs to, one packet per lane is fragmented at a time and kFragmentLast in
+// the frame opcode marks its final slice. Keep in sync with cpp/Packet.h.
+constexpr size_t kLaneFragmentSize = 128 * 1024;
+constexpr uint8_t kFragmentLast = 0x01;
+
+// Receives the response body, or std::nullopt when the request was dropped or IPC stopped before a reply.
+typedef std::function<void(std::optional<std::vector<uint8_t>> response)> IPCCallCallback;
+
 typedef struct _IPCPendingRequest
 {
-    OpcodeClient opcode;
-    uint32_t requestId;
-    bool ready;
-    std::mutex mutex;
-    std::condition_variable conditionVariable;
-    std::vector<uint8_t> responseBody;
+    OpcodeClient opcode = OpcodeClient::Ping;
+    IPCCallCallback onComplete;
 } IPCPendingRequest;
 
 #ifdef _WIN32
@@ -179,6 +232,16 @@ typedef struct PACKED _IPCPacketHeader
 #pragma pack(pop)
 #endif
 
+inline IPCPacketHeader MakePacketHeader(PacketType packetType, uint8_t opcode, uint32_t requestId, size_t bodySize)
+{
+    IPCPacketHeader header;
+    header.size = (uint32_t)(sizeof(IPCPacketHeader) + bodySize - sizeof(uint32_t));
+    header.requestId = requestId;
+    header.packetType = packetType;
+    header.opcode = opcode;
+    return header;
+}
+
 typedef struct _IPCDevToolsMethodResult
 {
     int32_t messageId = 0;
@@ -241,11 +304,35 @@ public:
     void SetHandles(HANDLE readHandle, HANDLE writeHandle);
 #else
     void SetHandles(int readFd, int writeFd);
+    bool AttachSharedMemoryTransport(int shmFd, int livenessReadFd);
 #endif
 
     bool HasValidHandles();
     bool IsAvailable();
 
+    // Received payload bytes that had to be copied after the initial read from the transport.
+    uint64_t ReceivedBytesCopied() const { return _receivedBytesCopied.load(); }
+    BufferPool::Stats BufferPoolStats() const { return _ipcBufferPool.GetStats(); }
+    StreamMemoryBudget::Stats StreamMemoryStats() const { return StreamMemoryBudget::Global().GetStats(); }
+    ThreadPool::Stats ThreadPoolStats() const { return _threadPool.GetStats(); }
+
+    struct OutboundStats
+    {
+        // Bytes queued for the writers, indexed by OutboundClass.
+        size_t pendingBytes[kOutboundClassCount] = {};
+        size_t pendingPackets = 0;
+    };
+    OutboundStats OutboundQueueStats();
+
+    // Limits passed by the controller, clamped to [MINIMUM_IPC_SIZE, MAXIMUM_IPC_SIZE]. Must be called before Start.
+    // Payloads above the inline threshold are streamed even when they would fit a packet.
+    void SetTransportLimits(size_t maxPacketSize, size_t inlineThreshold);
+    size_t MaxPacketSize() const { return _maxPacketSize; }
+    size_t InlineThreshold() const { return _inlineThreshold; }
+    // Must be called before Start, see kControllerCapabilityStreamCredit.
+    void SetControllerCapabilities(uint32_t capabilities);
+    bool HasControllerCapability(uint32_t capability) const { return (_controllerCapabilities & capability) != 0; }
+
     void Start();
     void Stop();
 
@@ -253,14 +340,21 @@ public:
     void Ping();
     void Print(const char* message, size_t size);
     void Print(const std::string& message);
-    void StreamCancel(uint32_t identifier) { Call(OpcodeClient::StreamCancel, (uint8_t*)&identifier, sizeof(uint32_t)); }
+    void StreamCancel(uint32_t identifier);
+
+    // The *Async variants return immediately and run onComplete on the thread pool once the controller replied,
+    // so no thread is parked per in-flight request. The blocking variants wait on the async ones.
     void WindowModifyRequest(int32_t identifier, CefRefPtr<CefRequest> request, bool modifyRequestBody);
+    void WindowModifyRequestAsync(int32_t identifier, CefRefPtr<CefRequest> request, bool modifyRequestBody, std::function<void()> onComplete);
     std::unique_ptr<IPCProxyResponse> WindowProxyRequest(int32_t identifier, CefRefPtr<CefRequest> request);
+    void WindowProxyRequestAsync(int32_t identifier, CefRefPtr<CefRequest> request, std::function<void(std::unique_ptr<IPCProxyResponse> response)> onComplete);
     IPCBridgeRpcResult WindowBridgeRpc(int32_t identifier, const std::string& method, const std::string& payload_json);
+    void WindowBridgeRpcAsync(int32_t identifier, const std::string& method, const std::string& payload_json, std::function<void(IPCBridgeRpcResult result)> onComplete);
     void QueueWindowBridgeRpcResponse(uint32_t requestId, bool success, const std::string& payload);
 
     void NotifyExit() { Notify(OpcodeClientNotification::Exit); }
-    void NotifyReady() { Notify(OpcodeClientNotification::Ready); }
+    // Carries the accepted packet size and inline threshold, see SetTransportLimits.
+    void NotifyReady();
 
     void NotifyWindowOpened(CefRefPtr<CefBrowser> browser);
     void NotifyWindowClosed(CefRefPtr<CefBrowser> browser);
@@ -278,15 +372,27 @@ public:
     void NotifyWindowFrameLoadError(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, cef_errorcode_t errorCode, const CefString& errorText, const CefString& url);
     void NotifyWindowLoadingStateChanged(CefRefPtr<CefBrowser> browser, bool isLoading, bool canGoBack, bool canGoForward);
     void NotifyWindowDevToolsEvent(CefRefPtr<CefBrowser> browser, const CefString& method, const uint8_t* result, size_t result_size);
-    void QueueResponse(OpcodeController opcode, uint32_t requestId, const PacketWriter& writer, std::function<void()> afterWrite = nullptr,
+    // Queues a response on the writer thread. afterWrite/onAbort run on the thread pool once the packet was written
+    // or dropped.
+    void QueueResponse(OpcodeController opcode, uint32_t requestId, PacketWriter writer, std::function<void()> afterWrite = nullptr,
                        std::function<void()> onAbort = nullptr);
 
+    // Process-wide notifications, they keep their order among themselves.
     void QueueWork(std::function<void()> work)
     {
         if (!IsAvailable())
             return;
 
-        _worker.EnqueueWork(std::move(work));
+        _windowExecutors.Post(kProcessWorkKey, std::move(work));
+    }
+
+    // Notifications of one browser keep their order, different browsers proceed in parallel on the thread pool.
+    void QueueWindowWork(int browserIdentifier, std::function<void()> work)
+    {
+        if (!IsAvailable())
+            return;
+
+        _windowExecutors.Post(browserIdentifier, std::move(work));
     }
 
     bool QueueBackgroundWork(std::function<void()> work)
@@ -301,40 +407,143 @@ public:
     void ReleaseIncomingStream(uint32_t identifier);
 
 private:
-    struct IncomingStreamDispatcher
+    // CEF browser identifiers start at 1.
+    static constexpr int kProcessWorkKey = 0;
+
+    struct OutboundPacket
     {
+        IPCPacketHeader header;
+        // Owned body bytes, written first.
+        std::vector<uint8_t> storage;
+        // Borrowed body segments, only used by callers that wait for afterWrite/onAbort before returning.
+        std::vector<IOSegment> body;
+        // Keeps borrowed body segments alive for callers that do not wait.
+        std::shared_ptr<const void> keepAlive;
+        std::function<void()> afterWrite;
+        std::function<void()> onAbort;
+    };
+
+    struct ClientStreamUpload
+    {
+        uint32_t identifier = 0;
+        std::shared_ptr<std::atomic<bool>> cancelFlag;
+        // Owns the bytes behind data.
+        std::shared_ptr<const void> owner;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        // Guards offset, credit, finished and the chunk sizing, and keeps a single thread sending chunks.
         std::mutex mutex;
-        std::queue<std::function<void()>> queue;
-        bool running = false;
+        size_t offset = 0;
+        size_t credit = kStreamInitialCredit;
+        bool finished = false;
+        // Chunk sizes follow the rate at which the controller hands credit back.
+        StreamChunkSizer chunkSizer;
+        std::chrono::steady_clock::time_point lastCreditAt;
+    };
+
+    static constexpr size_t kMaxCoalescedPackets = 64;
+    static constexpr size_t kMaxCoalescedBytes = 256 * 1024;
+
+    enum class Lane : size_t
+    {
+        Control = 0,
+        Bulk = 1
+    };
+    static constexpr size_t kLaneCount = 2;
+
+    struct OutboundLane
+    {
+        std::condition_variable condition;
+        OutboundScheduler<OutboundPacket> queue;
+        std::thread thread;
+    };
+
+    // Packet being received, its body is read straight into the final owner. destination is null while the body
+    // is discarded because it is too large for the buffer pool.
+    struct InboundPacket
+    {
+        IPCPacketHeader header;
+        size_t bodySize = 0;
+        size_t received = 0;
+        std::vector<uint8_t> responseBody;
+        std::shared_ptr<std::vector<uint8_t>> readBuffer;
+        uint8_t* destination = nullptr;
+        bool active = false;
+    };
+
+    struct IncomingStreamCredit
+    {
+        uint32_t identifier = 0;
+        std::atomic<size_t> unacknowledged = 0;
+        // Set while a retry waits on the stream memory budget.
+        std::atomic<bool> deferred = false;
     };
 
     struct PendingStreamReply
     {
         uint32_t requestId = 0;
         uint8_t opcode = 0;
-        std::vector<uint8_t> buf;
+        // Keeps data alive, either the received packet buffer or a copy of the unwritten part.
+        std::shared_ptr<const std::vector<uint8_t>> owner;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
         size_t written = 0;
         uint32_t streamId = 0;
     };
 
     void Run();
-    std::vector<uint8_t> Call(OpcodeClient opcode, const uint8_t* body = nullptr, size_t size = 0, std::function<void()> afterWrite = nullptr);
+    bool BeginInboundPacket(const IPCPacketHeader& header, InboundPacket& packet);
+    bool ReadInboundBody(InboundPacket& packet, size_t size);
+    bool DispatchPacket(InboundPacket& packet);
+    void RunWriter(Lane lane);
+    bool WriteFragmented(Lane lane, const OutboundPacket& packet, std::vector<IOSegment>& segments);
+    void AbortOutbound(std::vector<OutboundPacket>& batch);
+    // Runs an afterWrite/onAbort callback on the thread pool, inline once the pool stopped.
+    void PostPacketCallback(std::function<void()> callback);
+    static Lane LaneFor(const IPCPacketHeader& header);
+    static OutboundClass ClassFor(const OutboundPacket& packet, uint32_t& streamId);
+    void AcquireTransport(Lane lane);
+    void ReleaseTransport();
+    static size_t AppendPacketSegments(const OutboundPacket& packet, std::vector<IOSegment>& segments);
+    void EnqueuePacket(OutboundPacket packet);
+    size_t ReadTransport(void* buffer, size_t size);
+    size_t WriteTransport(const void* buffer, size_t size);
+    size_t WriteTransportV(const IOSegment* segments, size_t count);
+    std::vector<uint8_t> Call(OpcodeClient opcode, const uint8_t* body = nullptr, size_t size = 0);
+    std::vector<uint8_t> Call(OpcodeClient opcode, const IOSegment* bodySegments, size_t bodySegmentCount);
+    // afterWrite runs on the thread pool once the request was written. onComplete runs exactly once, on the thread pool.
+    void CallAsync(OpcodeClient opcode, PacketWriter writer, IPCCallCallback onComplete, std::function<void()> afterWrite = nullptr);
+    // Borrowed segments must stay valid until onComplete runs, keepAlive is held until the packet is written or dropped.
+    void CallAsync(OpcodeClient opcode, const IOSegment* bodySegments, size_t bodySegmentCount, std::shared_ptr<const void> keepAlive, IPCCallCallback onComplete,
+                   std::function<void()> afterWrite = nullptr);
+    void CallAsync(OpcodeClient opcode, OutboundPacket packet, IPCCallCallback onComplete);
+    void CompletePendingRequest(IPCPendingRequest pendingRequest, std::optional<std::vector<uint8_t>> response);
     void Notify(OpcodeClientNotification opcode, const uint8_t* body = nullptr, size_t size = 0, std::function<void()> afterWrite = nullptr,
                 std::function<void()> onAbort = nullptr);
-    void Notify(OpcodeClientNotification opcode, const PacketWriter& writer, std::function<void()> afterWrite = nullptr, std::function<void()> onAbort = nullptr);
+    void Notify(OpcodeClientNotification opcode, PacketWriter writer, std::function<void()> afterWrite = nullptr, std::function<void()> onAbort = nullptr);
+    // Borrowed segments must stay valid while keepAlive is held, it is released once the packet is written or dropped.
+    void Notify(OpcodeClientNotification opcode, const IOSegment* bodySegments, size_t bodySegmentCount, std::shared_ptr<const void> keepAlive);
     bool HandleRequest(uint32_t requestId, OpcodeController opcode, PacketReader& reader, PacketWriter& writer);
     void HandleNotification(OpcodeControllerNotification opcode, PacketReader& reader);
-    void WriteResponse(uint32_t requestId, uint8_t opcode, const uint8_t* body, size_t size);
-    void WriteQueuedResponsePacket(const uint8_t* packet, size_t packetLength);
+    // Borrows bodySegments, keepAlive keeps them valid until the write, same as the CallAsync overload.
+    void WriteResponse(uint32_t requestId, uint8_t opcode, const IOSegment* bodySegments, size_t bodySegmentCount, std::shared_ptr<const void> keepAlive);
+    void WriteResponse(uint32_t requestId, uint8_t opcode, PacketWriter writer);
     bool QueueIncomingStreamWork(uint32_t identifier, std::function<void()> work);
-    void ProcessIncomingStreamDispatcher(uint32_t identifier, std::shared_ptr<IncomingStreamDispatcher> dispatcher);
     std::shared_ptr<DataStream> FindIncomingStream(uint32_t identifier);
-    std::shared_ptr<DataStream> GetOrCreateIncomingStream(uint32_t identifier);
+    std::shared_ptr<DataStream> GetOrCreateIncomingStream(uint32_t identifier, DataStreamKind kind = DataStreamKind::Generic);
     void ResumePendingStreamReply(uint32_t streamId);
     void QueueDeferredStreamWriters(std::vector<std::function<void()>> streamWriters);
-    bool OpenClientStream(uint32_t identifier);
-    bool StreamClientData(uint32_t identifier, const uint8_t* data, size_t size);
-    void CloseClientStream(uint32_t identifier);
+    // Sends StreamOpen, then the data as StreamData notifications while credit lasts and StreamClose at the end.
+    // Controllers without kControllerCapabilityStreamCredit get StreamData requests instead, see
+    // ContinueClientStreamUpload.
+    void StartClientStreamUpload(uint32_t identifier, std::shared_ptr<std::atomic<bool>> cancelFlag, std::shared_ptr<const void> owner, const uint8_t* data, size_t size);
+    void PumpClientStreamUpload(std::shared_ptr<ClientStreamUpload> upload);
+    void ContinueClientStreamUpload(std::shared_ptr<ClientStreamUpload> upload);
+    void FinishClientStreamUpload(std::shared_ptr<ClientStreamUpload> upload);
+    void HandleStreamCredit(uint32_t identifier, size_t credit, StreamDataStatus status);
+    void HandleStreamDataNotification(PacketReader& reader);
+    void ReturnStreamCredit(std::shared_ptr<IncomingStreamCredit> credit, size_t consumed, bool drained);
+    void SendStreamCredit(uint32_t identifier, size_t credit, StreamDataStatus status);
     std::shared_ptr<std::atomic<bool>> RegisterOutgoingStream(uint32_t identifier);
     std::shared_ptr<std::atomic<bool>> GetOutgoingStreamCancelFlag(uint32_t identifier);
     void RemoveOutgoingStream(uint32_t identifier);
@@ -343,36 +552,51 @@ private:
     bool SerializeBinaryPayload(PacketWriter& writer, const uint8_t* payload, size_t size, std::vector<std::function<void()>>& streamWriters,
                                 std::function<void()>* onAbort = nullptr);
     bool DeserializeBridgeRpcPayload(PacketReader& reader, std::string& payload);
+    std::unique_ptr<IPCProxyResponse> ParseProxyResponse(const std::vector<uint8_t>& response);
+    void ApplyModifyResponse(CefRefPtr<CefRequest> request, bool modifyRequestBody, const std::vector<uint8_t>& response);
+    IPCBridgeRpcResult ParseBridgeRpcResponse(const std::optional<std::vector<uint8_t>>& response);
     bool HandleWindowBridgeRpcRequest(uint32_t requestId, PacketReader& reader, PacketWriter& writer);
     bool HandleWindowExecuteDevToolsMethodRequest(uint32_t requestId, PacketReader& reader, PacketWriter& writer);
 
-    std::atomic<uint32_t> _requestIdCounter;
     std::atomic<uint32_t> _streamIdentifierCounter;
+    std::atomic<uint64_t> _receivedBytesCopied = 0;
 
     std::atomic<bool> _stopped = true;
     std::atomic<bool> _startCalled = false;
-    std::mutex _writeMutex;
-    std::mutex _requestMapMutex;
+    std::mutex _outboundMutex;
+    OutboundLane _outboundLanes[kLaneCount];
+    bool _writerStopping = false;
+    // Taken for one frame or batch, so the lane writers interleave whole frames on the transport. A waiting control
+    // writer goes before the bulk writer.
+    std::mutex _transportMutex;
+    std::condition_variable _transportCondition;
+    bool _transportBusy = false;
+    size_t _transportControlWaiters = 0;
     std::mutex _dataStreamsMutex;
-    std::mutex _incomingStreamDispatchersMutex;
     std::mutex _outgoingStreamsMutex;
-    std::vector<uint8_t> _sendBuffer;
     std::vector<uint8_t> _readBuffer;
-    std::unordered_map<uint32_t, std::shared_ptr<IPCPendingRequest>> _pendingRequests;
+    PendingRequestTable<IPCPendingRequest> _pendingRequests;
     std::map<uint32_t, std::shared_ptr<DataStream>> _dataStreams;
     std::mutex _pendingStreamRepliesMutex;
     std::unordered_map<uint32_t, PendingStreamReply> _pendingStreamReplies;
     std::unordered_set<uint32_t> _canceledIncomingStreams;
-    std::unordered_map<uint32_t, std::shared_ptr<IncomingStreamDispatcher>> _incomingStreamDispatchers;
     std::unordered_map<uint32_t, std::shared_ptr<std::atomic<bool>>> _outgoingStreams;
+    std::unordered_map<uint32_t, std::shared_ptr<ClientStreamUpload>> _clientStreamUploads;
     std::thread _thread;
 #if _WIN32
     DWORD _readThreadId = 0;
 #endif
-    WorkQueue _worker;
     ThreadPool _threadPool;
+    KeyedSerialExecutor<int> _windowExecutors{_threadPool};
+    KeyedSerialExecutor<uint32_t> _incomingStreamExecutors{_threadPool};
+    size_t _maxPacketSize = MAXIMUM_IPC_SIZE;
+    size_t _inlineThreshold = MAXIMUM_IPC_SIZE;
+    uint32_t _controllerCapabilities = 0;
     BufferPool _ipcBufferPool;
     Pipe _pipe;
+    ShmTransport _shm;
+    std::atomic<bool> _shmReadActive = false;
+    std::atomic<bool> _shmWriteActive = false;
     // Exit fullscreen
 };
 
@@ -406,6 +630,14 @@ void HandleAddUrlToProxy(PacketReader& reader, PacketWriter& writer);
 void HandleRemoveUrlToProxy(PacketReader& reader, PacketWriter& writer);
 void HandleAddDomainToProxy(PacketReader& reader, PacketWriter& writer);
 void HandleRemoveDomainToProxy(PacketReader& reader, PacketWriter& writer);
+void HandleAddUrlPatternToProxy(PacketReader& reader, PacketWriter& writer);
+void HandleRemoveUrlPatternToProxy(PacketReader& reader, PacketWriter& writer);
+void HandleWindowSetRequestRewriteRules(PacketReader& reader, PacketWriter& writer);
+void HandleWindowSetProxyCache(PacketReader& reader, PacketWriter& writer);
+void HandleWindowPurgeProxyCache(PacketReader& reader, PacketWriter& writer);
+void HandleWindowGetProxyCacheStats(PacketReader& reader, PacketWriter& writer);
+void HandleWindowMount(PacketReader& reader, PacketWriter& writer);
+void HandleWindowUnmount(PacketReader& reader, PacketWriter& writer);
 void HandleAddUrlToModify(PacketReader& reader, PacketWriter& writer);
 void HandleRemoveUrlToModify(PacketReader& reader, PacketWriter& writer);
 void HandleWindowGetSize(PacketReader& reader, PacketWriter& writer);
@@ -104,6 +104,12 @@ int main(int argc, char* argv[])
     {
         int readFd = -1;
         int writeFd = -1;
+        int shmFd = -1;
+        size_t maxPacketSize = MAXIMUM_IPC_SIZE;
+        size_t inlineThreshold = MAXIMUM_IPC_SIZE;
+        uint32_t capabilities = 0;
+        size_t streamCapacities[(size_t)DataStreamKind::Count] = {};
+        size_t streamMemoryLimit = 0;
 
         for (int i = 1; i < argc; i++)
         {
@@ -116,12 +122,57 @@ int main(int argc, char* argv[])
             {
                 writeFd = std::stoi(argv[++i]);
             }
+            else if (arg == "--ipc-shm" && i + 1 < argc)
+            {
+                shmFd = std::stoi(argv[++i]);
+            }
+            else if (arg == "--ipc-max-packet-size" && i + 1 < argc)
+            {
+                maxPacketSize = static_cast<size_t>(std::stoull(argv[++i]));
+            }
+            else if (arg == "--ipc-inline-threshold" && i + 1 < argc)
+            {
+                inlineThreshold = static_cast<size_t>(std::stoull(argv[++i]));
+            }
+            else if (arg == "--ipc-capabilities" && i + 1 < argc)
+            {
+                capabilities = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--ipc-proxy-response-stream-capacity" && i + 1 < argc)
+            {
+                streamCapacities[(size_t)DataStreamKind::ProxyResponseBody] = static_cast<size_t>(std::stoull(argv[++i]));
+            }
+            else if (arg == "--ipc-request-body-stream-capacity" && i + 1 < argc)
+            {
+                streamCapacities[(size_t)DataStreamKind::RequestBody] = static_cast<size_t>(std::stoull(argv[++i]));
+            }
+            else if (arg == "--ipc-bridge-payload-stream-capacity" && i + 1 < argc)
+            {
+                streamCapacities[(size_t)DataStreamKind::BridgePayload] = static_cast<size_t>(std::stoull(argv[++i]));
+            }
+            else if (arg == "--ipc-stream-memory-limit" && i + 1 < argc)
+            {
+                streamMemoryLimit = static_cast<size_t>(std::stoull(argv[++i]));
+            }
         }
 
         if (readFd != -1 && writeFd != -1)
         {
             IPC::Singleton.SetHandles(readFd, writeFd);
+            IPC::Singleton.SetTransportLimits(maxPacketSize, inlineThreshold);
+            IPC::Singleton.SetControllerCapabilities(capabilities);
+            for (size_t kind = 0; kind < (size_t)DataStreamKind::Count; kind++)
+                DataStream::SetKindMaxCapacity((DataStreamKind)kind, streamCapacities[kind]);
+            StreamMemoryBudget::Global().SetLimit(streamMemoryLimit);
             LOG(INFO) << "Set handles.";
+
+            if (shmFd != -1)
+            {
+                if (IPC::Singleton.AttachSharedMemoryTransport(shmFd, readFd))
+                    LOG(INFO) << "Using shared memory transport.";
+                else
+                    LOG(INFO) << "Shared memory transport rejected, using pipes.";
+            }
         }
         else
         {
@@ -153,6 +153,11 @@ int main(int argc, char* argv[]) {
         const bool headless = command_line->HasSwitch("headless");
         int readFd = -1;
         int writeFd = -1;
+        size_t maxPacketSize = MAXIMUM_IPC_SIZE;
+        size_t inlineThreshold = MAXIMUM_IPC_SIZE;
+        uint32_t capabilities = 0;
+        size_t streamCapacities[(size_t)DataStreamKind::Count] = {};
+        size_t streamMemoryLimit = 0;
 
         // Parse command-line arguments for IPC file descriptors.
         for (int i = 1; i < argc; i++) {
@@ -161,11 +166,30 @@ int main(int argc, char* argv[]) {
                 readFd = atoi(argv[++i]);
             } else if ([arg isEqualToString:@"--child-to-parent"] && i + 1 < argc) {
                 writeFd = atoi(argv[++i]);
+            } else if ([arg isEqualToString:@"--ipc-max-packet-size"] && i + 1 < argc) {
+                maxPacketSize = (size_t)strtoull(argv[++i], nullptr, 10);
+            } else if ([arg isEqualToString:@"--ipc-inline-threshold"] && i + 1 < argc) {
+                inlineThreshold = (size_t)strtoull(argv[++i], nullptr, 10);
+            } else if ([arg isEqualToString:@"--ipc-capabilities"] && i + 1 < argc) {
+                capabilities = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            } else if ([arg isEqualToString:@"--ipc-proxy-response-stream-capacity"] && i + 1 < argc) {
+                streamCapacities[(size_t)DataStreamKind::ProxyResponseBody] = (size_t)strtoull(argv[++i], nullptr, 10);
+            } else if ([arg isEqualToString:@"--ipc-request-body-stream-capacity"] && i + 1 < argc) {
+                streamCapacities[(size_t)DataStreamKind::RequestBody] = (size_t)strtoull(argv[++i], nullptr, 10);
+            } else if ([arg isEqualToString:@"--ipc-bridge-payload-stream-capacity"] && i + 1 < argc) {
+                streamCapacities[(size_t)DataStreamKind::BridgePayload] = (size_t)strtoull(argv[++i], nullptr, 10);
+            } else if ([arg isEqualToString:@"--ipc-stream-memory-limit"] && i + 1 < argc) {
+                streamMemoryLimit = (size_t)strtoull(argv[++i], nullptr, 10);
             }
         }
 
         if (readFd != -1 && writeFd != -1) {
             IPC::Singleton.SetHandles(readFd, writeFd);
+            IPC::Singleton.SetTransportLimits(maxPacketSize, inlineThreshold);
+            IPC::Singleton.SetControllerCapabilities(capabilities);
+            for (size_t kind = 0; kind < (size_t)DataStreamKind::Count; kind++)
+                DataStream::SetKindMaxCapacity((DataStreamKind)kind, streamCapacities[kind]);
+            StreamMemoryBudget::Global().SetLimit(streamMemoryLimit);
             printf("Set handles.\r\n");
         } else {
             printf("Missing handles.\r\n");
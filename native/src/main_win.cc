@@ -79,6 +79,11 @@ int RunMain(HINSTANCE hInstance, LPTSTR /*lpCmdLine*/, int /*nCmdShow*/, void* s
     {
         HANDLE readHandle = INVALID_HANDLE_VALUE;
         HANDLE writeHandle = INVALID_HANDLE_VALUE;
+        size_t maxPacketSize = MAXIMUM_IPC_SIZE;
+        size_t inlineThreshold = MAXIMUM_IPC_SIZE;
+        uint32_t capabilities = 0;
+        size_t streamCapacities[(size_t)DataStreamKind::Count] = {};
+        size_t streamMemoryLimit = 0;
 
         for (int i = 1; i < argc; i++)
         {
@@ -91,12 +96,45 @@ int RunMain(HINSTANCE hInstance, LPTSTR /*lpCmdLine*/, int /*nCmdShow*/, void* s
             {
                 writeHandle = reinterpret_cast<HANDLE>(_wcstoui64(argv[++i], nullptr, 10));
             }
+            else if (arg == L"--ipc-max-packet-size" && i + 1 < argc)
+            {
+                maxPacketSize = static_cast<size_t>(_wcstoui64(argv[++i], nullptr, 10));
+            }
+            else if (arg == L"--ipc-inline-threshold" && i + 1 < argc)
+            {
+                inlineThreshold = static_cast<size_t>(_wcstoui64(argv[++i], nullptr, 10));
+            }
+            else if (arg == L"--ipc-capabilities" && i + 1 < argc)
+            {
+                capabilities = static_cast<uint32_t>(wcstoul(argv[++i], nullptr, 10));
+            }
+            else if (arg == L"--ipc-proxy-response-stream-capacity" && i + 1 < argc)
+            {
+                streamCapacities[(size_t)DataStreamKind::ProxyResponseBody] = static_cast<size_t>(_wcstoui64(argv[++i], nullptr, 10));
+            }
+            else if (arg == L"--ipc-request-body-stream-capacity" && i + 1 < argc)
+            {
+                streamCapacities[(size_t)DataStreamKind::RequestBody] = static_cast<size_t>(_wcstoui64(argv[++i], nullptr, 10));
+            }
+            else if (arg == L"--ipc-bridge-payload-stream-capacity" && i + 1 < argc)
+            {
+                streamCapacities[(size_t)DataStreamKind::BridgePayload] = static_cast<size_t>(_wcstoui64(argv[++i], nullptr, 10));
+            }
+            else if (arg == L"--ipc-stream-memory-limit" && i + 1 < argc)
+            {
+                streamMemoryLimit = static_cast<size_t>(_wcstoui64(argv[++i], nullptr, 10));
+            }
             LOG(INFO) << "Argument " << i << ": " << std::string(arg.begin(), arg.end());
         }
 
         if (readHandle != INVALID_HANDLE_VALUE && writeHandle != INVALID_HANDLE_VALUE)
         {
             IPC::Singleton.SetHandles(readHandle, writeHandle);
+            IPC::Singleton.SetTransportLimits(maxPacketSize, inlineThreshold);
+            IPC::Singleton.SetControllerCapabilities(capabilities);
+            for (size_t kind = 0; kind < (size_t)DataStreamKind::Count; kind++)
+                DataStream::SetKindMaxCapacity((DataStreamKind)kind, streamCapacities[kind]);
+            StreamMemoryBudget::Global().SetLimit(streamMemoryLimit);
             LOG(INFO) << "Set handles.";
         }
         else
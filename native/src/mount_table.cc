@@ -0,0 +1,296 @@
+#include "mount_table.h"
+
+#include <algorithm>
+#include <cctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace
+{
+
+std::string StripQueryAndFragment(const std::string& url)
+{
+    const size_t pos = std::min(url.find('?'), url.find('#'));
+    return pos == std::string::npos ? url : url.substr(0, pos);
+}
+
+int HexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool PercentDecode(const std::string& value, std::string& decoded)
+{
+    decoded.clear();
+    decoded.reserve(value.size());
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        if (value[i] != '%')
+        {
+            decoded.push_back(value[i]);
+            continue;
+        }
+
+        if (i + 2 >= value.size())
+            return false;
+        const int high = HexValue(value[i + 1]);
+        const int low = HexValue(value[i + 2]);
+        if (high < 0 || low < 0)
+            return false;
+        decoded.push_back((char)(high * 16 + low));
+        i += 2;
+    }
+    return true;
+}
+
+bool ParseUnsigned(const std::string& value, uint64_t& out)
+{
+    if (value.empty() || value.size() > 19)
+        return false;
+
+    out = 0;
+    for (char c : value)
+    {
+        if (c < '0' || c > '9')
+            return false;
+        out = out * 10 + (uint64_t)(c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+bool MountTable::Add(const std::string& urlPrefix, const std::filesystem::path& root)
+{
+    std::error_code ec;
+    if (urlPrefix.empty())
+        return false;
+
+    Mount mount{NormalizePrefix(urlPrefix), std::filesystem::absolute(root, ec), nullptr};
+    if (ec)
+        return false;
+    if (!std::filesystem::is_directory(mount.root, ec))
+    {
+        mount.pack = AssetPack::Open(mount.root);
+        if (!mount.pack)
+            return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _mounts.erase(std::remove_if(_mounts.begin(), _mounts.end(), [&](const Mount& existing) { return existing.prefix == mount.prefix; }), _mounts.end());
+    _mounts.push_back(std::move(mount));
+    std::stable_sort(_mounts.begin(), _mounts.end(), [](const Mount& a, const Mount& b) { return a.prefix.size() > b.prefix.size(); });
+    _count = _mounts.size();
+    return true;
+}
+
+bool MountTable::Remove(const std::string& urlPrefix)
+{
+    const std::string prefix = NormalizePrefix(urlPrefix);
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto itr = std::find_if(_mounts.begin(), _mounts.end(), [&](const Mount& existing) { return existing.prefix == prefix; });
+    if (itr == _mounts.end())
+        return false;
+
+    _mounts.erase(itr);
+    _count = _mounts.size();
+    return true;
+}
+
+std::optional<MountTable::Resolution> MountTable::Resolve(const std::string& url) const
+{
+    if (Empty())
+        return std::nullopt;
+
+    const std::string path = StripQueryAndFragment(url);
+    std::filesystem::path root;
+    std::shared_ptr<AssetPack> pack;
+    std::string relative;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto itr = std::find_if(_mounts.begin(), _mounts.end(), [&](const Mount& mount) { return path.compare(0, mount.prefix.size(), mount.prefix) == 0; });
+        if (itr == _mounts.end())
+            return std::nullopt;
+
+        root = itr->root;
+        pack = itr->pack;
+        relative = path.substr(itr->prefix.size());
+    }
+
+    Resolution resolution;
+    std::string decoded;
+    if (!PercentDecode(relative, decoded))
+        return resolution;
+    if (decoded.empty() || decoded.back() == '/')
+        decoded += "index.html";
+    if (pack)
+        return ResolveInPack(std::move(pack), decoded);
+
+    // Every segment has to stay inside the root, so no parent references, separators or drive letters.
+    std::filesystem::path file = root;
+    size_t start = 0;
+    while (start <= decoded.size())
+    {
+        size_t slash = decoded.find('/', start);
+        if (slash == std::string::npos)
+            slash = decoded.size();
+
+        const std::string segment = decoded.substr(start, slash - start);
+        start = slash + 1;
+        if (segment.empty())
+            continue;
+        if (segment == "." || segment == ".." || segment.find_first_of(std::string("\\:\0", 3)) != std::string::npos)
+            return resolution;
+        file /= PathFromUtf8(segment);
+    }
+
+    std::error_code ec;
+    if (std::filesystem::is_directory(file, ec))
+        file /= "index.html";
+    if (!std::filesystem::is_regular_file(file, ec))
+        return resolution;
+
+    std::string extension = file.extension().string();
+    if (!extension.empty())
+    {
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        resolution.mimeType = MimeTypeForExtension(extension.substr(1));
+    }
+    resolution.file = std::move(file);
+    return resolution;
+}
+
+MountTable::Resolution MountTable::ResolveInPack(std::shared_ptr<AssetPack> pack, const std::string& path)
+{
+    // Pack paths are stored without a leading slash, same as relative below the root.
+    const size_t start = path.find_first_not_of('/');
+    const std::string relative = start == std::string::npos ? std::string() : path.substr(start);
+
+    Resolution resolution;
+    const AssetPackEntry* entry = pack->Find(relative);
+    if (!entry)
+        entry = pack->Find(relative + "/index.html");
+    if (!entry)
+        return resolution;
+
+    resolution.mimeType = std::string(pack->MimeType(*entry));
+    resolution.entry = entry;
+    resolution.pack = std::move(pack);
+    return resolution;
+}
+
+std::filesystem::path MountTable::PathFromUtf8(const std::string& value)
+{
+#ifdef _WIN32
+    if (value.empty())
+        return std::filesystem::path();
+
+    const int length = MultiByteToWideChar(CP_UTF8, 0, value.data(), (int)value.size(), nullptr, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, value.data(), (int)value.size(), wide.data(), length);
+    return std::filesystem::path(wide);
+#else
+    return std::filesystem::path(value);
+#endif
+}
+
+std::string MountTable::MimeTypeForExtension(const std::string& extension)
+{
+    // The types web bundles need most, CefGetMimeType covers the rest.
+    static const std::pair<const char*, const char*> kMimeTypes[] = {
+        {"html", "text/html"},
+        {"htm", "text/html"},
+        {"js", "text/javascript"},
+        {"mjs", "text/javascript"},
+        {"css", "text/css"},
+        {"json", "application/json"},
+        {"map", "application/json"},
+        {"wasm", "application/wasm"},
+        {"svg", "image/svg+xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"avif", "image/avif"},
+        {"ico", "image/x-icon"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},
+        {"otf", "font/otf"},
+        {"txt", "text/plain"},
+        {"xml", "application/xml"},
+        {"mp4", "video/mp4"},
+        {"webm", "video/webm"},
+        {"mp3", "audio/mpeg"},
+        {"ogg", "audio/ogg"},
+        {"wav", "audio/wav"},
+        {"pdf", "application/pdf"},
+    };
+
+    for (const auto& entry : kMimeTypes)
+    {
+        if (extension == entry.first)
+            return entry.second;
+    }
+    return std::string();
+}
+
+bool MountTable::ParseRange(const std::string& header, uint64_t size, uint64_t& start, uint64_t& end, bool& satisfiable)
+{
+    static const std::string kUnit = "bytes=";
+    if (header.size() <= kUnit.size() || header.compare(0, kUnit.size(), kUnit) != 0 || header.find(',') != std::string::npos)
+        return false;
+
+    const std::string spec = header.substr(kUnit.size());
+    const size_t dash = spec.find('-');
+    if (dash == std::string::npos)
+        return false;
+
+    satisfiable = true;
+    uint64_t first = 0;
+    uint64_t last = 0;
+    const std::string firstText = spec.substr(0, dash);
+    const std::string lastText = spec.substr(dash + 1);
+    if (firstText.empty())
+    {
+        // Suffix range, the last n bytes.
+        if (!ParseUnsigned(lastText, last))
+            return false;
+        if (last == 0 || size == 0)
+        {
+            satisfiable = false;
+            return true;
+        }
+        start = size > last ? size - last : 0;
+        end = size - 1;
+        return true;
+    }
+
+    if (!ParseUnsigned(firstText, first))
+        return false;
+    if (!lastText.empty() && (!ParseUnsigned(lastText, last) || last < first))
+        return false;
+    if (first >= size)
+    {
+        satisfiable = false;
+        return true;
+    }
+
+    start = first;
+    end = lastText.empty() ? size - 1 : std::min(last, size - 1);
+    return true;
+}
+
+std::string MountTable::NormalizePrefix(const std::string& urlPrefix)
+{
+    return !urlPrefix.empty() && urlPrefix.back() == '/' ? urlPrefix : urlPrefix + "/";
+}
@@ -0,0 +1,63 @@
+#ifndef MOUNT_TABLE_H
+#define MOUNT_TABLE_H
+
+#include "asset_pack.h"
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// URL prefixes a window serves straight from disk instead of going through the controller, see
+// Client::GetResourceHandler. A mount is backed by a directory or by an asset pack file. A mount is authoritative: a
+// URL under it that names no file is answered with 404. The longest matching prefix wins. Thread safe.
+class MountTable
+{
+public:
+    struct Resolution
+    {
+        // Empty when the URL does not name a regular file inside the mount.
+        std::filesystem::path file;
+        // Set instead of file when the mount is an asset pack, pack keeps entry alive.
+        std::shared_ptr<AssetPack> pack;
+        const AssetPackEntry* entry = nullptr;
+        // Empty when the extension is unknown, callers fall back to CefGetMimeType.
+        std::string mimeType;
+    };
+
+    // Prefixes are normalized to end with '/'. root is a directory or an asset pack, fails when it is neither.
+    bool Add(const std::string& urlPrefix, const std::filesystem::path& root);
+    bool Remove(const std::string& urlPrefix);
+    bool Empty() const { return _count.load() == 0; }
+
+    // nullopt when no mount covers url. Query and fragment are ignored, a directory maps to its index.html.
+    std::optional<Resolution> Resolve(const std::string& url) const;
+
+    static std::filesystem::path PathFromUtf8(const std::string& value);
+    // extension is lowercase and without the dot.
+    static std::string MimeTypeForExtension(const std::string& extension);
+    // Parses a single "bytes=" range against size. Returns false when there is no usable range and the whole file
+    // should be sent. satisfiable is false for a range that starts beyond the end, which is answered with 416.
+    static bool ParseRange(const std::string& header, uint64_t size, uint64_t& start, uint64_t& end, bool& satisfiable);
+
+private:
+    struct Mount
+    {
+        std::string prefix;
+        std::filesystem::path root;
+        std::shared_ptr<AssetPack> pack;
+    };
+
+    static std::string NormalizePrefix(const std::string& urlPrefix);
+    static Resolution ResolveInPack(std::shared_ptr<AssetPack> pack, const std::string& path);
+
+    mutable std::mutex _mutex;
+    // Longest prefix first.
+    std::vector<Mount> _mounts;
+    std::atomic<size_t> _count = 0;
+};
+
+#endif // MOUNT_TABLE_H
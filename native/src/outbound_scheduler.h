@@ -0,0 +1,153 @@
+#ifndef OUTBOUND_SCHEDULER_H
+#define OUTBOUND_SCHEDULER_H
+
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Priority classes of outbound packets, highest first.
+enum class OutboundClass : uint8_t
+{
+    // Replies the other side is blocked on.
+    Response = 0,
+    // Requests and notifications other than stream traffic.
+    Control = 1,
+    // StreamOpen/StreamData/StreamEnd/StreamClose and StreamData notifications.
+    Stream = 2
+};
+
+constexpr size_t kOutboundClassCount = 3;
+
+// Decides which queued packet goes out next. Responses go before control packets and control packets before stream
+// packets. Stream packets are queued per stream identifier and served by deficit round robin with kStreamQuantum
+// bytes per turn, so one large transfer cannot starve another. Order is kept within a class and, for streams, within
+// one identifier. Not thread safe, the owner locks around it.
+//
+// Keep in sync with cpp/OutboundScheduler.h.
+template <typename T> class OutboundScheduler
+{
+public:
+    static constexpr size_t kStreamQuantum = 64 * 1024;
+
+    void Push(OutboundClass outboundClass, uint32_t streamId, size_t bytes, T item)
+    {
+        _pendingBytes[(size_t)outboundClass] += bytes;
+        _size++;
+        if (outboundClass != OutboundClass::Stream)
+        {
+            _queues[(size_t)outboundClass].push_back(Entry{bytes, std::move(item)});
+            return;
+        }
+
+        StreamQueue& stream = _streams[streamId];
+        if (stream.entries.empty())
+            _activeStreams.push_back(streamId);
+        stream.entries.push_back(Entry{bytes, std::move(item)});
+    }
+
+    bool Empty() const { return _size == 0; }
+    size_t Size() const { return _size; }
+    size_t PendingBytes(OutboundClass outboundClass) const { return _pendingBytes[(size_t)outboundClass]; }
+
+    // The item Pop returns next. Must not be called when empty.
+    T& Front() { return SelectFront().item; }
+
+    T Pop()
+    {
+        for (size_t i = 0; i < (size_t)OutboundClass::Stream; i++)
+        {
+            if (_queues[i].empty())
+                continue;
+
+            Entry entry = std::move(_queues[i].front());
+            _queues[i].pop_front();
+            Account((OutboundClass)i, entry.bytes);
+            return std::move(entry.item);
+        }
+
+        SelectFront();
+        const uint32_t streamId = _activeStreams.front();
+        auto itr = _streams.find(streamId);
+        Entry entry = std::move(itr->second.entries.front());
+        itr->second.entries.pop_front();
+        itr->second.deficit -= entry.bytes;
+        if (itr->second.entries.empty())
+        {
+            // An idle stream does not keep its unused deficit.
+            _streams.erase(itr);
+            _activeStreams.pop_front();
+            _turnStarted = false;
+        }
+        Account(OutboundClass::Stream, entry.bytes);
+        return std::move(entry.item);
+    }
+
+    // Removes everything, highest class first.
+    std::vector<T> TakeAll()
+    {
+        std::vector<T> items;
+        items.reserve(_size);
+        while (!Empty())
+            items.push_back(Pop());
+        return items;
+    }
+
+private:
+    struct Entry
+    {
+        size_t bytes = 0;
+        T item;
+    };
+
+    struct StreamQueue
+    {
+        std::deque<Entry> entries;
+        size_t deficit = 0;
+    };
+
+    Entry& SelectFront()
+    {
+        for (size_t i = 0; i < (size_t)OutboundClass::Stream; i++)
+        {
+            if (!_queues[i].empty())
+                return _queues[i].front();
+        }
+
+        // The stream at the head of the rotation gets one quantum per turn and keeps the turn while its next packet
+        // fits, otherwise it moves to the back with what it has left.
+        for (;;)
+        {
+            const uint32_t streamId = _activeStreams.front();
+            StreamQueue& stream = _streams[streamId];
+            if (!_turnStarted)
+            {
+                stream.deficit += kStreamQuantum;
+                _turnStarted = true;
+            }
+            if (stream.entries.front().bytes <= stream.deficit)
+                return stream.entries.front();
+
+            _activeStreams.pop_front();
+            _activeStreams.push_back(streamId);
+            _turnStarted = false;
+        }
+    }
+
+    void Account(OutboundClass outboundClass, size_t bytes)
+    {
+        _pendingBytes[(size_t)outboundClass] -= bytes;
+        _size--;
+    }
+
+    std::deque<Entry> _queues[(size_t)OutboundClass::Stream];
+    std::unordered_map<uint32_t, StreamQueue> _streams;
+    std::deque<uint32_t> _activeStreams;
+    bool _turnStarted = false;
+    size_t _pendingBytes[kOutboundClassCount] = {};
+    size_t _size = 0;
+};
+
+#endif // OUTBOUND_SCHEDULER_H
@@ -4,13 +4,19 @@
 #include <cstdint>
 #include <cstring>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 class PacketReader
 {
 public:
     PacketReader(const uint8_t* data, size_t size) : _data(data), _size(size), _position(0) {}
+    PacketReader(const uint8_t* data, size_t size, std::shared_ptr<const std::vector<uint8_t>> owner)
+        : _data(data), _size(size), _position(0), _owner(std::move(owner))
+    {
+    }
 
     template <typename T> std::optional<T> read()
     {
@@ -90,10 +96,14 @@ public:
 
     size_t remainingSize() const { return _size - _position; }
 
+    // The refcounted buffer the packet was received into, if any. Holding it keeps bytes handed out by copyTo valid.
+    const std::shared_ptr<const std::vector<uint8_t>>& owner() const { return _owner; }
+
 private:
     const uint8_t* _data;
     size_t _size;
     size_t _position;
+    std::shared_ptr<const std::vector<uint8_t>> _owner;
 };
 
 #endif // PACKET_READER_H
@@ -2,6 +2,7 @@
 #define PACKET_WRITER_H
 
 #include <algorithm>
+#include <atomic>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -9,7 +10,11 @@
 class PacketWriter
 {
 public:
-    explicit PacketWriter(size_t maxSize = 10 * 1024 * 1024) : _maxSize(maxSize) { _buffer.reserve(std::min(_maxSize, static_cast<size_t>(512))); }
+    explicit PacketWriter(size_t maxSize = DefaultMaxSize()) : _maxSize(maxSize) { _buffer.reserve(std::min(_maxSize, static_cast<size_t>(512))); }
+
+    // Limit of writers created without an explicit one, follows the negotiated IPC packet size.
+    static size_t DefaultMaxSize() { return DefaultMaxSizeValue().load(std::memory_order_relaxed); }
+    static void SetDefaultMaxSize(size_t maxSize) { DefaultMaxSizeValue().store(maxSize, std::memory_order_relaxed); }
 
     template <typename T> bool write(const T& value)
     {
@@ -57,7 +62,15 @@ public:
 
     const uint8_t* data() const { return _buffer.data(); }
 
+    std::vector<uint8_t> release() { return std::move(_buffer); }
+
 private:
+    static std::atomic<size_t>& DefaultMaxSizeValue()
+    {
+        static std::atomic<size_t> value(10 * 1024 * 1024);
+        return value;
+    }
+
     std::vector<uint8_t> _buffer;
     size_t _maxSize;
 };
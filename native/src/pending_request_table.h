@@ -0,0 +1,171 @@
+#ifndef PENDING_REQUEST_TABLE_H
+#define PENDING_REQUEST_TABLE_H
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+// Fixed-capacity table of in-flight requests. The request id is the slot index in the low IndexBits and a per-slot
+// generation above it, so a late or duplicate response for a recycled slot is rejected without any lookup structure.
+// Slots move Free -> Pending (-> Flushed) -> Free with atomic transitions; free slots are kept on a tagged lock-free
+// stack. The payload is only touched by whoever owns the slot: the issuer before publishing it, the taker after
+// winning the transition out of Pending/Flushed.
+//
+// Keep in sync with cpp/PendingRequestTable.h.
+template <typename T, uint32_t IndexBits = 13> class PendingRequestTable
+{
+public:
+    static constexpr uint32_t kCapacity = 1u << IndexBits;
+
+    PendingRequestTable() : _slots(new Slot[kCapacity])
+    {
+        for (uint32_t i = 0; i < kCapacity; i++)
+            _slots[i].nextFree.store(i + 1 < kCapacity ? i + 2 : 0, std::memory_order_relaxed);
+        _freeHead.store(1, std::memory_order_relaxed);
+    }
+
+    PendingRequestTable(const PendingRequestTable&) = delete;
+    PendingRequestTable& operator=(const PendingRequestTable&) = delete;
+
+    // Moves payload in and returns its request id. When every slot is in use payload is left untouched and
+    // std::nullopt is returned. Ids are never 0.
+    std::optional<uint32_t> Insert(T&& payload)
+    {
+        std::optional<uint32_t> index = PopFree();
+        if (!index)
+            return std::nullopt;
+
+        Slot& slot = _slots[*index];
+        uint32_t generation = NextGeneration(StateGeneration(slot.state.load(std::memory_order_relaxed)));
+        slot.payload = std::move(payload);
+        slot.state.store(MakeState(generation, SlotState::Pending), std::memory_order_release);
+        return (generation << IndexBits) | *index;
+    }
+
+    // Marks a pending request as fully written to the transport. Returns false if it was already taken.
+    bool MarkFlushed(uint32_t requestId)
+    {
+        Slot& slot = _slots[requestId & kIndexMask];
+        uint32_t expected = MakeState(requestId >> IndexBits, SlotState::Pending);
+        return slot.state.compare_exchange_strong(expected, MakeState(requestId >> IndexBits, SlotState::Flushed), std::memory_order_acq_rel);
+    }
+
+    // Removes the request and hands its payload to the caller. Exactly one Take succeeds per Insert.
+    std::optional<T> Take(uint32_t requestId)
+    {
+        uint32_t index = requestId & kIndexMask;
+        uint32_t generation = requestId >> IndexBits;
+        Slot& slot = _slots[index];
+
+        uint32_t expected = MakeState(generation, SlotState::Pending);
+        if (!slot.state.compare_exchange_strong(expected, MakeState(generation, SlotState::Taking), std::memory_order_acq_rel))
+        {
+            expected = MakeState(generation, SlotState::Flushed);
+            if (!slot.state.compare_exchange_strong(expected, MakeState(generation, SlotState::Taking), std::memory_order_acq_rel))
+                return std::nullopt;
+        }
+
+        return Release(index, generation);
+    }
+
+    // Takes every request that is still outstanding. With flushedOnly, requests that have not been written yet stay.
+    template <typename F> void TakeAll(bool flushedOnly, F&& callback)
+    {
+        for (uint32_t index = 0; index < kCapacity; index++)
+        {
+            Slot& slot = _slots[index];
+            uint32_t state = slot.state.load(std::memory_order_acquire);
+            SlotState slotState = StateValue(state);
+            if (slotState != SlotState::Flushed && (flushedOnly || slotState != SlotState::Pending))
+                continue;
+
+            uint32_t generation = StateGeneration(state);
+            if (!slot.state.compare_exchange_strong(state, MakeState(generation, SlotState::Taking), std::memory_order_acq_rel))
+                continue;
+
+            callback(Release(index, generation));
+        }
+    }
+
+    size_t InFlight() const { return _inFlight.load(std::memory_order_relaxed); }
+
+private:
+    enum class SlotState : uint32_t
+    {
+        Free = 0,
+        Pending = 1,
+        Flushed = 2,
+        Taking = 3
+    };
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint32_t> state = 0;
+        std::atomic<uint32_t> nextFree = 0;
+        T payload{};
+    };
+
+    static constexpr uint32_t kIndexMask = kCapacity - 1;
+    static constexpr uint32_t kGenerationMask = (1u << (32 - IndexBits)) - 1;
+
+    static uint32_t MakeState(uint32_t generation, SlotState state) { return (generation << 2) | static_cast<uint32_t>(state); }
+    static uint32_t StateGeneration(uint32_t state) { return state >> 2; }
+    static SlotState StateValue(uint32_t state) { return static_cast<SlotState>(state & 3); }
+    static uint32_t NextGeneration(uint32_t generation)
+    {
+        generation = (generation + 1) & kGenerationMask;
+        return generation == 0 ? 1 : generation;
+    }
+
+    T Release(uint32_t index, uint32_t generation)
+    {
+        Slot& slot = _slots[index];
+        T payload = std::move(slot.payload);
+        slot.payload = T{};
+        slot.state.store(MakeState(generation, SlotState::Free), std::memory_order_release);
+        PushFree(index);
+        return payload;
+    }
+
+    // The head packs an ABA tag in the upper 32 bits and index + 1 in the lower 32 bits, 0 meaning empty.
+    std::optional<uint32_t> PopFree()
+    {
+        uint64_t head = _freeHead.load(std::memory_order_acquire);
+        while (true)
+        {
+            uint32_t top = static_cast<uint32_t>(head);
+            if (top == 0)
+                return std::nullopt;
+
+            uint32_t next = _slots[top - 1].nextFree.load(std::memory_order_relaxed);
+            uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+            if (_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                _inFlight.fetch_add(1, std::memory_order_relaxed);
+                return top - 1;
+            }
+        }
+    }
+
+    void PushFree(uint32_t index)
+    {
+        uint64_t head = _freeHead.load(std::memory_order_relaxed);
+        while (true)
+        {
+            _slots[index].nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            uint64_t newHead = ((head >> 32) + 1) << 32 | (index + 1);
+            if (_freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+        _inFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<uint64_t> _freeHead = 0;
+    std::atomic<size_t> _inFlight = 0;
+};
+
+#endif // PENDING_REQUEST_TABLE_H
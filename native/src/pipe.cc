@@ -7,9 +7,12 @@
 #include <stdint.h>
 #include <windows.h>
 #else
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
@@ -119,6 +122,65 @@ size_t Pipe::Write(const void* buffer, size_t size, bool writeFully)
 #endif
 }
 
+size_t Pipe::WriteV(const IOSegment* segments, size_t count)
+{
+#ifdef _WIN32
+    size_t totalBytesWritten = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (segments[i].size == 0)
+            continue;
+
+        size_t bytesWritten = Write(segments[i].data, segments[i].size, true);
+        totalBytesWritten += bytesWritten;
+        if (bytesWritten != segments[i].size)
+            break;
+    }
+    return totalBytesWritten;
+#else
+    struct iovec iov[IOV_MAX < 16 ? IOV_MAX : 16];
+    size_t totalBytesWritten = 0;
+    size_t index = 0;
+    size_t offset = 0;
+    while (index < count)
+    {
+        int iovCount = 0;
+        for (size_t i = index; i < count && iovCount < (int)(sizeof(iov) / sizeof(iov[0])); i++)
+        {
+            size_t skip = i == index ? offset : 0;
+            if (segments[i].size - skip == 0)
+                continue;
+
+            iov[iovCount].iov_base = (char*)segments[i].data + skip;
+            iov[iovCount].iov_len = segments[i].size - skip;
+            iovCount++;
+        }
+
+        if (iovCount == 0)
+            break;
+
+        ssize_t bytesWritten = writev(_writeFd, iov, iovCount);
+        if (bytesWritten < 0 && errno == EINTR)
+            continue;
+        if (bytesWritten <= 0)
+        { // Error or pipe closed
+            break;
+        }
+        totalBytesWritten += (size_t)bytesWritten;
+
+        size_t remaining = (size_t)bytesWritten;
+        while (index < count && remaining >= segments[index].size - offset)
+        {
+            remaining -= segments[index].size - offset;
+            offset = 0;
+            index++;
+        }
+        offset += remaining;
+    }
+    return totalBytesWritten;
+#endif
+}
+
 void Pipe::Close()
 {
     LOG(INFO) << "Pipe close.";
@@ -9,6 +9,13 @@
 
 #include "include/base/cef_logging.h"
 
+// One segment of a gathered write, e.g. a packet header followed by its body.
+struct IOSegment
+{
+    const void* data;
+    size_t size;
+};
+
 class Pipe
 {
 public:
@@ -40,6 +47,8 @@ public:
     bool HasValidHandles();
     size_t Read(void* buffer, size_t size, bool readFully = false);
     size_t Write(const void* buffer, size_t size, bool writeFully = false);
+    // Writes all segments back to back (writev on POSIX). Returns the total number of bytes written.
+    size_t WriteV(const IOSegment* segments, size_t count);
     void Close();
 
 private:
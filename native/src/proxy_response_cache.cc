@@ -0,0 +1,400 @@
+#include "proxy_response_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace
+{
+
+struct CacheDirectives
+{
+    bool noStore = false;
+    bool noCache = false;
+    std::optional<int64_t> maxAge;
+};
+
+std::string ToLower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return value;
+}
+
+std::string Trim(const std::string& value)
+{
+    size_t begin = 0;
+    size_t end = value.size();
+    while (begin < end && (value[begin] == ' ' || value[begin] == '\t'))
+        begin++;
+    while (end > begin && (value[end - 1] == ' ' || value[end - 1] == '\t'))
+        end--;
+    return value.substr(begin, end - begin);
+}
+
+bool EqualsIgnoreCase(const std::string& a, const std::string& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) { return std::tolower(x) == std::tolower(y); });
+}
+
+// All values of a header joined with ", ", as if it had been sent once.
+std::optional<std::string> FindHeader(const ProxyResponseCache::Headers& headers, const std::string& name)
+{
+    std::optional<std::string> result;
+    for (const auto& header : headers)
+    {
+        if (!EqualsIgnoreCase(header.first, name))
+            continue;
+
+        if (result)
+            *result += ", " + header.second;
+        else
+            result = header.second;
+    }
+    return result;
+}
+
+std::vector<std::string> SplitList(const std::string& value)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= value.size())
+    {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos)
+            comma = value.size();
+
+        std::string item = Trim(value.substr(start, comma - start));
+        if (!item.empty())
+            items.push_back(item);
+        start = comma + 1;
+    }
+    return items;
+}
+
+std::optional<int64_t> ParseSeconds(const std::string& value)
+{
+    if (value.empty() || !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c) != 0; }))
+        return std::nullopt;
+    return (int64_t)std::min<unsigned long long>(std::strtoull(value.c_str(), nullptr, 10), (unsigned long long)INT32_MAX);
+}
+
+CacheDirectives ParseCacheControl(const ProxyResponseCache::Headers& headers)
+{
+    CacheDirectives directives;
+    std::optional<std::string> cacheControl = FindHeader(headers, "Cache-Control");
+    if (!cacheControl)
+        return directives;
+
+    for (const std::string& item : SplitList(*cacheControl))
+    {
+        size_t equals = item.find('=');
+        std::string name = ToLower(Trim(item.substr(0, equals)));
+        std::string value = equals == std::string::npos ? std::string() : Trim(item.substr(equals + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            value = value.substr(1, value.size() - 2);
+
+        if (name == "no-store")
+            directives.noStore = true;
+        else if (name == "no-cache")
+            directives.noCache = true;
+        else if (name == "max-age")
+            directives.maxAge = ParseSeconds(value);
+    }
+    return directives;
+}
+
+bool ForcesRevalidation(const ProxyResponseCache::Headers& requestHeaders)
+{
+    CacheDirectives directives = ParseCacheControl(requestHeaders);
+    if (directives.noCache || (directives.maxAge && *directives.maxAge == 0))
+        return true;
+
+    std::optional<std::string> pragma = FindHeader(requestHeaders, "Pragma");
+    return pragma && ToLower(*pragma).find("no-cache") != std::string::npos;
+}
+
+bool IsStorableStatus(int32_t statusCode)
+{
+    switch (statusCode)
+    {
+    case 200:
+    case 203:
+    case 204:
+    case 301:
+    case 404:
+    case 410:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Validators and the time the response stops being fresh, from the (possibly merged) response headers.
+void ApplyFreshness(ProxyResponseCache::Entry& entry, ProxyResponseCache::Clock::time_point now)
+{
+    entry.etag = FindHeader(entry.headers, "ETag").value_or(std::string());
+    entry.lastModified = FindHeader(entry.headers, "Last-Modified").value_or(std::string());
+
+    CacheDirectives directives = ParseCacheControl(entry.headers);
+    int64_t lifetime = directives.noCache || !directives.maxAge ? 0 : *directives.maxAge;
+    std::optional<std::string> age = FindHeader(entry.headers, "Age");
+    if (age)
+    {
+        std::optional<int64_t> ageSeconds = ParseSeconds(Trim(*age));
+        if (ageSeconds)
+            lifetime -= *ageSeconds;
+    }
+    entry.freshUntil = now + std::chrono::seconds(std::max<int64_t>(lifetime, 0));
+}
+
+} // namespace
+
+void ProxyResponseCache::SetCapacity(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = maxBytes;
+    if (_capacity == 0)
+    {
+        _entries.clear();
+        _lru.clear();
+        _bytes = 0;
+        return;
+    }
+    EvictLocked();
+}
+
+bool ProxyResponseCache::Enabled() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity > 0;
+}
+
+size_t ProxyResponseCache::MaxEntrySize() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity / 4;
+}
+
+bool ProxyResponseCache::IsCacheableRequest(const std::string& method, const Headers& requestHeaders)
+{
+    if (method != "GET")
+        return false;
+
+    static const char* const kBypassHeaders[] = {"Range", "If-None-Match", "If-Modified-Since", "If-Match", "If-Unmodified-Since", "If-Range"};
+    for (const char* name : kBypassHeaders)
+    {
+        if (FindHeader(requestHeaders, name))
+            return false;
+    }
+    return !ParseCacheControl(requestHeaders).noStore;
+}
+
+bool ProxyResponseCache::IsStorable(const Headers& requestHeaders, int32_t statusCode, const Headers& responseHeaders, size_t bodySize) const
+{
+    if (!IsStorableStatus(statusCode) || bodySize > MaxEntrySize())
+        return false;
+    if (ParseCacheControl(requestHeaders).noStore)
+        return false;
+    if (FindHeader(responseHeaders, "Content-Range"))
+        return false;
+
+    std::optional<std::string> vary = FindHeader(responseHeaders, "Vary");
+    if (vary)
+    {
+        std::vector<std::string> names = SplitList(*vary);
+        if (std::find(names.begin(), names.end(), "*") != names.end())
+            return false;
+    }
+
+    CacheDirectives directives = ParseCacheControl(responseHeaders);
+    if (directives.noStore)
+        return false;
+
+    const bool hasValidator = FindHeader(responseHeaders, "ETag") || FindHeader(responseHeaders, "Last-Modified");
+    return hasValidator || (!directives.noCache && directives.maxAge && *directives.maxAge > 0);
+}
+
+ProxyResponseCache::LookupResult ProxyResponseCache::Lookup(const std::string& url, const Headers& requestHeaders, std::shared_ptr<const Entry>& entry)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_capacity == 0)
+        return LookupResult::Miss;
+
+    auto itr = _entries.find(url);
+    if (itr == _entries.end())
+    {
+        _stats.misses++;
+        return LookupResult::Miss;
+    }
+
+    const Entry& stored = *itr->second.entry;
+    for (const auto& varied : stored.vary)
+    {
+        if (FindHeader(requestHeaders, varied.first).value_or(std::string()) != varied.second)
+        {
+            _stats.misses++;
+            return LookupResult::Miss;
+        }
+    }
+
+    _lru.splice(_lru.begin(), _lru, itr->second.lru);
+    entry = itr->second.entry;
+    if (!ForcesRevalidation(requestHeaders) && Clock::now() < stored.freshUntil)
+    {
+        _stats.hits++;
+        return LookupResult::Fresh;
+    }
+
+    if (stored.etag.empty() && stored.lastModified.empty())
+    {
+        // Nothing to revalidate with, the entry is useless now.
+        entry = nullptr;
+        EraseLocked(itr);
+        _stats.misses++;
+        return LookupResult::Miss;
+    }
+
+    _stats.revalidations++;
+    return LookupResult::Stale;
+}
+
+void ProxyResponseCache::Store(const std::string& url, const Headers& requestHeaders, int32_t statusCode, const std::string& statusText,
+                               const std::optional<std::string>& mediaType, const Headers& responseHeaders, std::shared_ptr<const std::vector<uint8_t>> body)
+{
+    if (!IsStorable(requestHeaders, statusCode, responseHeaders, body ? body->size() : 0))
+        return;
+
+    auto entry = std::make_shared<Entry>();
+    entry->statusCode = statusCode;
+    entry->statusText = statusText;
+    entry->mediaType = mediaType;
+    entry->headers = responseHeaders;
+    entry->body = body ? std::move(body) : std::make_shared<const std::vector<uint8_t>>();
+    std::optional<std::string> vary = FindHeader(responseHeaders, "Vary");
+    if (vary)
+    {
+        for (const std::string& name : SplitList(*vary))
+            entry->vary.emplace_back(ToLower(name), FindHeader(requestHeaders, name).value_or(std::string()));
+    }
+    ApplyFreshness(*entry, Clock::now());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_capacity == 0)
+        return;
+
+    auto existing = _entries.find(url);
+    if (existing != _entries.end())
+        EraseLocked(existing);
+
+    _lru.push_front(url);
+    Slot& slot = _entries[url];
+    slot.entry = std::move(entry);
+    slot.bytes = EntryBytes(url, *slot.entry);
+    slot.lru = _lru.begin();
+    _bytes += slot.bytes;
+    _stats.stores++;
+    EvictLocked();
+}
+
+std::shared_ptr<const ProxyResponseCache::Entry> ProxyResponseCache::Refresh(const std::string& url, const Headers& notModifiedHeaders)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto itr = _entries.find(url);
+    if (itr == _entries.end())
+        return nullptr;
+
+    auto entry = std::make_shared<Entry>(*itr->second.entry);
+    for (const auto& header : notModifiedHeaders)
+    {
+        // A 304 describes the stored representation, its own framing does not apply.
+        if (EqualsIgnoreCase(header.first, "Content-Length"))
+            continue;
+
+        for (auto existing = entry->headers.begin(); existing != entry->headers.end();)
+        {
+            if (EqualsIgnoreCase(existing->first, header.first))
+                existing = entry->headers.erase(existing);
+            else
+                ++existing;
+        }
+    }
+    for (const auto& header : notModifiedHeaders)
+    {
+        if (!EqualsIgnoreCase(header.first, "Content-Length"))
+            entry->headers.insert(header);
+    }
+    ApplyFreshness(*entry, Clock::now());
+
+    _bytes -= itr->second.bytes;
+    itr->second.entry = entry;
+    itr->second.bytes = EntryBytes(url, *entry);
+    _bytes += itr->second.bytes;
+    _lru.splice(_lru.begin(), _lru, itr->second.lru);
+    _stats.notModified++;
+    EvictLocked();
+    return entry;
+}
+
+void ProxyResponseCache::RecordServed(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.bytesServed += bytes;
+}
+
+size_t ProxyResponseCache::Purge(const std::string& url, bool prefix)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!prefix)
+    {
+        auto itr = _entries.find(url);
+        if (itr == _entries.end())
+            return 0;
+        EraseLocked(itr);
+        return 1;
+    }
+
+    size_t removed = 0;
+    auto itr = _entries.lower_bound(url);
+    while (itr != _entries.end() && itr->first.compare(0, url.size(), url) == 0)
+    {
+        auto next = std::next(itr);
+        EraseLocked(itr);
+        itr = next;
+        removed++;
+    }
+    return removed;
+}
+
+ProxyResponseCache::Stats ProxyResponseCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats stats = _stats;
+    stats.entries = _entries.size();
+    stats.bytes = _bytes;
+    stats.capacity = _capacity;
+    return stats;
+}
+
+size_t ProxyResponseCache::EntryBytes(const std::string& url, const Entry& entry)
+{
+    size_t bytes = url.size() + entry.statusText.size() + (entry.body ? entry.body->size() : 0);
+    for (const auto& header : entry.headers)
+        bytes += header.first.size() + header.second.size();
+    return bytes;
+}
+
+void ProxyResponseCache::EraseLocked(std::map<std::string, Slot>::iterator itr)
+{
+    _bytes -= itr->second.bytes;
+    _lru.erase(itr->second.lru);
+    _entries.erase(itr);
+}
+
+void ProxyResponseCache::EvictLocked()
+{
+    while (_bytes > _capacity && !_lru.empty())
+    {
+        EraseLocked(_entries.find(_lru.back()));
+        _stats.evictions++;
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef PROXY_RESPONSE_CACHE_H
+#define PROXY_RESPONSE_CACHE_H
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Private, size-bounded HTTP cache for proxied responses, one per Client. Off until SetCapacity is called with a
+// non-zero size. Responses are stored following Cache-Control (no-store, no-cache, max-age), Age and Vary, and need
+// either a positive max-age or an ETag/Last-Modified validator. Fresh entries are served without a controller round
+// trip, stale ones are revalidated with If-None-Match/If-Modified-Since and a 304 refreshes them. Least recently
+// used entries are evicted first. Thread safe.
+class ProxyResponseCache
+{
+public:
+    typedef std::multimap<std::string, std::string> Headers;
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        int32_t statusCode = 0;
+        std::string statusText;
+        std::optional<std::string> mediaType;
+        Headers headers;
+        std::shared_ptr<const std::vector<uint8_t>> body;
+        std::string etag;
+        std::string lastModified;
+        // Lowercase request header names listed in Vary with the values the entry was stored for.
+        std::vector<std::pair<std::string, std::string>> vary;
+        Clock::time_point freshUntil;
+    };
+
+    enum class LookupResult
+    {
+        Miss,
+        Fresh,
+        // Present but has to be revalidated before use.
+        Stale
+    };
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t revalidations = 0;
+        uint64_t notModified = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+        uint64_t bytesServed = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t capacity = 0;
+    };
+
+    // Zero turns the cache off and drops every entry.
+    void SetCapacity(size_t maxBytes);
+    bool Enabled() const;
+    // A single entry may use at most a quarter of the capacity.
+    size_t MaxEntrySize() const;
+
+    // Only plain GET requests without Range or conditional headers take part. Request no-store bypasses the cache.
+    static bool IsCacheableRequest(const std::string& method, const Headers& requestHeaders);
+    // Whether a complete response with these headers may be stored for the request.
+    bool IsStorable(const Headers& requestHeaders, int32_t statusCode, const Headers& responseHeaders, size_t bodySize) const;
+
+    LookupResult Lookup(const std::string& url, const Headers& requestHeaders, std::shared_ptr<const Entry>& entry);
+    void Store(const std::string& url, const Headers& requestHeaders, int32_t statusCode, const std::string& statusText, const std::optional<std::string>& mediaType,
+               const Headers& responseHeaders, std::shared_ptr<const std::vector<uint8_t>> body);
+    // Applies the headers of a 304 to the stored entry and returns the refreshed entry, nullptr when it is gone.
+    std::shared_ptr<const Entry> Refresh(const std::string& url, const Headers& notModifiedHeaders);
+    void RecordServed(size_t bytes);
+
+    // Removes the entry for url, or with prefix every entry whose URL starts with it. Returns the number removed.
+    size_t Purge(const std::string& url, bool prefix);
+    Stats GetStats() const;
+
+private:
+    struct Slot
+    {
+        std::shared_ptr<const Entry> entry;
+        size_t bytes = 0;
+        std::list<std::string>::iterator lru;
+    };
+
+    static size_t EntryBytes(const std::string& url, const Entry& entry);
+    void EraseLocked(std::map<std::string, Slot>::iterator itr);
+    void EvictLocked();
+
+    mutable std::mutex _mutex;
+    size_t _capacity = 0;
+    size_t _bytes = 0;
+    std::map<std::string, Slot> _entries;
+    // Most recently used at the front.
+    std::list<std::string> _lru;
+    Stats _stats;
+};
+
+#endif // PROXY_RESPONSE_CACHE_H
@@ -0,0 +1,102 @@
+#include "request_rewriter.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+
+bool EqualsIgnoreCase(const std::string& a, const std::string& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) { return std::tolower(x) == std::tolower(y); });
+}
+
+void EraseHeader(RequestRewriter::Headers& headers, const std::string& name)
+{
+    for (auto itr = headers.begin(); itr != headers.end();)
+    {
+        if (EqualsIgnoreCase(itr->first, name))
+            itr = headers.erase(itr);
+        else
+            ++itr;
+    }
+}
+
+} // namespace
+
+bool RequestRewriteRule::Matches(const std::string& url, const std::string& requestMethod, int resourceType) const
+{
+    if (!method.empty() && !EqualsIgnoreCase(method, requestMethod))
+        return false;
+    if (resourceTypes != 0 && (resourceType < 0 || resourceType >= 32 || (resourceTypes & (1u << resourceType)) == 0))
+        return false;
+
+    switch (urlKind)
+    {
+    case UrlPatternKind::Exact:
+        return url == urlPattern;
+    case UrlPatternKind::Prefix:
+        return url.compare(0, urlPattern.size(), urlPattern) == 0;
+    case UrlPatternKind::Glob:
+        return UrlMatcher::GlobMatches(urlPattern.data(), urlPattern.size(), url.data(), url.size());
+    }
+    return false;
+}
+
+void RequestRewriter::SetRules(std::vector<RequestRewriteRule> rules)
+{
+    std::shared_ptr<const std::vector<RequestRewriteRule>> snapshot;
+    if (!rules.empty())
+        snapshot = std::make_shared<const std::vector<RequestRewriteRule>>(std::move(rules));
+    std::atomic_store(&_rules, std::move(snapshot));
+}
+
+bool RequestRewriter::Empty() const
+{
+    return !std::atomic_load(&_rules);
+}
+
+RequestRewriter::Result RequestRewriter::Evaluate(const std::string& url, const std::string& method, int resourceType, bool allowUrlRewrite) const
+{
+    Result result;
+    result.rules = std::atomic_load(&_rules);
+    if (!result.rules)
+        return result;
+
+    // Later rules see the URL earlier ones produced, so rewrites can be chained.
+    std::string current = url;
+    for (const RequestRewriteRule& rule : *result.rules)
+    {
+        if (!rule.Matches(current, method, resourceType))
+            continue;
+
+        if (rule.block)
+        {
+            result.block = true;
+            return result;
+        }
+
+        if (!rule.removeHeaders.empty() || !rule.setHeaders.empty())
+            result.headerRules.push_back(&rule);
+        if (allowUrlRewrite && !rule.rewriteUrl.empty())
+        {
+            current = rule.urlKind == UrlPatternKind::Prefix ? rule.rewriteUrl + current.substr(rule.urlPattern.size()) : rule.rewriteUrl;
+            result.url = current;
+        }
+    }
+    return result;
+}
+
+void RequestRewriter::EditHeaders(const Result& result, Headers& headers)
+{
+    for (const RequestRewriteRule* rule : result.headerRules)
+    {
+        for (const std::string& name : rule->removeHeaders)
+            EraseHeader(headers, name);
+        for (const auto& header : rule->setHeaders)
+        {
+            EraseHeader(headers, header.first);
+            headers.insert(header);
+        }
+    }
+}
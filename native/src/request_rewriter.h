@@ -0,0 +1,66 @@
+#ifndef REQUEST_REWRITER_H
+#define REQUEST_REWRITER_H
+
+#include "url_matcher.h"
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One declarative rule the controller pushes with WindowSetRequestRewriteRules. Keep in sync with RequestRewriteRule
+// in cpp/IpcTypes.h.
+struct RequestRewriteRule
+{
+    UrlPatternKind urlKind = UrlPatternKind::Prefix;
+    // An empty prefix matches every URL.
+    std::string urlPattern;
+    // Empty matches any method.
+    std::string method;
+    // Bit (1 << cef_resource_type_t) per accepted type, 0 matches any.
+    uint32_t resourceTypes = 0;
+
+    bool block = false;
+    // Empty keeps the URL. A prefix rule replaces only the matched prefix, the others the whole URL.
+    std::string rewriteUrl;
+    std::vector<std::pair<std::string, std::string>> setHeaders;
+    std::vector<std::string> removeHeaders;
+
+    bool Matches(const std::string& url, const std::string& requestMethod, int resourceType) const;
+};
+
+// Ordered rule list of a window, applied natively in Client::OnBeforeResourceLoad so common edits never cost a
+// WindowModifyRequest round trip. The list is replaced as a whole and readers hold on to the snapshot they got.
+// Readers load the current snapshot atomically without a lock. Thread safe.
+class RequestRewriter
+{
+public:
+    typedef std::multimap<std::string, std::string> Headers;
+
+    struct Result
+    {
+        bool block = false;
+        // Empty when no rule rewrote the URL.
+        std::string url;
+        // Matching rules that edit headers, in order. rules keeps them alive.
+        std::vector<const RequestRewriteRule*> headerRules;
+        std::shared_ptr<const std::vector<RequestRewriteRule>> rules;
+    };
+
+    void SetRules(std::vector<RequestRewriteRule> rules);
+    bool Empty() const;
+
+    // Evaluates every rule in order, a blocking rule stops evaluation. With allowUrlRewrite false URL rewrites are
+    // skipped, which keeps a redirected request from being rewritten again. Headers are only fetched by the caller
+    // when some rule edits them, see EditHeaders.
+    Result Evaluate(const std::string& url, const std::string& method, int resourceType, bool allowUrlRewrite) const;
+    static void EditHeaders(const Result& result, Headers& headers);
+
+private:
+    // Null when there are no rules, only accessed through std::atomic_load / std::atomic_store.
+    std::shared_ptr<const std::vector<RequestRewriteRule>> _rules;
+};
+
+#endif // REQUEST_REWRITER_H
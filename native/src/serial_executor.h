@@ -0,0 +1,174 @@
+#ifndef SERIAL_EXECUTOR_H
+#define SERIAL_EXECUTOR_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+#include "thread_pool.h"
+
+// Runs posted tasks one at a time and in order on a shared ThreadPool, without a thread of its own. Separate
+// executors run in parallel. After kMaxBatch tasks a busy executor goes back to the end of the pool queue so it
+// cannot hold a worker forever.
+class SerialExecutor : public std::enable_shared_from_this<SerialExecutor>
+{
+public:
+    static constexpr size_t kMaxBatch = 64;
+
+    SerialExecutor(ThreadPool& pool, std::function<void()> onIdle = nullptr) : _pool(pool), _onIdle(std::move(onIdle)) {}
+
+    // Returns false when the pool no longer accepts work, the task is dropped then.
+    bool Post(std::function<void()> task)
+    {
+        if (!Push(std::move(task)))
+            return true;
+        return Schedule();
+    }
+
+    // Drops queued tasks, a task that is already running finishes.
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::queue<std::function<void()>>().swap(_queue);
+    }
+
+    bool Idle() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return !_running && _queue.empty();
+    }
+
+private:
+    template <typename Key> friend class KeyedSerialExecutor;
+
+    // Queues task and returns true when the executor has to be scheduled.
+    bool Push(std::function<void()> task)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push(std::move(task));
+        if (_running)
+            return false;
+        _running = true;
+        return true;
+    }
+
+    bool Schedule()
+    {
+        std::shared_ptr<SerialExecutor> self = shared_from_this();
+        if (_pool.Enqueue([self] { self->Drain(); }))
+            return true;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::queue<std::function<void()>>().swap(_queue);
+            _running = false;
+        }
+        if (_onIdle)
+            _onIdle();
+        return false;
+    }
+
+    void Drain()
+    {
+        for (size_t i = 0; i < kMaxBatch; i++)
+        {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_queue.empty())
+                {
+                    _running = false;
+                    break;
+                }
+
+                task = std::move(_queue.front());
+                _queue.pop();
+            }
+
+            task();
+            if (i + 1 < kMaxBatch)
+                continue;
+
+            // The batch is used up and this drain still owns the executor.
+            bool more;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                more = !_queue.empty();
+                _running = more;
+            }
+            if (more)
+            {
+                Schedule();
+                return;
+            }
+        }
+
+        if (_onIdle)
+            _onIdle();
+    }
+
+    ThreadPool& _pool;
+    std::function<void()> _onIdle;
+    mutable std::mutex _mutex;
+    std::queue<std::function<void()>> _queue;
+    bool _running = false;
+};
+
+// One SerialExecutor per key, created on first use and dropped again once it runs out of work, so tasks for the
+// same key keep their order while different keys proceed in parallel.
+template <typename Key> class KeyedSerialExecutor
+{
+public:
+    explicit KeyedSerialExecutor(ThreadPool& pool) : _pool(pool) {}
+
+    bool Post(const Key& key, std::function<void()> task)
+    {
+        std::shared_ptr<SerialExecutor> executor;
+        {
+            // Queued under the map lock, so an executor that is found idle and removed never receives a task.
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::shared_ptr<SerialExecutor>& existing = _executors[key];
+            if (!existing)
+                existing = std::make_shared<SerialExecutor>(_pool, [this, key] { RemoveIfIdle(key); });
+            if (!existing->Push(std::move(task)))
+                return true;
+            executor = existing;
+        }
+        return executor->Schedule();
+    }
+
+    void Clear()
+    {
+        std::unordered_map<Key, std::shared_ptr<SerialExecutor>> executors;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            executors.swap(_executors);
+        }
+        for (auto& executor : executors)
+            executor.second->Clear();
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _executors.size();
+    }
+
+private:
+    void RemoveIfIdle(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto itr = _executors.find(key);
+        if (itr != _executors.end() && itr->second->Idle())
+            _executors.erase(itr);
+    }
+
+    ThreadPool& _pool;
+    mutable std::mutex _mutex;
+    std::unordered_map<Key, std::shared_ptr<SerialExecutor>> _executors;
+};
+
+#endif // SERIAL_EXECUTOR_H
@@ -0,0 +1,263 @@
+#include "shm_transport.h"
+
+#include <algorithm>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#ifdef __linux__
+// Waits are bounded so the liveness pipe gets polled even if the peer dies without waking us.
+constexpr long kWaitTimeoutNs = 200 * 1000 * 1000;
+
+int FutexWait(std::atomic<uint32_t>* address, uint32_t expected, const timespec* timeout)
+{
+    return static_cast<int>(syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAIT, expected, timeout, nullptr, 0));
+}
+
+void FutexWakeAll(std::atomic<uint32_t>* address)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+#endif
+
+} // namespace
+
+bool ShmTransport::Attach(int fd, int livenessReadFd)
+{
+#ifdef __linux__
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmTransportHeader))
+    {
+        LOG(ERROR) << "Shared memory transport region is invalid.";
+        close(fd);
+        return false;
+    }
+
+    size_t mappingSize = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        LOG(ERROR) << "Failed to map shared memory transport (errno = " << errno << ").";
+        return false;
+    }
+
+    ShmTransportHeader* header = static_cast<ShmTransportHeader*>(mapping);
+    size_t capacity = header->ringCapacity;
+    if (header->magic != SHM_TRANSPORT_MAGIC || header->version != SHM_TRANSPORT_VERSION || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        sizeof(ShmTransportHeader) + 2 * capacity > mappingSize)
+    {
+        LOG(ERROR) << "Shared memory transport header mismatch (magic = " << header->magic << ", version = " << header->version << ", capacity = " << capacity << ").";
+        munmap(mapping, mappingSize);
+        return false;
+    }
+
+    uint8_t* base = static_cast<uint8_t*>(mapping);
+    _header = header;
+    _mappingSize = mappingSize;
+    _capacity = capacity;
+    _readRing = base + sizeof(ShmTransportHeader);
+    _writeRing = base + sizeof(ShmTransportHeader) + capacity;
+    _readControl = &header->parentToChild;
+    _writeControl = &header->childToParent;
+    _livenessReadFd = livenessReadFd;
+
+    LOG(INFO) << "Attached shared memory transport (capacity = " << capacity << " bytes per direction).";
+    return true;
+#else
+    (void)fd;
+    (void)livenessReadFd;
+    return false;
+#endif
+}
+
+size_t ShmTransport::Read(void* buffer, size_t size, bool readFully)
+{
+    if (!_header)
+        return 0;
+
+    size_t totalBytesRead = 0;
+    while (totalBytesRead < size)
+    {
+        uint64_t readPosition = _readControl->readPosition.load(std::memory_order_relaxed);
+        uint64_t writePosition = _readControl->writePosition.load(std::memory_order_acquire);
+        size_t available = static_cast<size_t>(writePosition - readPosition);
+        if (available == 0)
+        {
+            if (_closed || _readControl->closed.load(std::memory_order_acquire))
+                break;
+
+            uint32_t sequence = _readControl->dataSequence.load(std::memory_order_acquire);
+            if (_readControl->writePosition.load(std::memory_order_acquire) != readPosition)
+                continue;
+
+            if (!WaitForChange(_readControl->dataSequence, sequence, _readControl->readerWaiting))
+                break;
+            continue;
+        }
+
+        size_t count = std::min(available, size - totalBytesRead);
+        size_t offset = static_cast<size_t>(readPosition & (_capacity - 1));
+        size_t firstPart = std::min(count, _capacity - offset);
+        memcpy((uint8_t*)buffer + totalBytesRead, _readRing + offset, firstPart);
+        if (count > firstPart)
+            memcpy((uint8_t*)buffer + totalBytesRead + firstPart, _readRing, count - firstPart);
+
+        _readControl->readPosition.store(readPosition + count, std::memory_order_release);
+        Wake(_readControl->spaceSequence, _readControl->writerWaiting);
+
+        totalBytesRead += count;
+        if (!readFully)
+            break;
+    }
+
+    return totalBytesRead;
+}
+
+size_t ShmTransport::Write(const void* buffer, size_t size, bool writeFully)
+{
+    if (!_header)
+        return 0;
+
+    size_t totalBytesWritten = 0;
+    while (totalBytesWritten < size)
+    {
+        if (_closed || _writeControl->closed.load(std::memory_order_acquire))
+            break;
+
+        uint64_t writePosition = _writeControl->writePosition.load(std::memory_order_relaxed);
+        uint64_t readPosition = _writeControl->readPosition.load(std::memory_order_acquire);
+        size_t space = _capacity - static_cast<size_t>(writePosition - readPosition);
+        if (space == 0)
+        {
+            uint32_t sequence = _writeControl->spaceSequence.load(std::memory_order_acquire);
+            if (_writeControl->readPosition.load(std::memory_order_acquire) != readPosition)
+                continue;
+
+            if (!WaitForChange(_writeControl->spaceSequence, sequence, _writeControl->writerWaiting))
+                break;
+            continue;
+        }
+
+        size_t count = std::min(space, size - totalBytesWritten);
+        size_t offset = static_cast<size_t>(writePosition & (_capacity - 1));
+        size_t firstPart = std::min(count, _capacity - offset);
+        memcpy(_writeRing + offset, (const uint8_t*)buffer + totalBytesWritten, firstPart);
+        if (count > firstPart)
+            memcpy(_writeRing, (const uint8_t*)buffer + totalBytesWritten + firstPart, count - firstPart);
+
+        _writeControl->writePosition.store(writePosition + count, std::memory_order_release);
+        Wake(_writeControl->dataSequence, _writeControl->readerWaiting);
+
+        totalBytesWritten += count;
+        if (!writeFully)
+            break;
+    }
+
+    return totalBytesWritten;
+}
+
+size_t ShmTransport::WriteV(const IOSegment* segments, size_t count)
+{
+    size_t totalBytesWritten = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t bytesWritten = Write(segments[i].data, segments[i].size, true);
+        totalBytesWritten += bytesWritten;
+        if (bytesWritten != segments[i].size)
+            break;
+    }
+    return totalBytesWritten;
+}
+
+void ShmTransport::Close()
+{
+    if (!_header || _closed.exchange(true))
+        return;
+
+    LOG(INFO) << "Shared memory transport close.";
+
+    // The mapping is intentionally kept alive, the reader thread may still be parked on it. Marking both
+    // rings closed makes the controller observe end-of-stream the same way a closed pipe would.
+    _header->parentToChild.closed.store(1, std::memory_order_release);
+    _header->childToParent.closed.store(1, std::memory_order_release);
+    for (ShmRingControl* control : {&_header->parentToChild, &_header->childToParent})
+    {
+        control->dataSequence.fetch_add(1);
+        control->spaceSequence.fetch_add(1);
+#ifdef __linux__
+        FutexWakeAll(&control->dataSequence);
+        FutexWakeAll(&control->spaceSequence);
+#endif
+    }
+}
+
+bool ShmTransport::WaitForChange(std::atomic<uint32_t>& sequence, uint32_t expected, std::atomic<uint32_t>& waiting)
+{
+#ifdef __linux__
+    waiting.fetch_add(1);
+    bool alive = true;
+    while (sequence.load() == expected)
+    {
+        if (_closed)
+        {
+            alive = false;
+            break;
+        }
+
+        timespec timeout = {0, kWaitTimeoutNs};
+        if (FutexWait(&sequence, expected, &timeout) != 0 && errno == ETIMEDOUT && !PeerAlive())
+        {
+            alive = false;
+            break;
+        }
+    }
+    waiting.fetch_sub(1);
+    return alive && !_closed;
+#else
+    (void)sequence;
+    (void)expected;
+    (void)waiting;
+    return false;
+#endif
+}
+
+void ShmTransport::Wake(std::atomic<uint32_t>& sequence, std::atomic<uint32_t>& waiting)
+{
+    sequence.fetch_add(1);
+#ifdef __linux__
+    if (waiting.load() > 0)
+        FutexWakeAll(&sequence);
+#else
+    (void)waiting;
+#endif
+}
+
+bool ShmTransport::PeerAlive()
+{
+#ifdef __linux__
+    if (_livenessReadFd == -1)
+        return true;
+
+    // Once the rings are active nothing is written to the pipe anymore, so any hangup means the peer is gone.
+    pollfd pfd = {_livenessReadFd, POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)))
+    {
+        LOG(INFO) << "Shared memory transport peer hung up.";
+        return false;
+    }
+#endif
+    return true;
+}
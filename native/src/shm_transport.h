@@ -0,0 +1,77 @@
+#ifndef SHM_TRANSPORT_H
+#define SHM_TRANSPORT_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "include/base/cef_logging.h"
+#include "pipe.h"
+
+// Shared-memory byte transport. The controller creates a single memfd region containing one ring per
+// direction and passes it with --ipc-shm next to --parent-to-child/--child-to-parent. Packets keep the
+// exact same IPCPacketHeader framing, the rings only replace the pipe as the byte carrier. Wakeups go
+// through shared futex words and the original pipes stay open to detect the peer exiting.
+//
+// Keep the layout in sync with cpp/ShmTransport.h.
+
+#define SHM_TRANSPORT_MAGIC 0x4A43534D // 'JCSM'
+#define SHM_TRANSPORT_VERSION 1
+
+struct alignas(64) ShmRingControl
+{
+    alignas(64) std::atomic<uint64_t> writePosition;
+    alignas(64) std::atomic<uint64_t> readPosition;
+    alignas(64) std::atomic<uint32_t> dataSequence;
+    std::atomic<uint32_t> spaceSequence;
+    std::atomic<uint32_t> readerWaiting;
+    std::atomic<uint32_t> writerWaiting;
+    std::atomic<uint32_t> closed;
+};
+
+struct alignas(64) ShmTransportHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ringCapacity;
+    uint32_t reserved;
+    ShmRingControl parentToChild;
+    ShmRingControl childToParent;
+};
+
+class ShmTransport
+{
+public:
+    ShmTransport() = default;
+    ~ShmTransport() { Close(); }
+
+    ShmTransport(const ShmTransport&) = delete;
+    ShmTransport& operator=(const ShmTransport&) = delete;
+
+    // Maps the region behind fd. livenessReadFd is the parent-to-child pipe, it is polled while waiting so
+    // a controller exit still unblocks the reader like it would with plain pipes.
+    bool Attach(int fd, int livenessReadFd);
+    bool IsAttached() const { return _header != nullptr; }
+
+    size_t Read(void* buffer, size_t size, bool readFully = false);
+    size_t Write(const void* buffer, size_t size, bool writeFully = false);
+    size_t WriteV(const IOSegment* segments, size_t count);
+    void Close();
+
+private:
+    bool WaitForChange(std::atomic<uint32_t>& sequence, uint32_t expected, std::atomic<uint32_t>& waiting);
+    void Wake(std::atomic<uint32_t>& sequence, std::atomic<uint32_t>& waiting);
+    bool PeerAlive();
+
+    ShmTransportHeader* _header = nullptr;
+    uint8_t* _readRing = nullptr;
+    uint8_t* _writeRing = nullptr;
+    ShmRingControl* _readControl = nullptr;
+    ShmRingControl* _writeControl = nullptr;
+    size_t _mappingSize = 0;
+    size_t _capacity = 0;
+    int _livenessReadFd = -1;
+    std::atomic<bool> _closed = false;
+};
+
+#endif // SHM_TRANSPORT_H
@@ -0,0 +1,50 @@
+#ifndef STREAM_CHUNK_SIZER_H
+#define STREAM_CHUNK_SIZER_H
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+
+// Picks the data size of the next StreamData packet of one stream. Sizes step through the receive buffer pool
+// classes (16 KB, 64 KB, 256 KB, 1 MB) minus the stream id, so a chunk fills its class exactly. A chunk that moves in
+// less than half of kTargetChunkTime takes the size one step up, one slower than twice of it one step down. A producer
+// that hands over less than a chunk pulls the size down to what it delivers, so interactive streams stay small.
+//
+// Keep in sync with cpp/StreamChunkSizer.h.
+class StreamChunkSizer
+{
+public:
+    static constexpr size_t kMinChunkClass = 16 * 1024;
+    static constexpr size_t kMaxChunkClass = 1024 * 1024;
+    static constexpr size_t kInitialChunkClass = 64 * 1024;
+    static constexpr size_t kChunkClassStep = 4;
+    static constexpr std::chrono::microseconds kTargetChunkTime{4000};
+
+    size_t ChunkSize() const { return _chunkClass - sizeof(uint32_t); }
+
+    // bytes took elapsed to go through, from the write or from the credit the receiver returned for them.
+    void RecordTransfer(size_t bytes, std::chrono::steady_clock::duration elapsed)
+    {
+        if (bytes == 0)
+            return;
+
+        // Time a whole chunk of the current size would take at the observed rate.
+        const auto chunkTime = std::chrono::duration_cast<std::chrono::microseconds>(elapsed) * static_cast<int64_t>(_chunkClass) / static_cast<int64_t>(bytes);
+        if (chunkTime * 2 < kTargetChunkTime && _chunkClass < kMaxChunkClass)
+            _chunkClass *= kChunkClassStep;
+        else if (chunkTime > kTargetChunkTime * 2 && _chunkClass > kMinChunkClass)
+            _chunkClass /= kChunkClassStep;
+    }
+
+    // The producer had only bytes ready when a full chunk was asked for.
+    void RecordShortChunk(size_t bytes)
+    {
+        while (_chunkClass > kMinChunkClass && bytes + sizeof(uint32_t) <= _chunkClass / kChunkClassStep)
+            _chunkClass /= kChunkClassStep;
+    }
+
+private:
+    size_t _chunkClass = kInitialChunkClass;
+};
+
+#endif // STREAM_CHUNK_SIZER_H
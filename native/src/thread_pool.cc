@@ -1,73 +1,222 @@
 #include "thread_pool.h"
-#include "ipc.h"
 
-ThreadPool::ThreadPool() : _stop(false)
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+
+thread_local ThreadPool* t_currentPool = nullptr;
+// Index of the current worker's deque, helpers have none.
+thread_local size_t t_queueIndex = SIZE_MAX;
+
+template <typename T> void UpdateMax(std::atomic<T>& target, T value)
+{
+    T current = target.load();
+    while (value > current && !target.compare_exchange_weak(current, value))
+    {
+    }
+}
+
+} // namespace
+
+ThreadPool::BlockingScope::BlockingScope(ThreadPool& pool)
+{
+    if (t_currentPool != &pool)
+        return;
+
+    _pool = &pool;
+    _pool->OnWorkerBlocked();
+}
+
+ThreadPool::BlockingScope::~BlockingScope()
 {
+    if (_pool)
+        _pool->_blockedWorkers--;
 }
+
+ThreadPool::ThreadPool()
+{
+}
+
 ThreadPool::~ThreadPool()
 {
     Stop();
 }
 
-void ThreadPool::AddWorkers(size_t count)
+void ThreadPool::Start(size_t workerCount)
 {
-    for (size_t i = 0; i < count; ++i)
-    {
-        std::thread thread(
-            [this]
-            {
-                for (;;)
-                {
-                    std::function<void()> task;
-
-                    {
-                        std::unique_lock<std::mutex> lock(_queue_mutex);
-                        _condition.wait(lock,
-                                        [this]
-                                        {
-                                            return _stop || !_tasks.empty();
-                                        });
-                        if (_stop && _tasks.empty())
-                            return;
-                        task = std::move(_tasks.front());
-                        _tasks.pop();
-                    }
-
-                    task();
-                }
-            });
-        thread.detach();
-        _workers.emplace_back(std::move(thread));
-    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_queues)
+        return;
+
+    if (workerCount == 0)
+        workerCount = std::max<size_t>(kMinWorkers, std::thread::hardware_concurrency());
+    workerCount = std::min(workerCount, kMaxWorkers);
+
+    _queues.reset(new WorkerQueue[workerCount]);
+    _queueCount = workerCount;
+    for (size_t i = 0; i < workerCount; ++i)
+        StartWorker(i);
+}
+
+void ThreadPool::StartWorker(size_t queueIndex)
+{
+    _workers++;
+    std::thread thread(
+        [this, queueIndex]
+        {
+            t_currentPool = this;
+            WorkerLoop(queueIndex);
+            t_currentPool = nullptr;
+            _workers--;
+        });
+    thread.detach();
 }
 
 bool ThreadPool::Enqueue(std::function<void()> task)
 {
+    if (_stop || !_queues)
+        return false;
+
+    size_t queueIndex = t_currentPool == this ? t_queueIndex : SIZE_MAX;
+    if (queueIndex >= _queueCount)
+        queueIndex = _nextQueue++ % _queueCount;
+
+    size_t queued;
     {
-        std::unique_lock<std::mutex> lock(_queue_mutex);
-        if (_stop)
-            return false;
+        // Counted under the deque lock, so the pop that takes the task always sees it counted.
+        std::lock_guard<std::mutex> lock(_queues[queueIndex].mutex);
+        _queues[queueIndex].tasks.push_back(Task{std::move(task), std::chrono::steady_clock::now()});
+        queued = ++_queuedTasks;
+    }
+    UpdateMax(_peakQueuedTasks, queued);
+
+    // Stop came in after the check above and the workers may already be gone.
+    if (_stop)
+    {
+        Task leftover;
+        while (TryPop(SIZE_MAX, leftover))
+            RunTask(leftover);
+        return true;
+    }
 
-        _tasks.emplace(std::move(task));
+    // Pairs with the idle count a worker raises before it checks the queues and sleeps.
+    if (_idleWorkers.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+        }
+        _condition.notify_one();
     }
-    _condition.notify_one();
     return true;
 }
 
+bool ThreadPool::TryPop(size_t queueIndex, Task& task)
+{
+    if (_queuedTasks.load() == 0)
+        return false;
+
+    // The own deque first, then the oldest task of every other deque in turn.
+    const size_t start = queueIndex < _queueCount ? queueIndex : _nextQueue.load() % _queueCount;
+    for (size_t i = 0; i < _queueCount; ++i)
+    {
+        WorkerQueue& queue = _queues[(start + i) % _queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        _queuedTasks--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::RunTask(Task& task)
+{
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - task.enqueuedAt);
+    const uint64_t latencyUs = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+    _tasksRun++;
+    _totalLatencyUs += latencyUs;
+    UpdateMax(_maxLatencyUs, latencyUs);
+
+    task.function();
+}
+
+void ThreadPool::WorkerLoop(size_t queueIndex)
+{
+    t_queueIndex = queueIndex;
+    const bool helper = queueIndex >= _queueCount;
+
+    for (;;)
+    {
+        Task task;
+        if (TryPop(queueIndex, task))
+        {
+            RunTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        // A task counted after the pop above is picked up before exiting, see Enqueue.
+        if (_stop && _queuedTasks.load() == 0)
+            return;
+
+        _idleWorkers++;
+        if (_stop || _queuedTasks.load() > 0)
+        {
+            _idleWorkers--;
+            continue;
+        }
+
+        if (helper)
+        {
+            if (_condition.wait_for(lock, kHelperIdleTimeout) == std::cv_status::timeout && _queuedTasks.load() == 0)
+            {
+                _idleWorkers--;
+                return;
+            }
+        }
+        else
+            _condition.wait(lock);
+        _idleWorkers--;
+    }
+}
+
+void ThreadPool::OnWorkerBlocked()
+{
+    const size_t blocked = ++_blockedWorkers;
+    const size_t workers = _workers.load();
+    if (_stop || workers >= kMaxWorkers || workers - std::min(blocked, workers) >= _queueCount)
+        return;
+
+    StartWorker(_queueCount);
+}
+
 void ThreadPool::Stop()
 {
     {
-        std::unique_lock<std::mutex> lock(_queue_mutex);
+        std::lock_guard<std::mutex> lock(_mutex);
         if (_stop)
             return;
 
         _stop = true;
     }
     _condition.notify_all();
-    /* do not wait for (std::thread& worker : _workers)
-    {
-        if (worker.joinable()) {
-            worker.join();
-        }
-    }*/
+    // Workers are detached and exit once the queues are drained.
+}
+
+ThreadPool::Stats ThreadPool::GetStats() const
+{
+    Stats stats;
+    stats.workers = _workers.load();
+    stats.blockedWorkers = _blockedWorkers.load();
+    stats.queuedTasks = _queuedTasks.load();
+    stats.peakQueuedTasks = _peakQueuedTasks.load();
+    stats.tasksRun = _tasksRun.load();
+    stats.averageLatencyUs = stats.tasksRun > 0 ? _totalLatencyUs.load() / stats.tasksRun : 0;
+    stats.maxLatencyUs = _maxLatencyUs.load();
+    return stats;
 }
@@ -1,32 +1,102 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
-#include <stdexcept>
 #include <thread>
 #include <vector>
 
+// Work-stealing pool. Every core worker owns a deque: tasks queued from a worker go to its own deque, tasks from
+// other threads are spread round-robin, and a worker that runs dry steals the oldest task of another deque.
+//
+// Handlers often block on a reply from the controller. Such waits are wrapped in a BlockingScope, and while
+// fewer than the core count of workers are runnable the pool starts helper workers. Helpers only steal and exit
+// after kHelperIdleTimeout without work.
 class ThreadPool
 {
 public:
+    struct Stats
+    {
+        size_t workers = 0;
+        size_t blockedWorkers = 0;
+        size_t queuedTasks = 0;
+        size_t peakQueuedTasks = 0;
+        uint64_t tasksRun = 0;
+        uint64_t averageLatencyUs = 0;
+        uint64_t maxLatencyUs = 0;
+    };
+
+    class BlockingScope
+    {
+    public:
+        explicit BlockingScope(ThreadPool& pool);
+        ~BlockingScope();
+
+        BlockingScope(const BlockingScope&) = delete;
+        BlockingScope& operator=(const BlockingScope&) = delete;
+
+    private:
+        ThreadPool* _pool = nullptr;
+    };
+
+    static constexpr size_t kMinWorkers = 4;
+    static constexpr size_t kMaxWorkers = 64;
+    static constexpr std::chrono::seconds kHelperIdleTimeout{5};
+
     ThreadPool();
     ~ThreadPool();
 
-    void AddWorkers(size_t count);
+    // Starts max(kMinWorkers, hardware threads) core workers when workerCount is 0.
+    void Start(size_t workerCount = 0);
+    // Returns false once the pool is stopped, the caller then runs task itself. A task that races Stop is never
+    // dropped: workers only exit with the queues empty and an Enqueue that finds the pool stopped after queueing
+    // runs whatever is left inline.
     bool Enqueue(std::function<void()> task);
 
     void Stop();
 
+    Stats GetStats() const;
+
 private:
-    std::vector<std::thread> _workers;
-    std::queue<std::function<void()>> _tasks;
+    struct Task
+    {
+        std::function<void()> function;
+        std::chrono::steady_clock::time_point enqueuedAt;
+    };
+
+    struct alignas(64) WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void StartWorker(size_t queueIndex);
+    void WorkerLoop(size_t queueIndex);
+    bool TryPop(size_t queueIndex, Task& task);
+    void RunTask(Task& task);
+    void OnWorkerBlocked();
+
+    std::unique_ptr<WorkerQueue[]> _queues;
+    size_t _queueCount = 0;
+    std::atomic<size_t> _nextQueue = 0;
 
-    std::mutex _queue_mutex;
+    std::mutex _mutex;
     std::condition_variable _condition;
-    bool _stop;
+    std::atomic<bool> _stop = false;
+    std::atomic<size_t> _idleWorkers = 0;
+    std::atomic<size_t> _workers = 0;
+    std::atomic<size_t> _blockedWorkers = 0;
+    std::atomic<size_t> _queuedTasks = 0;
+    std::atomic<size_t> _peakQueuedTasks = 0;
+    std::atomic<uint64_t> _tasksRun = 0;
+    std::atomic<uint64_t> _totalLatencyUs = 0;
+    std::atomic<uint64_t> _maxLatencyUs = 0;
 };
 
 #endif // THREAD_POOL_H
@@ -0,0 +1,302 @@
+#include "url_matcher.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+
+struct UrlMatcher::Snapshot
+{
+    struct PrefixNode
+    {
+        // Sorted by character.
+        std::vector<std::pair<char, uint32_t>> children;
+        bool terminal = false;
+        // Globs whose literal head ends at this node.
+        std::vector<uint32_t> globs;
+    };
+
+    struct DomainNode
+    {
+        // Sorted by label.
+        std::vector<std::pair<std::string, uint32_t>> children;
+        bool exact = false;
+        bool subtree = false;
+    };
+
+    std::unordered_set<std::string> exact;
+    std::vector<PrefixNode> prefixNodes = std::vector<PrefixNode>(1);
+    std::vector<std::string> globs;
+    std::vector<DomainNode> domainNodes = std::vector<DomainNode>(1);
+    bool empty = true;
+
+    uint32_t InsertPrefix(std::string_view prefix);
+    void InsertDomain(const std::string& domain);
+    bool MatchesPrefixOrGlob(const std::string& url) const;
+    bool MatchesDomain(std::string_view host) const;
+};
+
+namespace
+{
+
+template <typename Children, typename Key>
+auto FindChild(const Children& children, const Key& key)
+{
+    auto itr = std::lower_bound(children.begin(), children.end(), key, [](const auto& child, const Key& value) { return child.first < value; });
+    return itr != children.end() && itr->first == key ? itr : children.end();
+}
+
+template <typename Nodes, typename Key>
+uint32_t FindOrAddChild(Nodes& nodes, uint32_t node, const Key& key)
+{
+    auto& children = nodes[node].children;
+    auto itr = std::lower_bound(children.begin(), children.end(), key, [](const auto& child, const Key& value) { return child.first < value; });
+    if (itr != children.end() && itr->first == key)
+        return itr->second;
+
+    const uint32_t child = (uint32_t)nodes.size();
+    children.insert(itr, {key, child});
+    nodes.emplace_back();
+    return child;
+}
+
+std::string_view HostFromUrl(std::string_view url)
+{
+    const size_t schemeEnd = url.find("://");
+    if (schemeEnd == std::string_view::npos)
+        return std::string_view();
+
+    const size_t authorityStart = schemeEnd + 3;
+    size_t authorityEnd = url.find_first_of("/?#", authorityStart);
+    if (authorityEnd == std::string_view::npos)
+        authorityEnd = url.size();
+
+    std::string_view authority = url.substr(authorityStart, authorityEnd - authorityStart);
+    const size_t at = authority.rfind('@');
+    if (at != std::string_view::npos)
+        authority.remove_prefix(at + 1);
+
+    if (!authority.empty() && authority[0] == '[')
+    {
+        const size_t close = authority.find(']');
+        return close == std::string_view::npos ? std::string_view() : authority.substr(0, close + 1);
+    }
+    return authority.substr(0, authority.find(':'));
+}
+
+} // namespace
+
+uint32_t UrlMatcher::Snapshot::InsertPrefix(std::string_view prefix)
+{
+    uint32_t node = 0;
+    for (char c : prefix)
+        node = FindOrAddChild(prefixNodes, node, c);
+    return node;
+}
+
+void UrlMatcher::Snapshot::InsertDomain(const std::string& domain)
+{
+    const bool leadingDot = !domain.empty() && domain[0] == '.';
+    const std::string_view host = std::string_view(domain).substr(leadingDot ? 1 : 0);
+    if (host.empty())
+        return;
+
+    uint32_t node = 0;
+    size_t end = host.size();
+    while (true)
+    {
+        const size_t dot = host.rfind('.', end - 1);
+        const size_t start = dot == std::string_view::npos ? 0 : dot + 1;
+        node = FindOrAddChild(domainNodes, node, std::string(host.substr(start, end - start)));
+        if (dot == std::string_view::npos || dot == 0)
+            break;
+        end = dot;
+    }
+
+    if (leadingDot)
+        domainNodes[node].subtree = true;
+    else
+        domainNodes[node].exact = true;
+}
+
+bool UrlMatcher::Snapshot::MatchesPrefixOrGlob(const std::string& url) const
+{
+    uint32_t node = 0;
+    for (size_t i = 0;; i++)
+    {
+        const PrefixNode& current = prefixNodes[node];
+        if (current.terminal)
+            return true;
+        for (uint32_t glob : current.globs)
+        {
+            // The literal head already matched, only the rest of the glob is left to check.
+            const std::string& pattern = globs[glob];
+            if (GlobMatches(pattern.data() + i, pattern.size() - i, url.data() + i, url.size() - i))
+                return true;
+        }
+
+        if (i == url.size())
+            return false;
+        auto child = FindChild(current.children, url[i]);
+        if (child == current.children.end())
+            return false;
+        node = child->second;
+    }
+}
+
+bool UrlMatcher::Snapshot::MatchesDomain(std::string_view host) const
+{
+    if (host.empty() || domainNodes.size() == 1)
+        return false;
+
+    uint32_t node = 0;
+    size_t end = host.size();
+    while (true)
+    {
+        const size_t dot = host.rfind('.', end - 1);
+        const size_t start = dot == std::string_view::npos ? 0 : dot + 1;
+        auto child = FindChild(domainNodes[node].children, host.substr(start, end - start));
+        if (child == domainNodes[node].children.end())
+            return false;
+
+        node = child->second;
+        if (domainNodes[node].subtree)
+            return true;
+        if (dot == std::string_view::npos || dot == 0)
+            return domainNodes[node].exact;
+        end = dot;
+    }
+}
+
+UrlMatcher::UrlMatcher() : _current(new Snapshot())
+{
+}
+
+UrlMatcher::~UrlMatcher()
+{
+    delete _current.load();
+}
+
+bool UrlMatcher::Add(UrlPatternKind kind, const std::string& pattern)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_patterns[(size_t)kind].insert(pattern).second)
+        return false;
+    Publish();
+    return true;
+}
+
+bool UrlMatcher::Remove(UrlPatternKind kind, const std::string& pattern)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_patterns[(size_t)kind].erase(pattern) == 0)
+        return false;
+    Publish();
+    return true;
+}
+
+bool UrlMatcher::AddDomain(const std::string& domain)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_domains.insert(domain).second)
+        return false;
+    Publish();
+    return true;
+}
+
+bool UrlMatcher::RemoveDomain(const std::string& domain)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_domains.erase(domain) == 0)
+        return false;
+    Publish();
+    return true;
+}
+
+bool UrlMatcher::Empty() const
+{
+    Pin pin(*this);
+    return pin.Get()->empty;
+}
+
+bool UrlMatcher::Matches(const std::string& url) const
+{
+    Pin pin(*this);
+    const Snapshot* snapshot = pin.Get();
+    if (snapshot->empty)
+        return false;
+    if (snapshot->exact.find(url) != snapshot->exact.end())
+        return true;
+    if (snapshot->MatchesPrefixOrGlob(url))
+        return true;
+    return snapshot->MatchesDomain(HostFromUrl(url));
+}
+
+bool UrlMatcher::GlobMatches(const char* pattern, size_t patternLength, const char* value, size_t valueLength)
+{
+    // Greedy with backtracking to the last '*', linear for patterns with a single star.
+    size_t p = 0;
+    size_t v = 0;
+    size_t starPattern = std::string::npos;
+    size_t starValue = 0;
+    while (v < valueLength)
+    {
+        if (p < patternLength && (pattern[p] == '?' || (pattern[p] != '*' && pattern[p] == value[v])))
+        {
+            p++;
+            v++;
+        }
+        else if (p < patternLength && pattern[p] == '*')
+        {
+            starPattern = p++;
+            starValue = v;
+        }
+        else if (starPattern != std::string::npos)
+        {
+            p = starPattern + 1;
+            v = ++starValue;
+        }
+        else
+            return false;
+    }
+
+    while (p < patternLength && pattern[p] == '*')
+        p++;
+    return p == patternLength;
+}
+
+void UrlMatcher::Publish()
+{
+    std::unique_ptr<Snapshot> snapshot = std::make_unique<Snapshot>();
+    snapshot->exact.insert(_patterns[(size_t)UrlPatternKind::Exact].begin(), _patterns[(size_t)UrlPatternKind::Exact].end());
+    for (const std::string& prefix : _patterns[(size_t)UrlPatternKind::Prefix])
+        snapshot->prefixNodes[snapshot->InsertPrefix(prefix)].terminal = true;
+    for (const std::string& glob : _patterns[(size_t)UrlPatternKind::Glob])
+    {
+        const uint32_t node = snapshot->InsertPrefix(std::string_view(glob).substr(0, glob.find_first_of("*?")));
+        snapshot->prefixNodes[node].globs.push_back((uint32_t)snapshot->globs.size());
+        snapshot->globs.push_back(glob);
+    }
+    for (const std::string& domain : _domains)
+        snapshot->InsertDomain(domain);
+    snapshot->empty = snapshot->exact.empty() && snapshot->prefixNodes.size() == 1 && !snapshot->prefixNodes[0].terminal &&
+                      snapshot->prefixNodes[0].globs.empty() && snapshot->domainNodes.size() == 1;
+
+    _retired.emplace_back(_current.exchange(snapshot.release()));
+    _hasRetired = true;
+    // A reader that pins after the exchange sees the new snapshot, so with none pinned right now the old ones are free.
+    // Otherwise the last of them to unpin frees them.
+    if (_readers.load() == 0)
+    {
+        _retired.clear();
+        _hasRetired = false;
+    }
+}
+
+void UrlMatcher::Reclaim() const
+{
+    std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || _readers.load() != 0)
+        return;
+    _retired.clear();
+    _hasRetired = false;
+}
@@ -0,0 +1,80 @@
+#ifndef URL_MATCHER_H
+#define URL_MATCHER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Keep in sync with UrlPatternKind in cpp/IpcTypes.h.
+enum class UrlPatternKind : uint8_t
+{
+    Exact = 0,
+    Prefix = 1,
+    // '*' matches any run of characters, '?' exactly one.
+    Glob = 2
+};
+
+// Set of URL rules a window routes on, see Client::GetResourceHandler and Client::OnBeforeResourceLoad. Writers edit
+// the rules under a mutex and compile them into an immutable snapshot: an exact URL set, a prefix trie that also
+// indexes globs by their literal head, and a trie over reversed domain labels. Readers match against the current
+// snapshot without taking a lock, they only pin it with a counter. A replaced snapshot is freed by whichever comes
+// first with no reader pinned: the publishing writer or the last reader to unpin.
+class UrlMatcher
+{
+public:
+    UrlMatcher();
+    ~UrlMatcher();
+
+    UrlMatcher(const UrlMatcher&) = delete;
+    UrlMatcher& operator=(const UrlMatcher&) = delete;
+
+    // Return false when the rule was already present / absent.
+    bool Add(UrlPatternKind kind, const std::string& pattern);
+    bool Remove(UrlPatternKind kind, const std::string& pattern);
+    // "example.com" matches only that host, ".example.com" the host and all its subdomains.
+    bool AddDomain(const std::string& domain);
+    bool RemoveDomain(const std::string& domain);
+
+    bool Empty() const;
+    bool Matches(const std::string& url) const;
+
+    static bool GlobMatches(const char* pattern, size_t patternLength, const char* value, size_t valueLength);
+
+private:
+    struct Snapshot;
+
+    class Pin
+    {
+    public:
+        explicit Pin(const UrlMatcher& matcher) : _matcher(matcher) { _matcher._readers.fetch_add(1); }
+        ~Pin()
+        {
+            if (_matcher._readers.fetch_sub(1) == 1 && _matcher._hasRetired.load())
+                _matcher.Reclaim();
+        }
+        const Snapshot* Get() const { return _matcher._current.load(); }
+
+    private:
+        const UrlMatcher& _matcher;
+    };
+
+    // Requires _mutex.
+    void Publish();
+    // Frees the retired snapshots when no reader is pinned. Never blocks, a busy writer reclaims them itself.
+    void Reclaim() const;
+
+    mutable std::mutex _mutex;
+    std::set<std::string> _patterns[3];
+    std::set<std::string> _domains;
+    std::atomic<const Snapshot*> _current;
+    // Replaced snapshots a reader may still be using, freed once no reader is pinned.
+    mutable std::vector<std::unique_ptr<const Snapshot>> _retired;
+    mutable std::atomic<bool> _hasRetired = false;
+    mutable std::atomic<uint32_t> _readers = 0;
+};
+
+#endif // URL_MATCHER_H